@@ -0,0 +1,422 @@
+#include "kakuro_cpp.h"
+#include <thread>
+
+namespace kakuro {
+
+namespace {
+
+const int MAX_BATCH_ATTEMPTS = 5;
+
+// Runs one batch slot on a fresh board. Returns false if every attempt failed.
+bool generate_one(const FillParams &fill_params,
+                  const TopologyParams &topo_params,
+                  std::pair<int, int> width_range,
+                  std::pair<int, int> height_range, std::mt19937 &rng,
+                  const std::shared_ptr<GenerationBudget> &budget,
+                  GeneratedPuzzle &out) {
+  std::uniform_int_distribution<int> dist_w(width_range.first,
+                                            width_range.second);
+  std::uniform_int_distribution<int> dist_h(height_range.first,
+                                            height_range.second);
+
+  GenerationStats stats;
+  for (int attempt = 0; attempt < MAX_BATCH_ATTEMPTS; attempt++) {
+    if (budget && budget->expired())
+      break;
+    auto board = std::make_shared<KakuroBoard>(dist_w(rng), dist_h(rng));
+    board->rng.seed(rng());
+    CSPSolver solver(board);
+    solver.rng.seed(rng());
+    solver.set_budget(budget);
+
+    bool ok = solver.generate_puzzle(fill_params, topo_params);
+    stats.merge(solver.last_stats());
+    stats.total_ms += solver.last_stats().total_ms;
+    if (!ok)
+      continue;
+
+    out = make_generated_puzzle(*board, solver.last_difficulty());
+    out.stats = stats;
+    return true;
+  }
+  return false;
+}
+
+// Types and clues from the planes. Returns false if they do not describe a
+// board with a clue for every run.
+bool board_from_planes(const GridPlanes &planes, KakuroBoard &board) {
+  for (int r = 0; r < planes.height; r++) {
+    for (int c = 0; c < planes.width; c++) {
+      Cell &cell = board.grid[r][c];
+      uint8_t type = planes.at(GridPlanes::TYPE, r, c);
+      if (type == GridPlanes::TYPE_WHITE) {
+        cell.type = CellType::WHITE;
+        continue;
+      }
+      if (type != GridPlanes::TYPE_BLOCK)
+        return false;
+      cell.type = CellType::BLOCK;
+      if (uint8_t h = planes.at(GridPlanes::CLUE_H, r, c))
+        cell.clue_h = h;
+      if (uint8_t v = planes.at(GridPlanes::CLUE_V, r, c))
+        cell.clue_v = v;
+    }
+  }
+  board.collect_white_cells();
+  board.identify_sectors();
+  if (board.white_cells.empty() || !board.validate_clue_headers())
+    return false;
+  for (int id = 0; id < board.sectors_h.capacity(); id++) {
+    if (board.sectors_h.length(id) && !board.sectors_h.clue_cell(id)->clue_h)
+      return false;
+  }
+  for (int id = 0; id < board.sectors_v.capacity(); id++) {
+    if (board.sectors_v.length(id) && !board.sectors_v.clue_cell(id)->clue_v)
+      return false;
+  }
+  return true;
+}
+
+void solve_one(const GridPlanes &planes, SolveMode mode, int max_solutions,
+               int max_nodes, const std::shared_ptr<GenerationBudget> &budget,
+               SolveResult &out) {
+  int w = planes.width, h = planes.height;
+  if (w < 1 || h < 1 || w > KakuroBoard::MAX_DIMENSION ||
+      h > KakuroBoard::MAX_DIMENSION ||
+      planes.data.size() != (size_t)GridPlanes::PLANE_COUNT * w * h)
+    return;
+  auto board = std::make_shared<KakuroBoard>(w, h, 0);
+  if (!board_from_planes(planes, *board))
+    return;
+  out.valid = true;
+
+  int limit = mode == SolveMode::SOLVE    ? 1
+              : mode == SolveMode::VERIFY ? 2
+                                          : std::max(1, max_solutions);
+  HybridUniquenessChecker checker(board);
+  checker.set_budget(budget);
+  std::vector<std::unordered_map<std::pair<int, int>, int, PairHash>> solutions;
+  out.exhausted = !checker.solve_clues(limit, max_nodes, solutions);
+  out.nodes = checker.last_node_count();
+  out.solution_count = (int)solutions.size();
+  if (solutions.empty())
+    return;
+
+  out.solution.assign((size_t)w * h, 0);
+  for (const auto &[coords, digit] : solutions[0])
+    out.solution[(size_t)coords.first * w + coords.second] = (uint8_t)digit;
+
+  if (mode != SolveMode::VERIFY || out.solution_count != 1 || out.exhausted)
+    return;
+  out.checked = true;
+  out.solved = true;
+  for (Cell *c : board->white_cells) {
+    uint8_t entry = planes.at(GridPlanes::SOLUTION, c->r, c->c);
+    uint8_t digit = out.solution[(size_t)c->r * w + c->c];
+    if (entry != digit)
+      out.solved = false;
+    if (entry && entry != digit)
+      out.wrong_cells.push_back({c->r, c->c});
+  }
+}
+
+// Orders the size ranges and switches off targets below 3x3
+void normalize_targets(std::vector<StreamTarget> &targets) {
+  for (StreamTarget &t : targets) {
+    if (t.width_range.first > t.width_range.second)
+      std::swap(t.width_range.first, t.width_range.second);
+    if (t.height_range.first > t.height_range.second)
+      std::swap(t.height_range.first, t.height_range.second);
+    if (t.weight > 0 && (t.width_range.first < 3 || t.height_range.first < 3)) {
+      LOG_ERROR("PuzzleStream: board size must be at least 3x3, ignoring the "
+                << t.fill_params.difficulty << " target");
+      t.weight = 0;
+    }
+  }
+}
+
+} // namespace
+
+std::vector<GeneratedPuzzle>
+generate_batch(int count, std::pair<int, int> width_range,
+               std::pair<int, int> height_range,
+               const FillParams &fill_params,
+               const TopologyParams &topo_params, int threads,
+               std::shared_ptr<GenerationBudget> budget) {
+  if (count <= 0)
+    return {};
+  if (width_range.first > width_range.second)
+    std::swap(width_range.first, width_range.second);
+  if (height_range.first > height_range.second)
+    std::swap(height_range.first, height_range.second);
+  if (width_range.first < 3 || height_range.first < 3) {
+    LOG_ERROR("generate_batch: board size must be at least 3x3");
+    return {};
+  }
+
+  if (threads <= 0)
+    threads = (int)std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min(threads, count);
+
+  // Slots are written independently; only successful ones are returned
+  std::vector<GeneratedPuzzle> slots(count);
+  std::vector<char> ok(count, 0);
+  std::atomic<int> next_slot{0};
+
+  // Per-worker seeds come from one source so workers never share a generator
+  std::vector<uint32_t> seeds(threads);
+  {
+    std::random_device rd;
+    for (auto &s : seeds)
+      s = rd();
+  }
+
+  auto worker = [&](int worker_id) {
+    std::mt19937 rng(seeds[worker_id]);
+    for (int i = next_slot++; i < count; i = next_slot++) {
+      if (budget && budget->expired())
+        return;
+      ok[i] = generate_one(fill_params, topo_params, width_range, height_range,
+                           rng, budget, slots[i]);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (int t = 1; t < threads; t++)
+    pool.emplace_back(worker, t);
+  worker(0);
+  for (auto &t : pool)
+    t.join();
+
+  std::vector<GeneratedPuzzle> result;
+  result.reserve(count);
+  for (int i = 0; i < count; i++) {
+    if (ok[i])
+      result.push_back(std::move(slots[i]));
+  }
+  if ((int)result.size() < count) {
+    LOG_DEBUG("generate_batch: " << result.size() << "/" << count
+                                 << " puzzles generated");
+  }
+  return result;
+}
+
+PuzzleStream::PuzzleStream(std::vector<StreamTarget> targets, int capacity,
+                           int threads)
+    : capacity_(std::max(1, capacity)),
+      threads_(threads > 0
+                   ? threads
+                   : (int)std::max(1u, std::thread::hardware_concurrency())),
+      targets_(std::move(targets)) {
+  normalize_targets(targets_);
+}
+
+PuzzleStream::~PuzzleStream() { stop(); }
+
+void PuzzleStream::start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_)
+    return;
+  running_ = true;
+  budget_ = GenerationBudget::create();
+  std::random_device rd;
+  for (int i = 0; i < threads_; i++)
+    producers_.emplace_back(&PuzzleStream::produce, this, rd());
+}
+
+void PuzzleStream::stop() {
+  std::vector<std::thread> producers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_)
+      return;
+    running_ = false;
+    budget_->cancel(); // Ends the puzzles in progress
+    producers.swap(producers_);
+  }
+  space_.notify_all();
+  ready_.notify_all();
+  for (auto &t : producers)
+    t.join();
+}
+
+bool PuzzleStream::running() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return running_;
+}
+
+void PuzzleStream::set_targets(std::vector<StreamTarget> targets) {
+  normalize_targets(targets);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    targets_ = std::move(targets);
+  }
+  space_.notify_all();
+}
+
+void PuzzleStream::set_on_ready(ReadyCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  on_ready_ = std::move(callback);
+}
+
+bool PuzzleStream::pop(StreamedPuzzle &out, int timeout_ms,
+                       const std::string &difficulty) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto match = queue_.end();
+  auto has_puzzle = [&] {
+    match = std::find_if(queue_.begin(), queue_.end(),
+                         [&](const StreamedPuzzle &p) {
+                           return difficulty.empty() ||
+                                  p.difficulty == difficulty;
+                         });
+    return match != queue_.end() || !running_;
+  };
+  if (timeout_ms < 0)
+    ready_.wait(lock, has_puzzle);
+  else if (!ready_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                            has_puzzle))
+    return false;
+  if (match == queue_.end())
+    return false; // Stopped
+  out = std::move(*match);
+  queue_.erase(match);
+  lock.unlock();
+  space_.notify_all();
+  return true;
+}
+
+size_t PuzzleStream::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.size();
+}
+
+size_t PuzzleStream::size(const std::string &difficulty) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::count_if(
+      queue_.begin(), queue_.end(),
+      [&](const StreamedPuzzle &p) { return p.difficulty == difficulty; });
+}
+
+long long PuzzleStream::produced() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return produced_;
+}
+
+long long PuzzleStream::failed() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return failed_;
+}
+
+int PuzzleStream::pending(const std::string &difficulty) const {
+  int n = (int)std::count(in_progress_.begin(), in_progress_.end(), difficulty);
+  for (const StreamedPuzzle &p : queue_)
+    n += p.difficulty == difficulty;
+  return n;
+}
+
+int PuzzleStream::pick_target(std::mt19937 &rng) const {
+  std::vector<char> open(targets_.size(), 0);
+  double total = 0;
+  for (size_t i = 0; i < targets_.size(); i++) {
+    const StreamTarget &t = targets_[i];
+    open[i] = t.weight > 0 &&
+              (t.max_queued <= 0 ||
+               pending(t.fill_params.difficulty) < t.max_queued);
+    if (open[i])
+      total += t.weight;
+  }
+  if (total <= 0)
+    return -1;
+  double x = std::uniform_real_distribution<double>(0, total)(rng);
+  int last = -1;
+  for (int i = 0; i < (int)targets_.size(); i++) {
+    if (!open[i])
+      continue;
+    last = i;
+    x -= targets_[i].weight;
+    if (x < 0)
+      break;
+  }
+  return last;
+}
+
+void PuzzleStream::produce(uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    int index = pick_target(rng);
+    if (index < 0 ||
+        (int)(queue_.size() + in_progress_.size()) >= capacity_) {
+      space_.wait(lock);
+      continue;
+    }
+    StreamTarget target = targets_[index];
+    std::shared_ptr<GenerationBudget> budget = budget_;
+    in_progress_.push_back(target.fill_params.difficulty);
+    lock.unlock();
+
+    StreamedPuzzle item{target.fill_params.difficulty, GeneratedPuzzle()};
+    bool ok = generate_one(target.fill_params, target.topo_params,
+                           target.width_range, target.height_range, rng,
+                           budget, item.puzzle);
+
+    lock.lock();
+    in_progress_.erase(std::find(in_progress_.begin(), in_progress_.end(),
+                                 item.difficulty));
+    if (!running_)
+      break;
+    if (!ok) {
+      failed_++;
+      continue;
+    }
+    queue_.push_back(std::move(item));
+    produced_++;
+    // Consumers may wait for different difficulties
+    ready_.notify_all();
+    if (on_ready_) {
+      ReadyCallback callback = on_ready_;
+      size_t queued = queue_.size();
+      lock.unlock();
+      callback(target.fill_params.difficulty, queued);
+      lock.lock();
+    }
+  }
+}
+
+std::vector<SolveResult>
+solve_many(const std::vector<GridPlanes> &puzzles, SolveMode mode,
+           int max_solutions, int threads, int max_nodes,
+           std::shared_ptr<GenerationBudget> budget) {
+  int count = (int)puzzles.size();
+  std::vector<SolveResult> results(count);
+  if (count == 0)
+    return results;
+
+  if (threads <= 0)
+    threads = (int)std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min(threads, count);
+
+  std::atomic<int> next{0};
+  auto worker = [&]() {
+    for (int i = next++; i < count; i = next++) {
+      if (budget && budget->expired()) {
+        results[i].exhausted = true;
+        continue;
+      }
+      solve_one(puzzles[i], mode, max_solutions, max_nodes, budget,
+                results[i]);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (int t = 1; t < threads; t++)
+    pool.emplace_back(worker);
+  worker();
+  for (auto &t : pool)
+    t.join();
+  return results;
+}
+
+} // namespace kakuro
@@ -0,0 +1,260 @@
+// Reproducible end-to-end generation benchmark.
+//
+// Generates a fixed, seeded corpus per difficulty and board size and reports
+// throughput, latency percentiles and per-stage time as JSON.
+//
+//   kakuro_bench [--seeds N] [--base-seed S] [--difficulties a,b,...]
+//                [--sizes 8,10,...] [--time-limit SEC] [--out FILE]
+//                [--log-level off|stage|full]
+//
+// Without --sizes each difficulty uses the bounds of its production size
+// range. Generation logs are off unless --log-level turns them on, so the
+// timings leave out log I/O. JSON goes to stdout (or FILE); a summary table
+// goes to stderr.
+
+#include "kakuro_cpp.h"
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+
+namespace {
+
+struct BenchConfig {
+  int seeds = 5;
+  uint32_t base_seed = 1;
+  std::vector<std::string> difficulties = {"very_easy", "easy", "medium",
+                                           "hard"};
+  std::vector<int> sizes; // Empty = per-difficulty defaults
+  double time_limit = 60.0;
+  std::string out_path;
+  kakuro::LogLevel log_level = kakuro::LogLevel::OFF;
+};
+
+struct BenchGroup {
+  std::string difficulty;
+  int size = 0;
+  int runs = 0;
+  int succeeded = 0;
+  double wall_ms = 0;
+  std::vector<double> latencies_ms;
+  kakuro::GenerationStats stages;
+};
+
+// Mirrors DIFFICULTY_SIZE_RANGES in main.py
+std::vector<int> default_sizes(const std::string &difficulty) {
+  if (difficulty == "very_easy")
+    return {6, 9};
+  if (difficulty == "easy")
+    return {8, 10};
+  if (difficulty == "hard")
+    return {12, 14};
+  return {10, 12};
+}
+
+std::vector<std::string> split(const std::string &s) {
+  std::vector<std::string> parts;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, ','))
+    if (!item.empty())
+      parts.push_back(item);
+  return parts;
+}
+
+bool parse_args(int argc, char **argv, BenchConfig &cfg) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return false;
+    }
+    std::string val = argv[++i];
+    if (arg == "--seeds")
+      cfg.seeds = std::atoi(val.c_str());
+    else if (arg == "--base-seed")
+      cfg.base_seed = (uint32_t)std::strtoul(val.c_str(), nullptr, 10);
+    else if (arg == "--difficulties")
+      cfg.difficulties = split(val);
+    else if (arg == "--sizes") {
+      cfg.sizes.clear();
+      for (const auto &s : split(val))
+        cfg.sizes.push_back(std::atoi(s.c_str()));
+    } else if (arg == "--time-limit")
+      cfg.time_limit = std::atof(val.c_str());
+    else if (arg == "--out")
+      cfg.out_path = val;
+    else if (arg == "--log-level") {
+      if (val == "off")
+        cfg.log_level = kakuro::LogLevel::OFF;
+      else if (val == "stage")
+        cfg.log_level = kakuro::LogLevel::STAGE;
+      else if (val == "full")
+        cfg.log_level = kakuro::LogLevel::FULL;
+      else {
+        std::cerr << "Unknown log level " << val << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Unknown option " << arg << std::endl;
+      return false;
+    }
+  }
+  return cfg.seeds > 0;
+}
+
+// Nearest-rank percentile of an ascending sample
+double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+  return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+void write_stages(std::ostream &os, const kakuro::GenerationStats &st,
+                  int runs) {
+  double n = std::max(1, runs);
+  os << "\"stages_ms\":{"
+     << "\"topology\":" << st.topology_ms / n << ","
+     << "\"fill\":" << st.fill_ms / n << ","
+     << "\"prefilter\":" << st.prefilter_ms / n << ","
+     << "\"uniqueness\":" << st.uniqueness_ms / n << ","
+     << "\"difficulty\":" << st.difficulty_ms / n << ","
+     << "\"repair\":" << st.repair_ms / n << "},"
+     << "\"retries\":{"
+     << "\"topology_attempts\":" << st.topology_attempts / n << ","
+     << "\"fill_attempts\":" << st.fill_attempts / n << ","
+     << "\"repairs\":" << st.repairs / n << "},"
+     << "\"rejections\":{"
+     << "\"failed_fills\":" << st.failed_fills / n << ","
+     << "\"ambiguity\":" << st.rejected_ambiguity / n << ","
+     << "\"tier\":" << st.rejected_tier / n << ","
+     << "\"refuted\":" << st.rejected_refuted / n << ","
+     << "\"multiple\":" << st.rejected_multiple / n << ","
+     << "\"inconclusive\":" << st.rejected_inconclusive / n << ","
+     << "\"estimator\":" << st.rejected_estimator / n << "},"
+     << "\"nodes\":{"
+     << "\"fill\":" << st.fill_nodes / n << ","
+     << "\"prefilter\":" << st.prefilter_nodes / n << ","
+     << "\"uniqueness\":" << st.uniqueness_nodes / n << ","
+     << "\"estimator\":" << st.estimator_nodes / n << "},";
+
+  // Share of the fills reaching each stage that the stage rejected
+  const std::pair<const char *, int> stages[] = {
+      {"failed_fills", st.failed_fills},
+      {"ambiguity", st.rejected_ambiguity},
+      {"tier", st.rejected_tier},
+      {"refuted", st.rejected_refuted},
+      {"uniqueness", st.rejected_multiple + st.rejected_inconclusive},
+      {"estimator", st.rejected_estimator}};
+  double reaching = st.fill_attempts;
+  os << "\"rejection_rates\":{";
+  for (size_t i = 0; i < std::size(stages); i++) {
+    os << (i ? "," : "") << "\"" << stages[i].first
+       << "\":" << (reaching > 0 ? stages[i].second / reaching : 0);
+    reaching -= stages[i].second;
+  }
+  os << "}";
+}
+
+void write_group(std::ostream &os, const BenchGroup &g) {
+  std::vector<double> sorted = g.latencies_ms;
+  std::sort(sorted.begin(), sorted.end());
+  double mean = sorted.empty() ? 0
+                               : std::accumulate(sorted.begin(), sorted.end(),
+                                                 0.0) /
+                                     sorted.size();
+  os << "{\"difficulty\":\"" << g.difficulty << "\","
+     << "\"width\":" << g.size << ",\"height\":" << g.size << ","
+     << "\"runs\":" << g.runs << ",\"succeeded\":" << g.succeeded << ","
+     << "\"throughput_per_s\":"
+     << (g.wall_ms > 0 ? g.succeeded * 1000.0 / g.wall_ms : 0) << ","
+     << "\"latency_ms\":{"
+     << "\"mean\":" << mean << ","
+     << "\"p50\":" << percentile(sorted, 50) << ","
+     << "\"p95\":" << percentile(sorted, 95) << ","
+     << "\"p99\":" << percentile(sorted, 99) << ","
+     << "\"max\":" << (sorted.empty() ? 0 : sorted.back()) << "},";
+  write_stages(os, g.stages, g.runs);
+  os << "}";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  BenchConfig cfg;
+  if (!parse_args(argc, argv, cfg)) {
+    std::cerr << "usage: kakuro_bench [--seeds N] [--base-seed S] "
+                 "[--difficulties a,b] [--sizes 8,10] [--time-limit SEC] "
+                 "[--out FILE] [--log-level off|stage|full]"
+              << std::endl;
+    return 2;
+  }
+  kakuro::GenerationLogger::configure(cfg.log_level);
+
+  std::vector<BenchGroup> groups;
+  for (const auto &difficulty : cfg.difficulties) {
+    for (int size : cfg.sizes.empty() ? default_sizes(difficulty) : cfg.sizes) {
+      BenchGroup g;
+      g.difficulty = difficulty;
+      g.size = size;
+
+      auto group_start = std::chrono::steady_clock::now();
+      for (int i = 0; i < cfg.seeds; i++) {
+        // Board and solver seeds depend only on the corpus position
+        uint32_t seed = cfg.base_seed + (uint32_t)i;
+        auto board = std::make_shared<kakuro::KakuroBoard>(size, size, seed);
+        kakuro::CSPSolver solver(board, seed ^ 0x9E3779B9u);
+        solver.set_time_limit(cfg.time_limit);
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = solver.generate_puzzle(difficulty);
+        double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+        g.runs++;
+        g.stages.merge(solver.last_stats());
+        if (ok) {
+          g.succeeded++;
+          g.latencies_ms.push_back(ms);
+        }
+      }
+      g.wall_ms = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - group_start)
+                      .count();
+
+      std::vector<double> sorted = g.latencies_ms;
+      std::sort(sorted.begin(), sorted.end());
+      fprintf(stderr, "%-10s %2dx%-2d  ok %d/%d  p50 %8.1f ms  p95 %8.1f ms  "
+                      "p99 %8.1f ms\n",
+              difficulty.c_str(), size, size, g.succeeded, g.runs,
+              percentile(sorted, 50), percentile(sorted, 95),
+              percentile(sorted, 99));
+      groups.push_back(std::move(g));
+    }
+  }
+
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(3);
+  os << "{\"config\":{\"seeds\":" << cfg.seeds
+     << ",\"base_seed\":" << cfg.base_seed
+     << ",\"time_limit_s\":" << cfg.time_limit << "},\"results\":[";
+  for (size_t i = 0; i < groups.size(); i++) {
+    if (i)
+      os << ",";
+    write_group(os, groups[i]);
+  }
+  os << "]}\n";
+
+  if (cfg.out_path.empty()) {
+    std::cout << os.str();
+  } else {
+    std::ofstream out(cfg.out_path);
+    if (!out) {
+      std::cerr << "Cannot write " << cfg.out_path << std::endl;
+      return 1;
+    }
+    out << os.str();
+  }
+  return 0;
+}
@@ -23,6 +23,15 @@ PYBIND11_MODULE(kakuro_cpp, m) {
         .value("EXTREME", kakuro::TechniqueTier::EXTREME)
         .export_values();
 
+    py::enum_<kakuro::LogLevel>(m, "LogLevel")
+        .value("OFF", kakuro::LogLevel::OFF)
+        .value("STAGE", kakuro::LogLevel::STAGE)
+        .value("FULL", kakuro::LogLevel::FULL);
+
+    py::enum_<kakuro::LogOverflow>(m, "LogOverflow")
+        .value("DROP", kakuro::LogOverflow::DROP)
+        .value("BLOCK", kakuro::LogOverflow::BLOCK);
+
     // Bind TopologyParams struct
     py::class_<kakuro::TopologyParams>(m, "TopologyParams")
         .def(py::init<>())
@@ -117,8 +126,39 @@ PYBIND11_MODULE(kakuro_cpp, m) {
         });
 
     // Bind KakuroBoard class
+    // numpy.asarray(planes) views the buffer as uint8[4][height][width]
+    py::class_<kakuro::GridPlanes>(m, "GridPlanes", py::buffer_protocol())
+        // From any uint8[4][height][width] buffer, e.g. a numpy array
+        .def(py::init([](py::buffer b) {
+            py::buffer_info info = b.request();
+            if (info.format != py::format_descriptor<uint8_t>::format() || info.ndim != 3 ||
+                info.shape[0] != kakuro::GridPlanes::PLANE_COUNT)
+                throw py::value_error("GridPlanes expects a uint8 buffer of shape (4, height, width)");
+            kakuro::GridPlanes p((int)info.shape[2], (int)info.shape[1]);
+            const uint8_t* base = (const uint8_t*)info.ptr;
+            for (py::ssize_t k = 0; k < info.shape[0]; k++)
+                for (py::ssize_t r = 0; r < info.shape[1]; r++)
+                    for (py::ssize_t c = 0; c < info.shape[2]; c++)
+                        p.at((kakuro::GridPlanes::Plane)k, (int)r, (int)c) =
+                            base[k * info.strides[0] + r * info.strides[1] + c * info.strides[2]];
+            return p;
+        }), py::arg("buffer"))
+        .def_readonly("width", &kakuro::GridPlanes::width)
+        .def_readonly("height", &kakuro::GridPlanes::height)
+        .def_property_readonly_static("PLANES", [](py::object) {
+            return std::vector<std::string>{"type", "clue_h", "clue_v", "solution"};
+        })
+        .def_buffer([](kakuro::GridPlanes &p) -> py::buffer_info {
+            const py::ssize_t w = p.width, h = p.height;
+            return py::buffer_info(
+                p.data.data(), sizeof(uint8_t), py::format_descriptor<uint8_t>::format(), 3,
+                {(py::ssize_t)kakuro::GridPlanes::PLANE_COUNT, h, w},
+                {h * w, w, (py::ssize_t)1});
+        });
+
     py::class_<kakuro::KakuroBoard, std::shared_ptr<kakuro::KakuroBoard>>(m, "KakuroBoard")
         .def(py::init<int, int>())
+        .def(py::init<int, int, uint32_t>(), py::arg("w"), py::arg("h"), py::arg("seed"))
         .def_readwrite("width", &kakuro::KakuroBoard::width)
         .def_readwrite("height", &kakuro::KakuroBoard::height)
         .def("get_cell", &kakuro::KakuroBoard::get_cell,
@@ -126,6 +166,8 @@ PYBIND11_MODULE(kakuro_cpp, m) {
         .def("reset_values", &kakuro::KakuroBoard::reset_values)
         .def("set_block", &kakuro::KakuroBoard::set_block)
         .def("set_white", &kakuro::KakuroBoard::set_white)
+        // Call after assigning Cell.type directly
+        .def("sync_white_bits", &kakuro::KakuroBoard::sync_white_bits)
         
         // New parameter-driven overload
         .def("generate_topology", 
@@ -144,29 +186,26 @@ PYBIND11_MODULE(kakuro_cpp, m) {
         .def("collect_white_cells", &kakuro::KakuroBoard::collect_white_cells)
         .def("identify_sectors", &kakuro::KakuroBoard::identify_sectors)
         .def("to_dict", &kakuro::KakuroBoard::to_dict)
+        .def("to_planes", [](const kakuro::KakuroBoard& b) { return kakuro::export_planes(b); })
+        .def("to_json", [](const kakuro::KakuroBoard& b) { return kakuro::grid_to_json(b); },
+             "Grid in the to_dict layout, serialized natively")
         .def_property_readonly("white_cells",
             [](const kakuro::KakuroBoard& b) {
                 return b.white_cells;
             })
         .def_property_readonly("sectors_h", [](const kakuro::KakuroBoard& b) {
-                // Convert vector<shared_ptr<vector<Cell*>>> 
-                // to vector<vector<Cell*>> for Python
+                // Copy the sector table into vector<vector<Cell*>> for Python
                 std::vector<std::vector<kakuro::Cell*>> result;
-                for (const auto& sector_ptr : b.sectors_h) {
-                    if (sector_ptr) {
-                        result.push_back(*sector_ptr); // Dereference shared_ptr to copy vector
-                    }
+                for (kakuro::SectorSpan sector : b.sectors_h) {
+                    result.emplace_back(sector.begin(), sector.end());
                 }
                 return result; // Pybind11 converts this to list of lists of Cells automatically
             })
         .def_property_readonly("sectors_v", [](const kakuro::KakuroBoard& b) {
-                // Convert vector<shared_ptr<vector<Cell*>>> 
-                // to vector<vector<Cell*>> for Python
+                // Copy the sector table into vector<vector<Cell*>> for Python
                 std::vector<std::vector<kakuro::Cell*>> result;
-                for (const auto& sector_ptr : b.sectors_v) {
-                    if (sector_ptr) {
-                        result.push_back(*sector_ptr); // Dereference shared_ptr to copy vector
-                    }
+                for (kakuro::SectorSpan sector : b.sectors_v) {
+                    result.emplace_back(sector.begin(), sector.end());
                 }
                 return result; // Pybind11 converts this to list of lists of Cells automatically
             })
@@ -186,22 +225,106 @@ PYBIND11_MODULE(kakuro_cpp, m) {
             return result;
         });
 
+    py::class_<kakuro::GenerationBudget, std::shared_ptr<kakuro::GenerationBudget>>(m, "GenerationBudget")
+        .def(py::init(&kakuro::GenerationBudget::create),
+             py::arg("seconds") = 0.0,
+             "Deadline (seconds <= 0: none) and cancellation shared by a generation request")
+        .def("cancel", &kakuro::GenerationBudget::cancel)
+        .def("set_deadline", &kakuro::GenerationBudget::set_deadline, py::arg("seconds"))
+        .def("is_cancelled", &kakuro::GenerationBudget::is_cancelled)
+        .def("expired", &kakuro::GenerationBudget::expired)
+        .def("remaining_sec", &kakuro::GenerationBudget::remaining_sec)
+        .def("child", &kakuro::GenerationBudget::child, py::arg("max_seconds") = 0.0)
+        .def("child_fraction", &kakuro::GenerationBudget::child_fraction, py::arg("fraction"));
+
+    py::class_<kakuro::GenerationStats>(m, "GenerationStats")
+        .def(py::init<>())
+        .def_readonly("topology_attempts", &kakuro::GenerationStats::topology_attempts)
+        .def_readonly("pooled_topologies", &kakuro::GenerationStats::pooled_topologies)
+        .def_readonly("fill_attempts", &kakuro::GenerationStats::fill_attempts)
+        .def_readonly("repairs", &kakuro::GenerationStats::repairs)
+        .def_readonly("failed_fills", &kakuro::GenerationStats::failed_fills)
+        .def_readonly("rejected_ambiguity", &kakuro::GenerationStats::rejected_ambiguity)
+        .def_readonly("rejected_tier", &kakuro::GenerationStats::rejected_tier)
+        .def_readonly("rejected_refuted", &kakuro::GenerationStats::rejected_refuted)
+        .def_readonly("rejected_multiple", &kakuro::GenerationStats::rejected_multiple)
+        .def_readonly("rejected_inconclusive", &kakuro::GenerationStats::rejected_inconclusive)
+        .def_readonly("rejected_estimator", &kakuro::GenerationStats::rejected_estimator)
+        .def_readonly("fill_nodes", &kakuro::GenerationStats::fill_nodes)
+        .def_readonly("prefilter_nodes", &kakuro::GenerationStats::prefilter_nodes)
+        .def_readonly("uniqueness_nodes", &kakuro::GenerationStats::uniqueness_nodes)
+        .def_readonly("estimator_nodes", &kakuro::GenerationStats::estimator_nodes)
+        .def_readonly("topology_ms", &kakuro::GenerationStats::topology_ms)
+        .def_readonly("fill_ms", &kakuro::GenerationStats::fill_ms)
+        .def_readonly("prefilter_ms", &kakuro::GenerationStats::prefilter_ms)
+        .def_readonly("uniqueness_ms", &kakuro::GenerationStats::uniqueness_ms)
+        .def_readonly("difficulty_ms", &kakuro::GenerationStats::difficulty_ms)
+        .def_readonly("repair_ms", &kakuro::GenerationStats::repair_ms)
+        .def_readonly("total_ms", &kakuro::GenerationStats::total_ms)
+        .def("to_dict", [](const kakuro::GenerationStats &st) {
+            py::dict d;
+            d["topology_attempts"] = st.topology_attempts;
+            d["pooled_topologies"] = st.pooled_topologies;
+            d["fill_attempts"] = st.fill_attempts;
+            d["repairs"] = st.repairs;
+            d["failed_fills"] = st.failed_fills;
+            d["rejected_ambiguity"] = st.rejected_ambiguity;
+            d["rejected_tier"] = st.rejected_tier;
+            d["rejected_refuted"] = st.rejected_refuted;
+            d["rejected_multiple"] = st.rejected_multiple;
+            d["rejected_inconclusive"] = st.rejected_inconclusive;
+            d["rejected_estimator"] = st.rejected_estimator;
+            d["fill_nodes"] = st.fill_nodes;
+            d["prefilter_nodes"] = st.prefilter_nodes;
+            d["uniqueness_nodes"] = st.uniqueness_nodes;
+            d["estimator_nodes"] = st.estimator_nodes;
+            d["topology_ms"] = st.topology_ms;
+            d["fill_ms"] = st.fill_ms;
+            d["prefilter_ms"] = st.prefilter_ms;
+            d["uniqueness_ms"] = st.uniqueness_ms;
+            d["difficulty_ms"] = st.difficulty_ms;
+            d["repair_ms"] = st.repair_ms;
+            d["total_ms"] = st.total_ms;
+            return d;
+        });
+
     py::class_<kakuro::CSPSolver::ValueConstraint>(m, "ValueConstraint")
         .def(py::init<>())
         .def_readwrite("cell", &kakuro::CSPSolver::ValueConstraint::cell)
         .def_readwrite("values", &kakuro::CSPSolver::ValueConstraint::values);
 
+    py::class_<kakuro::TopologyPool, std::shared_ptr<kakuro::TopologyPool>>(m, "TopologyPool")
+        .def(py::init<int>(), py::arg("per_key") = 4)
+        .def("start", &kakuro::TopologyPool::start)
+        .def("stop", &kakuro::TopologyPool::stop,
+             py::call_guard<py::gil_scoped_release>())
+        .def("ready", &kakuro::TopologyPool::ready,
+             py::arg("width"), py::arg("height"),
+             py::arg("topo_params") = kakuro::TopologyParams());
+
     // Bind CSPSolver class
     py::class_<kakuro::CSPSolver>(m, "CSPSolver")
         .def(py::init<std::shared_ptr<kakuro::KakuroBoard>>())
+        .def(py::init<std::shared_ptr<kakuro::KakuroBoard>, uint32_t>(),
+             py::arg("board"), py::arg("seed"))
+        // The validating DifficultyResult on success (truthy), None otherwise
         .def("generate_puzzle", 
-             static_cast<bool (kakuro::CSPSolver::*)(const kakuro::FillParams&, const kakuro::TopologyParams&)>(&kakuro::CSPSolver::generate_puzzle),
+             [](kakuro::CSPSolver &s, const kakuro::FillParams &params,
+                const kakuro::TopologyParams &topo_params) -> std::optional<kakuro::DifficultyResult> {
+                 if (!s.generate_puzzle(params, topo_params))
+                     return std::nullopt;
+                 return s.last_difficulty();
+             },
              py::arg("params") = kakuro::FillParams(),
              py::arg("topo_params") = kakuro::TopologyParams(),
              py::call_guard<py::gil_scoped_release>())
              
         .def("generate_puzzle", 
-             static_cast<bool (kakuro::CSPSolver::*)(const std::string&)>(&kakuro::CSPSolver::generate_puzzle),
+             [](kakuro::CSPSolver &s, const std::string &difficulty) -> std::optional<kakuro::DifficultyResult> {
+                 if (!s.generate_puzzle(difficulty))
+                     return std::nullopt;
+                 return s.last_difficulty();
+             },
              py::arg("difficulty") = "medium",
              py::call_guard<py::gil_scoped_release>())
              
@@ -227,6 +350,20 @@ PYBIND11_MODULE(kakuro_cpp, m) {
              
         .def("calculate_clues", &kakuro::CSPSolver::calculate_clues)
         
+        .def("set_uniqueness_threads", &kakuro::CSPSolver::set_uniqueness_threads,
+             py::arg("threads"))
+        .def("set_fill_portfolio", &kakuro::CSPSolver::set_fill_portfolio,
+             py::arg("members"))
+        .def("set_time_limit", &kakuro::CSPSolver::set_time_limit,
+             py::arg("seconds"))
+        .def("set_budget", &kakuro::CSPSolver::set_budget,
+             py::arg("budget"))
+        .def("set_topology_pool", &kakuro::CSPSolver::set_topology_pool,
+             py::arg("pool"))
+        .def("last_stats", &kakuro::CSPSolver::last_stats,
+             py::return_value_policy::copy)
+        .def("last_difficulty", &kakuro::CSPSolver::last_difficulty,
+             py::return_value_policy::copy)
         .def("check_uniqueness", &kakuro::CSPSolver::check_uniqueness,
              py::arg("max_nodes") = 10000,
              py::arg("seed_offset") = 0,
@@ -254,7 +391,75 @@ PYBIND11_MODULE(kakuro_cpp, m) {
         .def_readwrite("difficulty", &kakuro::GeneratedPuzzle::difficulty)
         .def_readwrite("width", &kakuro::GeneratedPuzzle::width)
         .def_readwrite("height", &kakuro::GeneratedPuzzle::height)
-        .def_readwrite("grid", &kakuro::GeneratedPuzzle::grid);
+        .def_readwrite("grid", &kakuro::GeneratedPuzzle::grid)
+        .def_readwrite("stats", &kakuro::GeneratedPuzzle::stats)
+        .def("to_planes", [](const kakuro::GeneratedPuzzle& p) { return kakuro::export_planes(p); })
+        .def("grid_to_json", [](const kakuro::GeneratedPuzzle& p) { return kakuro::grid_to_json(p); })
+        .def("to_json", &kakuro::puzzle_to_json,
+             "{width, height, difficulty, grid} serialized natively");
+
+    m.def("encode_puzzle", [](const kakuro::GeneratedPuzzle& p) {
+            std::vector<uint8_t> data = kakuro::encode_puzzle(p);
+            return py::bytes((const char*)data.data(), data.size());
+        }, py::arg("puzzle"),
+        "Compact versioned binary encoding (no solve path)");
+    m.def("decode_puzzle", [](py::bytes data) -> std::optional<kakuro::GeneratedPuzzle> {
+            std::string_view view = data;
+            kakuro::GeneratedPuzzle p;
+            if (!kakuro::decode_puzzle((const uint8_t*)view.data(), view.size(), p))
+                return std::nullopt;
+            return p;
+        }, py::arg("data"),
+        "Inverse of encode_puzzle; None for invalid data");
+
+    py::class_<kakuro::PuzzleTransform>(m, "PuzzleTransform")
+        .def(py::init<>())
+        .def_readwrite("transpose", &kakuro::PuzzleTransform::transpose)
+        .def_readwrite("mirror_cols", &kakuro::PuzzleTransform::mirror_cols)
+        .def_readwrite("mirror_rows", &kakuro::PuzzleTransform::mirror_rows)
+        .def_readwrite("complement", &kakuro::PuzzleTransform::complement);
+
+    m.def("transform_puzzle", [](const kakuro::GeneratedPuzzle& p,
+                                 const kakuro::PuzzleTransform& t,
+                                 bool reestimate) -> std::optional<kakuro::GeneratedPuzzle> {
+            kakuro::GeneratedPuzzle out;
+            if (!kakuro::transform_puzzle(p, t, out, reestimate))
+                return std::nullopt;
+            return out;
+        }, py::arg("puzzle"), py::arg("transform"), py::arg("reestimate") = true,
+        py::call_guard<py::gil_scoped_release>(),
+        "Symmetric/complemented copy with recomputed clues; None if invalid");
+    m.def("puzzle_variants", &kakuro::puzzle_variants,
+          py::arg("puzzle"), py::arg("max_variants") = 3, py::arg("reestimate") = true,
+          py::call_guard<py::gil_scoped_release>(),
+          "Up to max_variants distinct transformed copies of a solved puzzle");
+
+    py::class_<kakuro::PuzzlePoolWriter>(m, "PuzzlePoolWriter")
+        .def(py::init<>())
+        .def("open", &kakuro::PuzzlePoolWriter::open, py::arg("path"))
+        .def("append", &kakuro::PuzzlePoolWriter::append,
+             py::arg("puzzle"), py::arg("difficulty"))
+        .def("close", &kakuro::PuzzlePoolWriter::close)
+        .def("is_open", &kakuro::PuzzlePoolWriter::is_open);
+
+    py::class_<kakuro::PuzzlePool>(m, "PuzzlePool")
+        .def(py::init<>())
+        .def("open", &kakuro::PuzzlePool::open, py::arg("path"))
+        .def("refresh", &kakuro::PuzzlePool::refresh)
+        .def("close", &kakuro::PuzzlePool::close)
+        .def("__len__", &kakuro::PuzzlePool::size)
+        .def("count", &kakuro::PuzzlePool::count,
+             py::arg("difficulty"), py::arg("width") = 0, py::arg("height") = 0)
+        .def("random_puzzle",
+             [](kakuro::PuzzlePool& pool, const std::string& difficulty, int width, int height)
+                 -> std::optional<kakuro::GeneratedPuzzle> {
+                 kakuro::GeneratedPuzzle p;
+                 if (!pool.random_puzzle(difficulty, width, height, p))
+                     return std::nullopt;
+                 return p;
+             },
+             py::arg("difficulty"), py::arg("width") = 0, py::arg("height") = 0,
+             "Random puzzle of that difficulty and size (0 = any size), or None");
 
     py::class_<kakuro::DifficultyResult>(m, "DifficultyResult")
         .def_readwrite("score", &kakuro::DifficultyResult::score)
@@ -265,6 +470,8 @@ PYBIND11_MODULE(kakuro_cpp, m) {
         .def_readwrite("uniqueness", &kakuro::DifficultyResult::uniqueness)
         .def_readwrite("solve_path", &kakuro::DifficultyResult::solve_path)
         .def_readwrite("solutions", &kakuro::DifficultyResult::solutions)
+        .def("to_json", &kakuro::difficulty_to_json,
+             "Rating, score, tier, uniqueness and solve path (no solutions) as JSON")
         .def("__repr__", [](const kakuro::DifficultyResult &r) {
             std::ostringstream oss;
             oss << "<DifficultyResult rating='" << r.rating << "', "
@@ -279,6 +486,139 @@ PYBIND11_MODULE(kakuro_cpp, m) {
         .def("estimate_difficulty", &kakuro::KakuroDifficultyEstimator::estimate_difficulty,
              py::call_guard<py::gil_scoped_release>())
         .def("estimate_difficulty_detailed", &kakuro::KakuroDifficultyEstimator::estimate_difficulty_detailed,
-             py::call_guard<py::gil_scoped_release>());
+             py::call_guard<py::gil_scoped_release>())
+        .def("set_budget", &kakuro::KakuroDifficultyEstimator::set_budget,
+             py::arg("budget"));
+
+    m.def("generate_batch", &kakuro::generate_batch,
+          py::arg("count"),
+          py::arg("width_range"),
+          py::arg("height_range"),
+          py::arg("fill_params") = kakuro::FillParams(),
+          py::arg("topo_params") = kakuro::TopologyParams(),
+          py::arg("threads") = 0,
+          py::arg("budget") = nullptr,
+          py::call_guard<py::gil_scoped_release>(),
+          "Generates puzzles on a native worker pool (threads=0 uses all cores)");
+
+    py::class_<kakuro::StreamTarget>(m, "StreamTarget")
+        .def(py::init<>())
+        .def_readwrite("width_range", &kakuro::StreamTarget::width_range)
+        .def_readwrite("height_range", &kakuro::StreamTarget::height_range)
+        .def_readwrite("fill_params", &kakuro::StreamTarget::fill_params)
+        .def_readwrite("topo_params", &kakuro::StreamTarget::topo_params)
+        .def_readwrite("weight", &kakuro::StreamTarget::weight)
+        .def_readwrite("max_queued", &kakuro::StreamTarget::max_queued);
+
+    // Iterating yields (difficulty, GeneratedPuzzle) and ends once stopped and empty
+    py::class_<kakuro::PuzzleStream>(m, "PuzzleStream")
+        .def(py::init<std::vector<kakuro::StreamTarget>, int, int>(),
+             py::arg("targets"),
+             py::arg("capacity") = kakuro::PuzzleStream::DEFAULT_CAPACITY,
+             py::arg("threads") = 0)
+        .def("start", &kakuro::PuzzleStream::start)
+        .def("stop", &kakuro::PuzzleStream::stop,
+             py::call_guard<py::gil_scoped_release>())
+        .def("running", &kakuro::PuzzleStream::running)
+        .def("set_targets", &kakuro::PuzzleStream::set_targets, py::arg("targets"))
+        .def("pop", [](kakuro::PuzzleStream& s, int timeout_ms, const std::string& difficulty)
+                 -> std::optional<std::pair<std::string, kakuro::GeneratedPuzzle>> {
+                 kakuro::StreamedPuzzle item;
+                 bool ok;
+                 {
+                     py::gil_scoped_release release;
+                     ok = s.pop(item, timeout_ms, difficulty);
+                 }
+                 if (!ok)
+                     return std::nullopt;
+                 return std::make_pair(std::move(item.difficulty), std::move(item.puzzle));
+             },
+             py::arg("timeout_ms") = -1, py::arg("difficulty") = "",
+             "(difficulty, puzzle), or None on timeout or once stopped without a match")
+        .def("__iter__", [](kakuro::PuzzleStream& s) -> kakuro::PuzzleStream& { return s; },
+             py::return_value_policy::reference_internal)
+        .def("__next__", [](kakuro::PuzzleStream& s) {
+                 kakuro::StreamedPuzzle item;
+                 bool ok;
+                 {
+                     py::gil_scoped_release release;
+                     ok = s.pop(item, -1);
+                 }
+                 if (!ok)
+                     throw py::stop_iteration();
+                 return std::make_pair(std::move(item.difficulty), std::move(item.puzzle));
+             })
+        .def("__len__", py::overload_cast<>(&kakuro::PuzzleStream::size, py::const_))
+        .def("count", py::overload_cast<const std::string&>(&kakuro::PuzzleStream::size, py::const_),
+             py::arg("difficulty"))
+        .def_property_readonly("capacity", &kakuro::PuzzleStream::capacity)
+        .def_property_readonly("produced", &kakuro::PuzzleStream::produced)
+        .def_property_readonly("failed", &kakuro::PuzzleStream::failed);
+
+    py::enum_<kakuro::SolveMode>(m, "SolveMode")
+        .value("SOLVE", kakuro::SolveMode::SOLVE)
+        .value("COUNT", kakuro::SolveMode::COUNT)
+        .value("VERIFY", kakuro::SolveMode::VERIFY);
+
+    py::class_<kakuro::SolveResult>(m, "SolveResult")
+        .def_readonly("valid", &kakuro::SolveResult::valid)
+        .def_readonly("solution_count", &kakuro::SolveResult::solution_count)
+        .def_readonly("exhausted", &kakuro::SolveResult::exhausted)
+        .def_readonly("nodes", &kakuro::SolveResult::nodes)
+        // Row-major bytes, 0 on blocks; empty if no solution was found
+        .def_property_readonly("solution", [](const kakuro::SolveResult& r) {
+            return py::bytes((const char*)r.solution.data(), r.solution.size());
+        })
+        .def_readonly("checked", &kakuro::SolveResult::checked)
+        .def_readonly("solved", &kakuro::SolveResult::solved)
+        .def_readonly("wrong_cells", &kakuro::SolveResult::wrong_cells)
+        .def("__repr__", [](const kakuro::SolveResult& r) {
+            std::ostringstream oss;
+            oss << "<SolveResult valid=" << r.valid << ", solutions=" << r.solution_count
+                << (r.exhausted ? "+" : "") << ", wrong=" << r.wrong_cells.size() << ">";
+            return oss.str();
+        });
+
+    m.def("solve_many", &kakuro::solve_many,
+          py::arg("puzzles"),
+          py::arg("mode") = kakuro::SolveMode::VERIFY,
+          py::arg("max_solutions") = 2,
+          py::arg("threads") = 0,
+          py::arg("max_nodes") = 150000,
+          py::arg("budget") = nullptr,
+          py::call_guard<py::gil_scoped_release>(),
+          "Solves, counts or verifies a list of GridPlanes on a native worker pool");
+
+    m.def("configure_logging", &kakuro::GenerationLogger::configure,
+          py::arg("level"),
+          py::arg("async_write") = false,
+          py::arg("buffer_records") = kakuro::AsyncLogWriter::DEFAULT_CAPACITY,
+          py::arg("overflow") = kakuro::LogOverflow::BLOCK,
+          py::call_guard<py::gil_scoped_release>(),
+          "Sets the generation log level and optionally moves file writes to a background thread");
+    m.def("flush_logs", &kakuro::GenerationLogger::flush_all,
+          py::call_guard<py::gil_scoped_release>(),
+          "Waits until every queued log record has been written");
+    m.def("dropped_log_records", []() {
+        return kakuro::AsyncLogWriter::instance().dropped();
+    });
+
+    m.def("profile_summary", []() {
+        py::list result;
+        for (const auto &s : kakuro::ProfileRegistry::summary()) {
+            py::dict d;
+            d["name"] = s.name;
+            d["count"] = s.count;
+            d["total_ms"] = s.total_ms;
+            d["mean_ms"] = s.total_ms / s.count;
+            d["min_ms"] = s.min_ms;
+            d["max_ms"] = s.max_ms;
+            d["histogram"] = std::vector<uint64_t>(s.histogram.begin(), s.histogram.end());
+            result.append(d);
+        }
+        return result;
+    }, "Per-scope timing merged over all threads; histogram bucket b counts samples in [2^b, 2^(b+1)) ns");
+    m.def("reset_profile", &kakuro::ProfileRegistry::reset);
+    m.def("set_profiling_enabled", &kakuro::ProfileRegistry::set_enabled, py::arg("enabled"));
    
 }
\ No newline at end of file
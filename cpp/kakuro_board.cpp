@@ -7,7 +7,16 @@
 namespace kakuro {
 
 KakuroBoard::KakuroBoard(int w, int h)
-    : width(w), height(h), rng(std::random_device{}()) {
+    : KakuroBoard(w, h, std::random_device{}()) {}
+
+KakuroBoard::KakuroBoard(int w, int h, uint32_t seed)
+    : width(w), height(h), rng(seed) {
+  if (width > MAX_DIMENSION || height > MAX_DIMENSION) {
+    LOG_ERROR("Board " << width << "x" << height << " exceeds the maximum of "
+                       << MAX_DIMENSION << "; clamping");
+    width = std::min(width, MAX_DIMENSION);
+    height = std::min(height, MAX_DIMENSION);
+  }
   // Initialize grid
   grid.resize(height);
   for (int r = 0; r < height; r++) {
@@ -16,9 +25,42 @@ KakuroBoard::KakuroBoard(int w, int h)
       grid[r].emplace_back(r, c, CellType::BLOCK);
     }
   }
+  white_rows.assign(height, 0);
+  white_cols.assign(width, 0);
+  sectors_h.reset(height, width, &Cell::sector_h);
+  sectors_v.reset(width, height, &Cell::sector_v);
+  for (int r = 0; r < height; r++) {
+    for (int c = 0; c < width; c++) {
+      sectors_h.set_cell(r, c, &grid[r][c]);
+      sectors_v.set_cell(c, r, &grid[r][c]);
+    }
+  }
   logger = std::make_shared<GenerationLogger>();
 }
 
+std::shared_ptr<KakuroBoard> KakuroBoard::clone() const {
+  auto copy = std::make_shared<KakuroBoard>(width, height);
+  copy->copy_cells_from(*this);
+  copy->rng = rng;
+  return copy;
+}
+
+void KakuroBoard::copy_cells_from(const KakuroBoard &other) {
+  for (int r = 0; r < height; r++) {
+    for (int c = 0; c < width; c++) {
+      const Cell &src = other.grid[r][c];
+      Cell &dst = grid[r][c];
+      dst.type = src.type;
+      dst.value = src.value;
+      dst.clue_h = src.clue_h;
+      dst.clue_v = src.clue_v;
+    }
+  }
+  // Row-major collection reproduces the same Cell::idx numbering
+  collect_white_cells();
+  identify_sectors();
+}
+
 Cell *KakuroBoard::get_cell(int r, int c) {
   if (r >= 0 && r < height && c >= 0 && c < width) {
     return &grid[r][c];
@@ -26,32 +68,33 @@ Cell *KakuroBoard::get_cell(int r, int c) {
   return nullptr;
 }
 
-// Helper for logging
+// Helper for logging. Returns an empty state when nothing would be written.
 std::vector<std::vector<LogCell>>
 KakuroBoard::get_grid_state(
     const std::unordered_map<Cell *, int> *assignment) const {
   std::vector<std::vector<LogCell>> state;
+  if (!logger || !logger->is_enabled())
+    return state;
+
+  state.reserve(height);
   for (int r = 0; r < height; ++r) {
     std::vector<LogCell> row_state;
+    row_state.reserve(width);
     for (int c = 0; c < width; ++c) {
-      std::string type =
-          (grid[r][c].type == CellType::BLOCK) ? "BLOCK" : "WHITE";
-      int val = grid[r][c].value.value_or(0);
-      int clue_h = grid[r][c].clue_h.value_or(0);
-      int clue_v = grid[r][c].clue_v.value_or(0);
-
-      if (assignment) {
-        // Look up in assignment map
-        // Helper to find non-const pointer equivalent
-        // We know the map keys are pointers to these cells
-        auto it = assignment->find(const_cast<Cell *>(&grid[r][c]));
-        if (it != assignment->end()) {
-          val = it->second;
-        }
-      }
-      row_state.push_back({type, val, clue_h, clue_v});
+      const Cell &cell = grid[r][c];
+      row_state.push_back({cell.type, cell.value.value_or(0),
+                           cell.clue_h.value_or(0), cell.clue_v.value_or(0)});
+    }
+    state.push_back(std::move(row_state));
+  }
+
+  if (assignment) {
+    // Overlay assigned values; keys are pointers into this grid
+    for (const auto &[cell, val] : *assignment) {
+      if (cell && cell->r >= 0 && cell->r < height && cell->c >= 0 &&
+          cell->c < width && &grid[cell->r][cell->c] == cell)
+        state[cell->r][cell->c].value = val;
     }
-    state.push_back(row_state);
   }
   return state;
 }
@@ -70,18 +113,69 @@ void KakuroBoard::reset_values() {
 
 void KakuroBoard::set_block(int r, int c) {
   Cell *cell = get_cell(r, c);
-  if (cell && cell->type != CellType::BLOCK) {
+  if (!cell)
+    return;
+  if (cell->type != CellType::BLOCK) {
     cell->type = CellType::BLOCK;
     cell->value = std::nullopt;
   }
+  mark_white_bit(r, c, false);
 }
 
 void KakuroBoard::set_white(int r, int c) {
   if (r >= 1 && r < height - 1 && c >= 1 && c < width - 1) {
     grid[r][c].type = CellType::WHITE;
+    mark_white_bit(r, c, true);
   }
 }
 
+void KakuroBoard::mark_white_bit(int r, int c, bool white) {
+  if (((white_rows[r] >> c) & 1) == (uint64_t)white)
+    return;
+  white_rows[r] ^= 1ULL << c;
+  white_cols[c] ^= 1ULL << r;
+  dirty_rows_ |= 1ULL << r;
+  dirty_cols_ |= 1ULL << c;
+}
+
+void KakuroBoard::assign_white_rows(const uint64_t *rows) {
+  for (int r = 0; r < height; r++) {
+    uint64_t diff = white_rows[r] ^ rows[r];
+    if (!diff)
+      continue;
+    dirty_rows_ |= 1ULL << r;
+    dirty_cols_ |= diff;
+    for (; diff; diff &= diff - 1)
+      white_cols[lowest_bit_index(diff)] ^= 1ULL << r;
+    white_rows[r] = rows[r];
+  }
+}
+
+void KakuroBoard::sync_white_bits() {
+  std::array<uint64_t, MAX_DIMENSION> rows{};
+  for (int r = 0; r < height; r++) {
+    for (int c = 0; c < width; c++) {
+      if (grid[r][c].type == CellType::WHITE)
+        rows[r] |= 1ULL << c;
+    }
+  }
+  assign_white_rows(rows.data());
+}
+
+void KakuroBoard::load_white_rows(const uint64_t *rows) {
+  for (int r = 0; r < height; r++) {
+    for (int c = 0; c < width; c++) {
+      Cell &cell = grid[r][c];
+      cell.type = ((rows[r] >> c) & 1) ? CellType::WHITE : CellType::BLOCK;
+      cell.value = std::nullopt;
+      cell.clue_h = std::nullopt;
+      cell.clue_v = std::nullopt;
+    }
+  }
+  collect_white_cells();
+  identify_sectors();
+}
+
 bool KakuroBoard::generate_topology(double density, int max_sector_length,
                                     std::string difficulty) {
   TopologyParams params;
@@ -242,10 +336,9 @@ bool KakuroBoard::generate_topology(const TopologyParams &params) {
   }
 
   for (int attempt = 0; attempt < MAX_RETRIES; attempt++) {
+    if (budget && budget->expired())
+      return false;
     white_cells.clear();
-    sectors_h.clear(); // Clear sectors explicitly to prevent pointer
-                       // invalidation issues
-    sectors_v.clear();
 
 #if KAKURO_ENABLE_LOGGING
     logger->start_new_kakuro();
@@ -253,7 +346,7 @@ bool KakuroBoard::generate_topology(const TopologyParams &params) {
         GenerationLogger::STAGE_TOPOLOGY, GenerationLogger::SUBSTAGE_START,
         "Starting topology generation attempt " + std::to_string(attempt + 1) +
             " with density=" + std::to_string(density),
-        get_grid_state());
+        *this);
 #endif
 
     // 1. Clear Grid (All Block)
@@ -263,10 +356,10 @@ bool KakuroBoard::generate_topology(const TopologyParams &params) {
         grid[r][c].value = std::nullopt;
         grid[r][c].clue_h = std::nullopt;
         grid[r][c].clue_v = std::nullopt;
-        grid[r][c].sector_h = nullptr;
-        grid[r][c].sector_v = nullptr;
       }
     }
+    std::array<uint64_t, MAX_DIMENSION> no_white{};
+    assign_white_rows(no_white.data());
 
     bool success = false;
     if (island_mode) {
@@ -276,20 +369,20 @@ bool KakuroBoard::generate_topology(const TopologyParams &params) {
 #if KAKURO_ENABLE_LOGGING
       logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                        GenerationLogger::SUBSTAGE_STAMP_PLACEMENT,
-                       "Generated stamps (island mode)", get_grid_state());
+                       "Generated stamps (island mode)", *this);
 #endif
     } else {
       if (place_random_seed()) {
 #if KAKURO_ENABLE_LOGGING
         logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                          GenerationLogger::SUBSTAGE_SEED_PLACEMENT,
-                         "Placed random seed", get_grid_state());
+                         "Placed random seed", *this);
 #endif
         grow_lattice(density, max_sector_length);
 #if KAKURO_ENABLE_LOGGING
         logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                          GenerationLogger::SUBSTAGE_LATTICE_GROWTH,
-                         "Grew lattice", get_grid_state());
+                         "Grew lattice", *this);
 #endif
         collect_white_cells();
         success = !white_cells.empty();
@@ -300,7 +393,7 @@ bool KakuroBoard::generate_topology(const TopologyParams &params) {
 #if KAKURO_ENABLE_LOGGING
       logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                        GenerationLogger::SUBSTAGE_VALIDATION_FAILED,
-                       "Initial generation failed", get_grid_state());
+                       "Initial generation failed", *this);
 #endif
       continue;
     }
@@ -311,6 +404,8 @@ bool KakuroBoard::generate_topology(const TopologyParams &params) {
     const int MAX_TOPOLOGY_LOOPS = 20;
 
     while (changed && iterations < MAX_TOPOLOGY_LOOPS) {
+      if (budget && budget->expired())
+        return false;
       changed = false;
       iterations++;
 
@@ -339,7 +434,7 @@ bool KakuroBoard::generate_topology(const TopologyParams &params) {
           GenerationLogger::SUBSTAGE_VALIDATION_FAILED,
           "Too few white cells: " + std::to_string(white_cells.size()) + " < " +
               std::to_string(target_min_cells),
-          get_grid_state());
+          *this);
 #endif
       continue;
     }
@@ -347,7 +442,7 @@ bool KakuroBoard::generate_topology(const TopologyParams &params) {
 #if KAKURO_ENABLE_LOGGING
       logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                        GenerationLogger::SUBSTAGE_VALIDATION_FAILED,
-                       "Connectivity check failed", get_grid_state());
+                       "Connectivity check failed", *this);
 #endif
       continue;
     }
@@ -355,7 +450,7 @@ bool KakuroBoard::generate_topology(const TopologyParams &params) {
 #if KAKURO_ENABLE_LOGGING
       logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                        GenerationLogger::SUBSTAGE_VALIDATION_FAILED,
-                       "Clue header validation failed", get_grid_state());
+                       "Clue header validation failed", *this);
 #endif
       continue;
     }
@@ -368,7 +463,7 @@ bool KakuroBoard::generate_topology(const TopologyParams &params) {
       logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                        GenerationLogger::SUBSTAGE_VALIDATION_FAILED,
                        "Topology structure validation failed",
-                       get_grid_state());
+                       *this);
 #endif
       continue; // Try next attempt
     }
@@ -376,7 +471,7 @@ bool KakuroBoard::generate_topology(const TopologyParams &params) {
 #if KAKURO_ENABLE_LOGGING
     logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                      GenerationLogger::SUBSTAGE_COMPLETE,
-                     "Topology generation successful", get_grid_state());
+                     "Topology generation successful", *this);
 #endif
     return true;
   }
@@ -388,7 +483,7 @@ bool KakuroBoard::generate_topology(const TopologyParams &params) {
                    GenerationLogger::SUBSTAGE_FAILED,
                    "Failed to generate topology after " +
                        std::to_string(MAX_RETRIES) + " retries",
-                   get_grid_state());
+                   *this);
 #endif
   return false;
 }
@@ -412,11 +507,8 @@ bool KakuroBoard::validate_topology_structure() {
   };
 
   // Check horizontal sectors
-  for (const auto &sector : sectors_h) {
-    if (sector->empty())
-      continue;
-
-    Cell *first = (*sector)[0];
+  for (SectorSpan sector : sectors_h) {
+    Cell *first = sector[0];
     int clue_r = first->r;
     int clue_c = first->c - 1;
 
@@ -430,11 +522,8 @@ bool KakuroBoard::validate_topology_structure() {
   }
 
   // Check vertical sectors
-  for (const auto &sector : sectors_v) {
-    if (sector->empty())
-      continue;
-
-    Cell *first = (*sector)[0];
+  for (SectorSpan sector : sectors_v) {
+    Cell *first = sector[0];
     int clue_r = first->r - 1;
     int clue_c = first->c;
 
@@ -658,141 +747,77 @@ bool KakuroBoard::generate_stamps(
   return !white_cells.empty();
 }
 
+namespace {
+// Mask of bits [0, n)
+uint64_t low_bits(int n) { return n >= 64 ? ~0ULL : (1ULL << n) - 1; }
+} // namespace
+
 void KakuroBoard::stamp_rect(int r, int c, int h, int w) {
-  for (int i = 0; i < h; i++) {
-    for (int j = 0; j < w; j++) {
-      set_white(r + i, c + j);
-      set_white(height - 1 - (r + i), width - 1 - (c + j));
+  // Clipped to the interior, like set_white
+  auto stamp = [&](int top, int left) {
+    int r0 = std::max(top, 1), r1 = std::min(top + h, height - 1);
+    int c0 = std::max(left, 1), c1 = std::min(left + w, width - 1);
+    if (r0 >= r1 || c0 >= c1)
+      return;
+    uint64_t span = low_bits(c1) & ~low_bits(c0);
+    for (int i = r0; i < r1; i++) {
+      for (uint64_t fresh = span & ~white_rows[i]; fresh; fresh &= fresh - 1)
+        set_white(i, lowest_bit_index(fresh));
     }
-  }
+  };
+  stamp(r, c);
+  stamp(height - r - h, width - c - w);
 }
 
-bool KakuroBoard::slice_long_runs(int max_len) {
-  PROFILE_FUNCTION(logger);
+template <typename ShouldSlice>
+bool KakuroBoard::slice_runs(int min_len, ShouldSlice should_slice) {
   bool changed = false;
-  // Horizontal
-  for (int r = 1; r < height - 1; r++) {
-    int length = 0;
-    int run_start = -1;
-    for (int c = 1; c < width; c++) {
-      if (grid[r][c].type == CellType::WHITE) {
-        if (run_start == -1)
-          run_start = c;
-        length++;
-      } else {
-        if (length > max_len) {
-          if (apply_slice(r, run_start, length, true)) {
-            changed = true;
-          }
-        }
-        length = 0;
-        run_start = -1;
-      }
-    }
-    if (length > max_len) {
-      if (apply_slice(r, run_start, length, true)) {
-        changed = true;
+  // Rows, then columns. A line is re-read after each slice because the
+  // reconnecting bridge can land anywhere on the board.
+  auto scan = [&](const std::vector<uint64_t> &lines, bool is_horz) {
+    for (int i = 1; i + 1 < (int)lines.size(); i++) {
+      for (int pos = 1; pos < MAX_DIMENSION;) {
+        uint64_t rest = lines[i] & ~low_bits(pos);
+        if (!rest)
+          break;
+        int start = lowest_bit_index(rest);
+        // start >= 1 shifts a clear bit into the top, so ~ is never zero
+        int length = lowest_bit_index(~(rest >> start));
+        if (length > min_len && should_slice() &&
+            apply_slice(i, start, length, is_horz))
+          changed = true;
+        pos = start + length + 1;
       }
     }
-  }
+  };
+  scan(white_rows, true);
+  scan(white_cols, false);
+  return changed;
+}
 
-  // Vertical
-  for (int c = 1; c < width - 1; c++) {
-    int length = 0;
-    int run_start = -1;
-    for (int r = 1; r < height; r++) {
-      if (grid[r][c].type == CellType::WHITE) {
-        if (run_start == -1)
-          run_start = r;
-        length++;
-      } else {
-        if (length > max_len) {
-          if (apply_slice(c, run_start, length, false)) {
-            changed = true;
-          }
-        }
-        length = 0;
-        run_start = -1;
-      }
-    }
-    if (length > max_len) {
-      if (apply_slice(c, run_start, length, false)) {
-        changed = true;
-      }
-    }
-  }
+bool KakuroBoard::slice_long_runs(int max_len) {
+  PROFILE_FUNCTION(logger);
+  bool changed = slice_runs(max_len, [] { return true; });
 #if KAKURO_ENABLE_LOGGING
   if (changed) {
     logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                      GenerationLogger::SUBSTAGE_SLICE_RUNS, "Sliced long runs",
-                     get_grid_state());
+                     *this);
   }
 #endif
   return changed;
 }
 
 bool KakuroBoard::slice_soft_runs(int soft_len, double prob) {
-  bool changed = false;
   std::uniform_real_distribution<> dist(0.0, 1.0);
-
-  // Horizontal
-  for (int r = 1; r < height - 1; r++) {
-    int length = 0;
-    int run_start = -1;
-    for (int c = 1; c < width; c++) {
-      if (grid[r][c].type == CellType::WHITE) {
-        if (run_start == -1)
-          run_start = c;
-        length++;
-      } else {
-        if (length > soft_len && dist(rng) < prob) {
-          if (apply_slice(r, run_start, length, true)) {
-            changed = true;
-          }
-        }
-        length = 0;
-        run_start = -1;
-      }
-    }
-    if (length > soft_len && dist(rng) < prob) {
-      if (apply_slice(r, run_start, length, true)) {
-        changed = true;
-      }
-    }
-  }
-
-  // Vertical
-  for (int c = 1; c < width - 1; c++) {
-    int length = 0;
-    int run_start = -1;
-    for (int r = 1; r < height; r++) {
-      if (grid[r][c].type == CellType::WHITE) {
-        if (run_start == -1)
-          run_start = r;
-        length++;
-      } else {
-        if (length > soft_len && dist(rng) < prob) {
-          if (apply_slice(c, run_start, length, false)) {
-            changed = true;
-          }
-        }
-        length = 0;
-        run_start = -1;
-      }
-    }
-    if (length > soft_len && dist(rng) < prob) {
-      if (apply_slice(c, run_start, length, false)) {
-        changed = true;
-      }
-    }
-  }
+  bool changed = slice_runs(soft_len, [&] { return dist(rng) < prob; });
 
 #if KAKURO_ENABLE_LOGGING
   if (changed) {
     logger->log_step(
         GenerationLogger::STAGE_TOPOLOGY, GenerationLogger::SUBSTAGE_SLICE_RUNS,
         "Sliced soft runs (len > " + std::to_string(soft_len) + ")",
-        get_grid_state());
+        *this);
   }
 #endif
   return changed;
@@ -806,37 +831,208 @@ bool KakuroBoard::apply_slice(int fixed_idx, int start, int length,
   return try_remove_and_reconnect(r, c);
 }
 
-std::vector<std::vector<std::pair<int, int>>> KakuroBoard::find_components() {
-  collect_white_cells();
-  std::vector<std::vector<std::pair<int, int>>> components;
-  std::unordered_set<std::pair<int, int>, PairHash> visited;
+// ============================================================================
+// CONNECTIVITY
+// ============================================================================
+
+namespace {
+const int DR4[] = {0, 0, 1, -1};
+const int DC4[] = {1, -1, 0, 0};
+// The 8-neighbourhood in ring order; even entries are the 4-neighbours
+const int RING_DR[] = {-1, -1, 0, 1, 1, 1, 0, -1};
+const int RING_DC[] = {0, 1, 1, 1, 0, -1, -1, -1};
+} // namespace
+
+void GridConnectivity::reset(int width, int height) {
+  width_ = width;
+  height_ = height;
+  int n = width * height;
+  white_.assign((n + 63) / 64, 0);
+  parent_.resize(n);
+  size_.resize(n);
+  num_white_ = 0;
+  num_components_ = 0;
+}
+
+void GridConnectivity::build(const KakuroBoard &board) {
+  reset(board.width, board.height);
+  for (int r = 0; r < height_; r++) {
+    for (uint64_t row = board.white_rows[r]; row; row &= row - 1)
+      add_white(r, lowest_bit_index(row));
+  }
+}
+
+int GridConnectivity::find(int i) {
+  while (parent_[i] != i) {
+    parent_[i] = parent_[parent_[i]]; // Path halving
+    i = parent_[i];
+  }
+  return i;
+}
+
+void GridConnectivity::add_white(int r, int c) {
+  if (is_white(r, c))
+    return;
+  int i = r * width_ + c;
+  white_[i >> 6] |= 1ULL << (i & 63);
+  parent_[i] = i;
+  size_[i] = 1;
+  num_white_++;
+  num_components_++;
+
+  for (int k = 0; k < 4; k++) {
+    int nr = r + DR4[k], nc = c + DC4[k];
+    if (nr < 0 || nr >= height_ || nc < 0 || nc >= width_ || !is_white(nr, nc))
+      continue;
+    int a = find(i), b = find(nr * width_ + nc);
+    if (a == b)
+      continue;
+    if (size_[a] < size_[b])
+      std::swap(a, b);
+    parent_[b] = a;
+    size_[a] += size_[b];
+    num_components_--;
+  }
+}
 
-  for (Cell *start_node : white_cells) {
-    if (visited.count({start_node->r, start_node->c}))
+std::vector<int> GridConnectivity::labels() {
+  int n = width_ * height_;
+  std::vector<int> label(n, -1);
+  std::vector<int> root_label(n, -1);
+  int next = 0;
+  for (int i = 0; i < n; i++) {
+    if (!((white_[i >> 6] >> (i & 63)) & 1))
       continue;
+    int root = find(i);
+    if (root_label[root] < 0)
+      root_label[root] = next++;
+    label[i] = root_label[root];
+  }
+  return label;
+}
 
-    std::vector<std::pair<int, int>> comp;
-    std::queue<Cell *> q;
-    q.push(start_node);
-    visited.insert({start_node->r, start_node->c});
-
-    while (!q.empty()) {
-      Cell *curr = q.front();
-      q.pop();
-      comp.push_back({curr->r, curr->c});
-
-      int dr[] = {0, 0, 1, -1};
-      int dc[] = {1, -1, 0, 0};
-      for (int i = 0; i < 4; i++) {
-        Cell *n = get_cell(curr->r + dr[i], curr->c + dc[i]);
-        if (n && n->type == CellType::WHITE && !visited.count({n->r, n->c})) {
-          visited.insert({n->r, n->c});
-          q.push(n);
-        }
-      }
+bool GridConnectivity::white_at(int r, int c,
+                                const std::vector<int> &removed) const {
+  if (r < 0 || r >= height_ || c < 0 || c >= width_ || !is_white(r, c))
+    return false;
+  int i = r * width_ + c;
+  return std::find(removed.begin(), removed.end(), i) == removed.end();
+}
+
+// True when the white 4-neighbours of (r, c) stay connected through its
+// 8-neighbourhood alone. Consecutive ring cells touch, so every run of white
+// ring cells is connected; it is enough that one run holds all of them.
+bool GridConnectivity::ring_connected(int r, int c,
+                                      const std::vector<int> &removed) const {
+  bool open[8];
+  int start = -1;
+  for (int k = 0; k < 8; k++) {
+    open[k] = white_at(r + RING_DR[k], c + RING_DC[k], removed);
+    if (!open[k])
+      start = k;
+  }
+  if (start < 0)
+    return true; // Fully white ring
+
+  int runs = 0, run_with_neighbour = -1;
+  bool in_run = false;
+  for (int step = 1; step <= 8; step++) {
+    int k = (start + step) % 8;
+    if (!open[k]) {
+      in_run = false;
+      continue;
+    }
+    if (!in_run) {
+      in_run = true;
+      runs++;
+    }
+    if (k % 2 == 0) {
+      if (run_with_neighbour >= 0 && run_with_neighbour != runs)
+        return false;
+      run_with_neighbour = runs;
+    }
+  }
+  return true;
+}
+
+bool GridConnectivity::would_disconnect(
+    const std::vector<std::pair<int, int>> &cells) {
+  std::vector<int> removed;
+  for (auto [r, c] : cells) {
+    int i = r * width_ + c;
+    if (is_white(r, c) &&
+        std::find(removed.begin(), removed.end(), i) == removed.end())
+      removed.push_back(i);
+  }
+  if (removed.empty() || num_white_ - (int)removed.size() <= 1)
+    return false;
+
+  // Local test first; it does not cover removed cells that touch each other
+  bool adjacent = false;
+  for (size_t a = 0; a < removed.size(); a++) {
+    for (size_t b = a + 1; b < removed.size(); b++) {
+      int ra = removed[a] / width_, ca = removed[a] % width_;
+      int rb = removed[b] / width_, cb = removed[b] % width_;
+      if (std::abs(ra - rb) + std::abs(ca - cb) == 1)
+        adjacent = true;
     }
-    components.push_back(comp);
   }
+  if (!adjacent) {
+    bool local = true;
+    for (int i : removed)
+      local = local && ring_connected(i / width_, i % width_, removed);
+    if (local)
+      return false;
+  }
+
+  // Otherwise flood from one neighbour until every neighbour is reached
+  std::vector<int> targets;
+  for (int i : removed) {
+    for (int k = 0; k < 4; k++) {
+      int nr = i / width_ + DR4[k], nc = i % width_ + DC4[k];
+      if (white_at(nr, nc, removed))
+        targets.push_back(nr * width_ + nc);
+    }
+  }
+  std::sort(targets.begin(), targets.end());
+  targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+  if (targets.size() <= 1)
+    return false;
+
+  visited_.assign(white_.size(), 0);
+  queue_.clear();
+  queue_.push_back(targets[0]);
+  visited_[targets[0] >> 6] |= 1ULL << (targets[0] & 63);
+  size_t reached = 0;
+  for (size_t head = 0; head < queue_.size(); head++) {
+    int i = queue_[head];
+    if (std::binary_search(targets.begin(), targets.end(), i) &&
+        ++reached == targets.size())
+      return false;
+    for (int k = 0; k < 4; k++) {
+      int nr = i / width_ + DR4[k], nc = i % width_ + DC4[k];
+      if (!white_at(nr, nc, removed))
+        continue;
+      int j = nr * width_ + nc;
+      if ((visited_[j >> 6] >> (j & 63)) & 1)
+        continue;
+      visited_[j >> 6] |= 1ULL << (j & 63);
+      queue_.push_back(j);
+    }
+  }
+  return true;
+}
+
+std::vector<std::vector<std::pair<int, int>>> KakuroBoard::find_components() {
+  collect_white_cells();
+  GridConnectivity conn;
+  conn.build(*this);
+  std::vector<int> label = conn.labels();
+
+  std::vector<std::vector<std::pair<int, int>>> components(
+      conn.num_components());
+  for (Cell *cell : white_cells)
+    components[label[cell->r * width + cell->c]].push_back({cell->r, cell->c});
   return components;
 }
 
@@ -849,39 +1045,43 @@ bool KakuroBoard::try_remove_and_reconnect(int r, int c) {
   reset_values();
 
   // 3. Snapshot types for potential revert
-  std::vector<std::vector<CellType>> backup(height,
-                                            std::vector<CellType>(width));
-  for (int i = 0; i < height; i++) {
-    for (int j = 0; j < width; j++) {
-      backup[i][j] = grid[i][j].type;
-    }
-  }
+  std::vector<uint64_t> backup = white_rows;
 
   int sym_r = height - 1 - r;
   int sym_c = width - 1 - c;
-  Cell *sym_target = get_cell(sym_r, sym_c);
+
+  // On a connected board the removal usually only needs a local test
+  GridConnectivity conn;
+  conn.build(*this);
+  bool stays_connected = conn.num_components() == 1 &&
+                         !conn.would_disconnect({{r, c}, {sym_r, sym_c}});
 
   // 2. Perform removal
-  target->type = CellType::BLOCK;
-  sym_target->type = CellType::BLOCK;
+  set_block(r, c);
+  set_block(sym_r, sym_c);
 
 #if KAKURO_ENABLE_LOGGING
     logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                      GenerationLogger::SUBSTAGE_PRUNE_SINGLES,
                      "Removed single cells",
-                     get_grid_state());
+                     *this);
 
 #endif
 
-  auto components = find_components();
+  std::vector<int> label;
+  if (!stays_connected) {
+    conn.build(*this);
+    stays_connected = conn.num_components() <= 1;
+    label = conn.labels();
+  }
 
   // 3. If still connected or empty, we are done
-  if (components.size() <= 1) {
+  if (stays_connected) {
 #if KAKURO_ENABLE_LOGGING
     logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                      GenerationLogger::SUBSTAGE_PRUNE_SINGLES,
                      "Removed single cells without disconnecting",
-                     get_grid_state());
+                     *this);
 
 #endif
     collect_white_cells();
@@ -901,22 +1101,20 @@ bool KakuroBoard::try_remove_and_reconnect(int r, int c) {
         if ((i == r && j == c) || (i == sym_r && j == sym_c))
           continue;
 
-        std::unordered_set<int> touching_components;
-        int dr[] = {0, 0, 1, -1};
-        int dc[] = {1, -1, 0, 0};
+        // Interior cells always have four in-bounds neighbours
+        int first = -1;
+        bool touches_two = false;
         for (int k = 0; k < 4; k++) {
-          int ni = i + dr[k], nj = j + dc[k];
-          for (size_t comp_idx = 0; comp_idx < components.size(); comp_idx++) {
-            for (auto &p : components[comp_idx]) {
-              if (p.first == ni && p.second == nj) {
-                touching_components.insert(comp_idx);
-                break;
-              }
-            }
-          }
+          int comp = label[(i + DR4[k]) * width + (j + DC4[k])];
+          if (comp < 0)
+            continue;
+          if (first < 0)
+            first = comp;
+          else if (comp != first)
+            touches_two = true;
         }
 
-        if (touching_components.size() >= 2) {
+        if (touches_two) {
           bridge_candidates.push_back({i, j});
         }
       }
@@ -934,7 +1132,7 @@ bool KakuroBoard::try_remove_and_reconnect(int r, int c) {
     logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                      GenerationLogger::SUBSTAGE_PRUNE_SINGLES,
                      "Testing bridge cells",
-                     get_grid_state());
+                     *this);
 #endif
 
     // Final connectivity check
@@ -943,7 +1141,7 @@ bool KakuroBoard::try_remove_and_reconnect(int r, int c) {
       logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                        GenerationLogger::SUBSTAGE_PRUNE_SINGLES,
                        "Removed single cells with fixing disconnection",
-                       get_grid_state());
+                       *this);
 
 #endif
     collect_white_cells();
@@ -953,42 +1151,45 @@ bool KakuroBoard::try_remove_and_reconnect(int r, int c) {
   }
 
   for (int i = 0; i < height; i++) {
-    for (int j = 0; j < width; j++)
-      grid[i][j].type = backup[i][j];
+    for (uint64_t diff = white_rows[i] ^ backup[i]; diff; diff &= diff - 1) {
+      int j = lowest_bit_index(diff);
+      if ((backup[i] >> j) & 1)
+        set_white(i, j);
+      else
+        set_block(i, j);
+    }
   }
   collect_white_cells();
   identify_sectors();
   return false;
 }
 
+uint64_t KakuroBoard::single_run_cells(int r) const {
+  uint64_t row = white_rows[r];
+  uint64_t above = r > 0 ? white_rows[r - 1] : 0;
+  uint64_t below = r + 1 < height ? white_rows[r + 1] : 0;
+  uint64_t lone_h = ~(row << 1) & ~(row >> 1);
+  uint64_t lone_v = ~above & ~below;
+  uint64_t interior = low_bits(width - 1) & ~1ULL;
+  return row & (lone_h | lone_v) & interior;
+}
+
 bool KakuroBoard::prune_singles() {
   bool any_change = false;
   bool changed = true;
   int limit = 10;
 
+  collect_white_cells();
   while (changed && --limit > 0) {
     changed = false;
-    collect_white_cells();
-
-    for (size_t i = 0; i < white_cells.size(); i++) {
-      Cell *c = white_cells[i];
-      int h_nbs = 0;
-      if (get_cell(c->r, c->c - 1)->type == CellType::WHITE)
-        h_nbs++;
-      if (get_cell(c->r, c->c + 1)->type == CellType::WHITE)
-        h_nbs++;
-      int v_nbs = 0;
-      if (get_cell(c->r - 1, c->c)->type == CellType::WHITE)
-        v_nbs++;
-      if (get_cell(c->r + 1, c->c)->type == CellType::WHITE)
-        v_nbs++;
-
-      if (h_nbs == 0 || v_nbs == 0) {
-        if (try_remove_and_reconnect(c->r, c->c)) {
+    // Row-major like white_cells. A failed removal restores the grid, so the
+    // row's candidates stay valid until one succeeds.
+    for (int r = 1; r < height - 1 && !changed; r++) {
+      for (uint64_t lone = single_run_cells(r); lone && !changed;
+           lone &= lone - 1) {
+        if (try_remove_and_reconnect(r, lowest_bit_index(lone))) {
           changed = true;
           any_change = true;
-          collect_white_cells(); // List changed
-          break;
         }
       }
     }
@@ -1002,47 +1203,18 @@ bool KakuroBoard::break_single_runs() {
   while (changed) {
     changed = false;
     for (int r = 1; r < height - 1; r++) {
-      for (int c = 1; c < width - 1; c++) {
-        if (grid[r][c].type == CellType::WHITE) {
-          // Count horizontal run length (including this cell)
-          int h_len = 1;
-          // Look left
-          int check_c = c - 1;
-          while (check_c >= 0 && grid[r][check_c].type == CellType::WHITE) {
-            h_len++;
-            check_c--;
-          }
-          // Look right
-          check_c = c + 1;
-          while (check_c < width && grid[r][check_c].type == CellType::WHITE) {
-            h_len++;
-            check_c++;
-          }
-
-          // Count vertical run length (including this cell)
-          int v_len = 1;
-          // Look up
-          int check_r = r - 1;
-          while (check_r >= 0 && grid[check_r][c].type == CellType::WHITE) {
-            v_len++;
-            check_r--;
-          }
-          // Look down
-          check_r = r + 1;
-          while (check_r < height && grid[check_r][c].type == CellType::WHITE) {
-            v_len++;
-            check_r++;
-          }
-
-          // If this cell is part of a length-1 run in EITHER direction, remove
-          // it
-          if (h_len == 1 || v_len == 1) {
-            set_block(r, c);
-            set_block(height - 1 - r, width - 1 - c);
-            changed = true;
-            any_change = true;
-          }
-        }
+      // Removing a cell can leave later cells of the row alone, so the row is
+      // re-derived after each removal
+      for (int next = 1; next < width - 1;) {
+        uint64_t lone = single_run_cells(r) & ~low_bits(next);
+        if (!lone)
+          break;
+        int c = lowest_bit_index(lone);
+        set_block(r, c);
+        set_block(height - 1 - r, width - 1 - c);
+        changed = true;
+        any_change = true;
+        next = c + 1;
       }
     }
   }
@@ -1052,7 +1224,7 @@ bool KakuroBoard::break_single_runs() {
 #if KAKURO_ENABLE_LOGGING
     logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                      GenerationLogger::SUBSTAGE_BREAK_SINGLE_RUNS,
-                     "Broke single-cell runs", get_grid_state());
+                     "Broke single-cell runs", *this);
 #endif
   }
   return any_change;
@@ -1084,183 +1256,140 @@ bool KakuroBoard::check_connectivity() {
   if (white_cells.empty())
     return false;
 
-  std::unordered_set<std::pair<int, int>, PairHash> visited;
-  std::queue<Cell *> q;
-
-  q.push(white_cells[0]);
-  visited.insert({white_cells[0]->r, white_cells[0]->c});
-
-  int count = 0;
-  while (!q.empty()) {
-    Cell *curr = q.front();
-    q.pop();
-    count++;
-
-    int dr[] = {0, 0, 1, -1};
-    int dc[] = {1, -1, 0, 0};
-
-    for (int i = 0; i < 4; i++) {
-      Cell *n = get_cell(curr->r + dr[i], curr->c + dc[i]);
-      if (n && n->type == CellType::WHITE) {
-        if (visited.find({n->r, n->c}) == visited.end()) {
-          visited.insert({n->r, n->c});
-          q.push(n);
-        }
-      }
-    }
-  }
-  return count == (int)white_cells.size();
+  GridConnectivity conn;
+  conn.build(*this);
+  return conn.num_components() == 1;
 }
 
 int KakuroBoard::count_white_neighbors(Cell *cell) {
-  int n = 0;
-  int dr[] = {0, 0, 1, -1};
-  int dc[] = {1, -1, 0, 0};
-  for (int i = 0; i < 4; ++i) {
-    Cell *neighbor = get_cell(cell->r + dr[i], cell->c + dc[i]);
-    if (neighbor && neighbor->type == CellType::WHITE)
-      n++;
-  }
-  return n;
+  int r = cell->r, c = cell->c;
+  uint64_t side = (c > 0 ? 1ULL << (c - 1) : 0) |
+                  (c + 1 < width ? 1ULL << (c + 1) : 0);
+  uint64_t ends = (r > 0 ? 1ULL << (r - 1) : 0) |
+                  (r + 1 < height ? 1ULL << (r + 1) : 0);
+  return popcount64(white_rows[r] & side) + popcount64(white_cols[c] & ends);
 }
 
 bool KakuroBoard::break_large_patches(int size) {
   bool changed_overall = false;
   // Standard Kakuro usually treats 0 and width-1 as borders.
   // We want to avoid creating 1-cell wide corridors at indices 1 and width-2.
+  if (size <= 0 || size >= width || size >= height)
+    return false;
+  uint64_t patch_cols = low_bits(width - size + 1) & ~1ULL;
 
   for (int iteration = 0; iteration < 50; iteration++) {
-    bool found = false;
-
-    for (int r = 1; r <= height - size && !found; r++) {
-      for (int c = 1; c <= width - size && !found; c++) {
-
-        // 1. Identify a large patch of WHITE cells
-        bool is_patch = true;
-        std::vector<Cell *> patch_cells;
-
-        for (int ir = 0; ir < size && is_patch; ir++) {
-          for (int ic = 0; ic < size && is_patch; ic++) {
-            // Boundary safety check
-            if (r + ir >= height || c + ic >= width) {
-              is_patch = false;
-              continue;
-            }
-
-            Cell *cell = &grid[r + ir][c + ic];
-            patch_cells.push_back(cell);
-            if (cell->type != CellType::WHITE) {
-              is_patch = false;
-            }
-          }
-        }
+    // 1. Identify the first large patch of WHITE cells. Bit c of a row's
+    // `runs` is set when `size` cells from column c on are white; ANDing
+    // `size` consecutive rows leaves the top-left corners of white squares.
+    int patch_r = -1, patch_c = -1;
+    for (int r = 1; r <= height - size && patch_r < 0; r++) {
+      uint64_t corners = patch_cols;
+      for (int ir = 0; ir < size && corners; ir++) {
+        uint64_t row = white_rows[r + ir];
+        uint64_t runs = row;
+        for (int k = 1; k < size; k++)
+          runs &= row >> k;
+        corners &= runs;
+      }
+      if (corners) {
+        patch_r = r;
+        patch_c = lowest_bit_index(corners);
+      }
+    }
+    if (patch_r < 0)
+      break;
 
-        if (is_patch && !patch_cells.empty()) {
-          found = true;
-
-          std::vector<Cell *> safe_candidates;
-          std::vector<Cell *> priority_candidates;
-
-          // 2. Filter candidates to prevent edge artifacts
-          for (Cell *cell : patch_cells) {
-            int cr = cell->r;
-            int cc = cell->c;
-
-            // Check if placing a block here creates a 1-wide gap at the edge
-            bool creates_gap = false;
-
-            // Top Edge: If at row 2, and row 1 is white -> Gap
-            if (cr == 2 && grid[1][cc].type == CellType::WHITE)
-              creates_gap = true;
-            // Left Edge
-            if (cc == 2 && grid[cr][1].type == CellType::WHITE)
-              creates_gap = true;
-            // Bottom Edge
-            if (cr == height - 3 &&
-                grid[height - 2][cc].type == CellType::WHITE)
-              creates_gap = true;
-            // Right Edge
-            if (cc == width - 3 && grid[cr][width - 2].type == CellType::WHITE)
-              creates_gap = true;
-
-            // Check Symmetric counterpart for the same issues (Board must stay
-            // symmetric)
-            int sym_r = height - 1 - cr;
-            int sym_c = width - 1 - cc;
-
-            if (sym_r == 2 && grid[1][sym_c].type == CellType::WHITE)
-              creates_gap = true;
-            if (sym_c == 2 && grid[sym_r][1].type == CellType::WHITE)
-              creates_gap = true;
-            if (sym_r == height - 3 &&
-                grid[height - 2][sym_c].type == CellType::WHITE)
-              creates_gap = true;
-            if (sym_c == width - 3 &&
-                grid[sym_r][width - 2].type == CellType::WHITE)
-              creates_gap = true;
-
-            if (!creates_gap) {
-              safe_candidates.push_back(cell);
-            }
-          }
+    std::vector<Cell *> patch_cells;
+    for (int ir = 0; ir < size; ir++) {
+      for (int ic = 0; ic < size; ic++)
+        patch_cells.push_back(&grid[patch_r + ir][patch_c + ic]);
+    }
 
-          // 3. Find candidates that touch existing blocks (Connectivity
-          // preference) We only look within 'safe_candidates' first.
-          auto &source_list =
-              safe_candidates.empty() ? patch_cells : safe_candidates;
-
-          for (Cell *cell : source_list) {
-            bool has_block_neighbor = false;
-            std::vector<std::pair<int, int>> dirs = {
-                {0, 1}, {0, -1}, {1, 0}, {-1, 0}};
-
-            for (auto [dr, dc] : dirs) {
-              Cell *n = get_cell(cell->r + dr, cell->c + dc);
-              if (n && n->type == CellType::BLOCK) {
-                has_block_neighbor = true;
-                break;
-              }
-            }
-            if (has_block_neighbor) {
-              priority_candidates.push_back(cell);
-            }
-          }
+    std::vector<Cell *> safe_candidates;
+    std::vector<Cell *> priority_candidates;
+
+    // 2. Filter candidates to prevent edge artifacts
+    for (Cell *cell : patch_cells) {
+      int cr = cell->r;
+      int cc = cell->c;
+
+      // Check if placing a block here creates a 1-wide gap at the edge
+      bool creates_gap = false;
+
+      // Top Edge: If at row 2, and row 1 is white -> Gap
+      if (cr == 2 && is_white(1, cc))
+        creates_gap = true;
+      // Left Edge
+      if (cc == 2 && is_white(cr, 1))
+        creates_gap = true;
+      // Bottom Edge
+      if (cr == height - 3 && is_white(height - 2, cc))
+        creates_gap = true;
+      // Right Edge
+      if (cc == width - 3 && is_white(cr, width - 2))
+        creates_gap = true;
+
+      // Check Symmetric counterpart for the same issues (Board must stay
+      // symmetric)
+      int sym_r = height - 1 - cr;
+      int sym_c = width - 1 - cc;
+
+      if (sym_r == 2 && is_white(1, sym_c))
+        creates_gap = true;
+      if (sym_c == 2 && is_white(sym_r, 1))
+        creates_gap = true;
+      if (sym_r == height - 3 && is_white(height - 2, sym_c))
+        creates_gap = true;
+      if (sym_c == width - 3 && is_white(sym_r, width - 2))
+        creates_gap = true;
+
+      if (!creates_gap) {
+        safe_candidates.push_back(cell);
+      }
+    }
 
-          // 4. Select Target
-          Cell *target = nullptr;
-
-          if (!priority_candidates.empty()) {
-            std::uniform_int_distribution<> dist(
-                0, (int)priority_candidates.size() - 1);
-            target = priority_candidates[dist(rng)];
-          } else if (!safe_candidates.empty()) {
-            std::uniform_int_distribution<> dist(
-                0, (int)safe_candidates.size() - 1);
-            target = safe_candidates[dist(rng)];
-          } else {
-            // Fallback: If absolutely necessary, pick any cell to break the
-            // loop, preferably the center of the patch to minimize edge damage.
-            target = patch_cells[patch_cells.size() / 2];
-          }
+    // 3. Find candidates that touch existing blocks (Connectivity
+    // preference) We only look within 'safe_candidates' first.
+    auto &source_list = safe_candidates.empty() ? patch_cells : safe_candidates;
 
-          // 5. Apply Block and Symmetry
-          if (target) {
-            set_block(target->r, target->c);
-            set_block(height - 1 - target->r, width - 1 - target->c);
-            changed_overall = true;
-          }
+    for (Cell *cell : source_list) {
+      for (int k = 0; k < 4; k++) {
+        int nr = cell->r + DR4[k], nc = cell->c + DC4[k];
+        if (nr >= 0 && nr < height && nc >= 0 && nc < width &&
+            !is_white(nr, nc)) {
+          priority_candidates.push_back(cell);
+          break;
         }
       }
     }
 
-    if (!found)
-      break;
+    // 4. Select Target
+    Cell *target = nullptr;
+
+    if (!priority_candidates.empty()) {
+      std::uniform_int_distribution<> dist(0,
+                                           (int)priority_candidates.size() - 1);
+      target = priority_candidates[dist(rng)];
+    } else if (!safe_candidates.empty()) {
+      std::uniform_int_distribution<> dist(0, (int)safe_candidates.size() - 1);
+      target = safe_candidates[dist(rng)];
+    } else {
+      // Fallback: If absolutely necessary, pick any cell to break the
+      // loop, preferably the center of the patch to minimize edge damage.
+      target = patch_cells[patch_cells.size() / 2];
+    }
+
+    // 5. Apply Block and Symmetry
+    set_block(target->r, target->c);
+    set_block(height - 1 - target->r, width - 1 - target->c);
+    changed_overall = true;
   }
 #if KAKURO_ENABLE_LOGGING
   if (changed_overall) {
     logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                      GenerationLogger::SUBSTAGE_BREAK_PATCHES,
-                     "Broke large patches", get_grid_state());
+                     "Broke large patches", *this);
   }
 #endif
   return changed_overall;
@@ -1295,7 +1424,7 @@ bool KakuroBoard::stabilize_grid(bool gentle) {
                    GenerationLogger::SUBSTAGE_STABILIZE_GRID,
                    "Grid stabilized after " + std::to_string(iterations) +
                        " iterations",
-                   get_grid_state());
+                   *this);
 #endif
   collect_white_cells();
   identify_sectors();
@@ -1364,7 +1493,7 @@ bool KakuroBoard::fix_invalid_runs() {
   if (changed && KAKURO_ENABLE_LOGGING) {
     logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                      GenerationLogger::SUBSTAGE_FIX_INVALID_RUNS,
-                     "Fixed invalid runs (too short/long)", get_grid_state());
+                     "Fixed invalid runs (too short/long)", *this);
   }
   return changed;
 }
@@ -1400,32 +1529,24 @@ void KakuroBoard::block_sym(Cell *cell) {
 bool KakuroBoard::ensure_connectivity() {
   PROFILE_FUNCTION(logger);
   collect_white_cells();
-  auto components = find_components(); // This line replaces the manual component finding logic
   if (white_cells.empty())
     return false;
-  std::unordered_set<std::pair<int, int>, PairHash> white_set;
-  for (auto c : white_cells)
-    white_set.insert({c->r, c->c});
 
-  // The manual component finding logic that was here is now replaced by find_components()
-  // std::vector<std::vector<std::pair<int, int>>> components;
-  // std::unordered_set<std::pair<int, int>, PairHash> visited;
-  // ... (rest of the manual component finding logic)
+  GridConnectivity conn;
+  conn.build(*this);
+  std::vector<int> label = conn.labels();
 
-  if (components.empty())
-    return false;
-
-  auto largest = *std::max_element(components.begin(), components.end(),
-                                   [](const auto &a, const auto &b) {
-                                     return (int)a.size() < (int)b.size();
-                                   });
-  std::unordered_set<std::pair<int, int>, PairHash> largest_set(largest.begin(),
-                                                                largest.end());
+  // Keep the largest component (the first one on ties)
+  std::vector<int> sizes(conn.num_components(), 0);
+  for (Cell *cell : white_cells)
+    sizes[label[cell->r * width + cell->c]]++;
+  int largest = (int)(std::max_element(sizes.begin(), sizes.end()) -
+                      sizes.begin());
 
   bool changed = false;
   int filled_count = 0;
   for (auto c : white_cells) {
-    if (!largest_set.count({c->r, c->c})) {
+    if (label[c->r * width + c->c] != largest) {
       set_block(c->r, c->c);
       set_block(height - 1 - c->r, width - 1 - c->c);
       changed = true;
@@ -1439,7 +1560,7 @@ bool KakuroBoard::ensure_connectivity() {
                      GenerationLogger::SUBSTAGE_CONNECTIVITY_CHECK,
                      "Removed disconnected components (" +
                          std::to_string(filled_count) + " cells)",
-                     get_grid_state());
+                     *this);
   }
 #endif
   return changed;
@@ -1447,68 +1568,74 @@ bool KakuroBoard::ensure_connectivity() {
 
 void KakuroBoard::collect_white_cells() {
   white_cells.clear();
+  // Same walk as sync_white_bits()
+  std::array<uint64_t, MAX_DIMENSION> rows{};
   for (int r = 0; r < height; r++) {
     for (int c = 0; c < width; c++) {
       if (grid[r][c].type == CellType::WHITE) {
+        grid[r][c].idx = (int)white_cells.size();
         white_cells.push_back(&grid[r][c]);
+        rows[r] |= 1ULL << c;
+      } else {
+        grid[r][c].idx = -1;
       }
     }
   }
+  assign_white_rows(rows.data());
 }
 
 void KakuroBoard::identify_sectors() {
   PROFILE_FUNCTION(logger);
-  // Clear existing shared_ptr lists
-  sectors_h.clear();
-  sectors_v.clear();
-  for (auto c : white_cells) {
-    c->sector_h = nullptr;
-    c->sector_v = nullptr;
+  for (uint64_t rows = dirty_rows_; rows; rows &= rows - 1) {
+    int r = lowest_bit_index(rows);
+    sectors_h.rebuild_line(r, white_rows[r]);
   }
-
-  // Horizontal
-  for (int r = 0; r < height; r++) {
-    auto current_sec = std::make_shared<std::vector<Cell *>>();
-    for (int c = 0; c < width; c++) {
-      if (grid[r][c].type == CellType::WHITE) {
-        current_sec->push_back(&grid[r][c]);
-      } else {
-        if (!current_sec->empty()) {
-          sectors_h.push_back(current_sec);
-          for (auto sc : *current_sec)
-            sc->sector_h = current_sec;
-          current_sec = std::make_shared<std::vector<Cell *>>();
-        }
-      }
-    }
-    if (!current_sec->empty()) {
-      sectors_h.push_back(current_sec);
-      for (auto sc : *current_sec)
-        sc->sector_h = current_sec;
-    }
+  for (uint64_t cols = dirty_cols_; cols; cols &= cols - 1) {
+    int c = lowest_bit_index(cols);
+    sectors_v.rebuild_line(c, white_cols[c]);
   }
+  dirty_rows_ = 0;
+  dirty_cols_ = 0;
+}
 
-  // Vertical (Same logic for sectors_v...)
-  for (int c = 0; c < width; c++) {
-    auto current_sec = std::make_shared<std::vector<Cell *>>();
-    for (int r = 0; r < height; r++) {
-      if (grid[r][c].type == CellType::WHITE) {
-        current_sec->push_back(&grid[r][c]);
-      } else {
-        if (!current_sec->empty()) {
-          sectors_v.push_back(current_sec);
-          for (auto sc : *current_sec)
-            sc->sector_v = current_sec;
-          current_sec = std::make_shared<std::vector<Cell *>>();
-        }
-      }
-    }
-    if (!current_sec->empty()) {
-      sectors_v.push_back(current_sec);
-      for (auto sc : *current_sec)
-        sc->sector_v = current_sec;
-    }
+// ============================================================================
+// SECTOR TABLE
+// ============================================================================
+
+void SectorTable::reset(int lines, int line_length, int Cell::*sector_of) {
+  line_length_ = line_length;
+  // Runs need a block between them
+  slots_per_line_ = (line_length + 1) / 2;
+  count_ = 0;
+  sector_of_ = sector_of;
+  cells_.assign((size_t)lines * line_length, nullptr);
+  offset_.assign((size_t)lines * slots_per_line_, 0);
+  length_.assign(offset_.size(), 0);
+  line_count_.assign(lines, 0);
+}
+
+void SectorTable::rebuild_line(int line, uint64_t white) {
+  int base = line * line_length_;
+  int slot = line * slots_per_line_;
+  for (int p = 0; p < line_length_; p++)
+    cells_[base + p]->*sector_of_ = -1;
+  std::fill_n(length_.begin() + slot, line_count_[line], 0);
+  count_ -= line_count_[line];
+
+  int k = 0;
+  while (white) {
+    int start = lowest_bit_index(white);
+    uint64_t ahead = ~(white >> start);
+    int len = ahead ? lowest_bit_index(ahead) : 64 - start;
+    offset_[slot + k] = base + start;
+    length_[slot + k] = len;
+    for (int p = start; p < start + len; p++)
+      cells_[base + p]->*sector_of_ = slot + k;
+    k++;
+    white = start + len < 64 ? white & (~0ULL << (start + len)) : 0;
   }
+  line_count_[line] = k;
+  count_ += k;
 }
 
 std::vector<std::vector<std::unordered_map<std::string, std::string>>>
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <bitset>
 #include <chrono>
+#include <condition_variable>
 #include <cmath>
 #include <deque>
 #include <filesystem>
@@ -17,12 +18,17 @@
 #include <random>
 #include <sstream>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 #include <array>
+#include <atomic>
 #include <queue>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 #ifdef _MSC_VER
 #include <intrin.h>
@@ -39,13 +45,185 @@ inline int popcount9(uint16_t mask) {
 #endif
 }
 
+inline int popcount64(uint64_t bits) {
+#ifdef _MSC_VER
+  return (int)__popcnt64(bits);
+#else
+  return __builtin_popcountll(bits);
+#endif
+}
+
+inline int lowest_bit_index(uint64_t bits) {
+#ifdef _MSC_VER
+  unsigned long idx;
+  _BitScanForward64(&idx, bits);
+  return (int)idx;
+#else
+  return __builtin_ctzll(bits);
+#endif
+}
+
+// ============================================================================
+// PARTITION TABLES
+// Every (sum, length) digit combination is enumerated once at compile time.
+// A partition is stored as a digit bitmask (bit d set = digit d used), the
+// same representation the candidate masks use.
+// ============================================================================
+constexpr int PARTITION_MAX_SUM = 45;
+constexpr int PARTITION_MAX_LEN = 9;
+
+struct PartitionRange {
+  const uint16_t *first;
+  const uint16_t *last;
+  constexpr const uint16_t *begin() const { return first; }
+  constexpr const uint16_t *end() const { return last; }
+  constexpr int size() const { return (int)(last - first); }
+  constexpr bool empty() const { return first == last; }
+};
+
+struct PartitionTable {
+  static constexpr int KEYS = (PARTITION_MAX_SUM + 1) * (PARTITION_MAX_LEN + 1);
+
+  std::array<uint16_t, 512> masks{};       // all subsets of 1..9, grouped by key
+  std::array<uint16_t, KEYS + 1> offset{}; // start of each key's group in masks
+  std::array<uint16_t, KEYS> union_mask{}; // digits used by any partition
+
+  static constexpr int key(int sum, int len) {
+    return sum * (PARTITION_MAX_LEN + 1) + len;
+  }
+
+  constexpr PartitionTable() {
+    std::array<uint16_t, KEYS> count{};
+    for (int subset = 0; subset < 512; ++subset) {
+      int sum = 0, len = 0;
+      for (int d = 1; d <= 9; ++d) {
+        if (subset & (1 << (d - 1))) {
+          sum += d;
+          len++;
+        }
+      }
+      count[key(sum, len)]++;
+    }
+    for (int k = 0; k < KEYS; ++k)
+      offset[k + 1] = offset[k] + count[k];
+
+    std::array<uint16_t, KEYS> fill{};
+    for (int subset = 0; subset < 512; ++subset) {
+      int sum = 0, len = 0;
+      for (int d = 1; d <= 9; ++d) {
+        if (subset & (1 << (d - 1))) {
+          sum += d;
+          len++;
+        }
+      }
+      int k = key(sum, len);
+      uint16_t mask = (uint16_t)(subset << 1);
+      masks[offset[k] + fill[k]++] = mask;
+      union_mask[k] |= mask;
+    }
+  }
+};
+
+inline constexpr PartitionTable PARTITIONS{};
+
+constexpr bool partition_key_valid(int sum, int len) {
+  return sum >= 0 && sum <= PARTITION_MAX_SUM && len >= 0 &&
+         len <= PARTITION_MAX_LEN;
+}
+
+// All partitions of `sum` into `len` distinct digits, in ascending mask order.
+constexpr PartitionRange partitions_of(int sum, int len) {
+  if (!partition_key_valid(sum, len))
+    return {nullptr, nullptr};
+  int k = PartitionTable::key(sum, len);
+  const uint16_t *base = PARTITIONS.masks.data();
+  return {base + PARTITIONS.offset[k], base + PARTITIONS.offset[k + 1]};
+}
+
+constexpr int partition_count(int sum, int len) {
+  if (!partition_key_valid(sum, len))
+    return 0;
+  int k = PartitionTable::key(sum, len);
+  return PARTITIONS.offset[k + 1] - PARTITIONS.offset[k];
+}
+
+// Digits that appear in at least one partition of (sum, len).
+constexpr uint16_t partition_union(int sum, int len) {
+  return partition_key_valid(sum, len)
+             ? PARTITIONS.union_mask[PartitionTable::key(sum, len)]
+             : 0;
+}
+
+// Digits that can still be placed in a sector of `len` cells summing to
+// `sum` when the digits in `used_mask` are already placed in it.
+constexpr uint16_t partition_allowed(int sum, int len, uint16_t used_mask) {
+  if (used_mask == 0)
+    return partition_union(sum, len);
+  uint16_t allowed = 0;
+  for (uint16_t p : partitions_of(sum, len)) {
+    if ((p & used_mask) == used_mask)
+      allowed |= p;
+  }
+  return allowed & ~used_mask;
+}
+
+static_assert(partition_count(0, 0) == 1, "empty partition");
+static_assert(partition_count(45, 9) == 1, "full partition");
+static_assert(partition_count(10, 3) == 4, "partition count");
+static_assert(partition_union(3, 2) == ((1 << 1) | (1 << 2)), "union mask");
+static_assert(partition_allowed(10, 3, 1 << 1) ==
+                  ((1 << 2) | (1 << 3) | (1 << 4) | (1 << 5) | (1 << 6) | (1 << 7)),
+              "allowed digits");
+
+// ============================================================================
+// SECTOR KERNEL
+// The per-sector candidate arithmetic shared by the difficulty estimator and
+// the uniqueness checker. A sector's masks are gathered into one block of 16
+// lanes (one AVX2 register, two NEON registers), narrowed there and scattered
+// back by the caller. The backend is picked once, at first use.
+// ============================================================================
+struct alignas(32) SectorMasks {
+  static constexpr int LANES = 16;
+  std::array<uint16_t, LANES> mask{}; // lanes past `size` stay zero
+  int size = 0;
+};
+
+static_assert(PARTITION_MAX_LEN <= SectorMasks::LANES, "sector fits one block");
+
+struct SectorSummary {
+  uint16_t singles = 0; // union of the masks with exactly one candidate
+  int single_count = 0;
+  int min_sum = 0; // lowest candidates summed, an empty cell counts as 10
+  int max_sum = 0; // highest candidates summed, an empty cell counts as 0
+};
+
+struct SectorKernel {
+  const char *name;
+  SectorSummary (*summarize)(const SectorMasks &masks);
+  // Keeps the digits that leave `target` reachable for the other cells,
+  // given the sums summarize() returned for these masks
+  void (*bound_to_sum)(SectorMasks &masks, int target,
+                       const SectorSummary &summary);
+  // Removes `digits` from every cell with more than one candidate
+  void (*remove_from_open)(SectorMasks &masks, uint16_t digits);
+};
+
+const SectorKernel &sector_kernel();
+
 // ============================================================================
 // LOGGING CONFIGURATION
-// Set to 1 to enable detailed generation logging, 0 to disable
+// Set to 1 to enable detailed generation logging, 0 to disable. Each switch
+// can also be overridden from the build (e.g. -DKAKURO_ENABLE_LOGGING=0).
 // ============================================================================
+#ifndef KAKURO_ENABLE_LOGGING
 #define KAKURO_ENABLE_LOGGING 1
+#endif
+#ifndef KAKURO_ENABLE_DEBUG_LOGGING
 #define KAKURO_ENABLE_DEBUG_LOGGING 0
+#endif
+#ifndef KAKURO_ENABLE_PROFILE_LOGGING
 #define KAKURO_ENABLE_PROFILE_LOGGING 0
+#endif
 #define LOG_DEBUG(msg) do { if (KAKURO_ENABLE_DEBUG_LOGGING) { std::cerr << "[DEBUG] " << msg << std::endl; } } while (0)
 #define LOG_INFO(msg) do { if (KAKURO_ENABLE_LOGGING) { std::cerr << "[INFO] " << msg << std::endl; } } while (0)
 #define LOG_ERROR(msg) do { std::cerr << "[ERROR] " << msg << std::endl; } while(0)
@@ -103,13 +281,108 @@ struct DifficultyResult {
   std::vector<std::vector<std::vector<std::optional<int>>>> solutions;
 };
 
+enum class CellType { BLOCK, WHITE };
+
 struct LogCell {
-  std::string type;
+  CellType type;
   int value;
   int clue_h;
   int clue_v;
+
+  bool operator==(const LogCell &o) const {
+    return type == o.type && value == o.value && clue_h == o.clue_h &&
+           clue_v == o.clue_v;
+  }
+  bool operator!=(const LogCell &o) const { return !(*this == o); }
 };
 
+// ============================================================================
+// LOG OUTPUT
+// ============================================================================
+
+// OFF: no log files are opened. STAGE: parameters, stage start/complete/
+// failure and results only. FULL: every step plus profile timings.
+enum class LogLevel { OFF, STAGE, FULL };
+
+// What a producer does when the async ring buffer is full
+enum class LogOverflow { DROP, BLOCK };
+
+// One open log file. Shared between a logger and the records it has queued,
+// so the file stays open until the last queued line is written.
+struct LogSink {
+  std::ofstream out;
+};
+
+// Process-wide background writer for GenerationLogger. Producers push
+// finished lines into a bounded lock-free ring; a single writer thread
+// drains it in batches and flushes each touched file once per batch.
+class AsyncLogWriter {
+public:
+  static constexpr size_t DEFAULT_CAPACITY = 8192;
+
+  static AsyncLogWriter &instance();
+  ~AsyncLogWriter();
+
+  // Capacity only takes effect before the first record is queued
+  void configure(size_t capacity, LogOverflow overflow);
+
+  // Returns false if the record was dropped because the ring was full
+  bool push(std::shared_ptr<LogSink> sink, std::string line);
+
+  // Blocks until every record queued before the call has been written
+  void flush();
+
+  uint64_t dropped() const { return dropped_.load(); }
+
+private:
+  AsyncLogWriter() = default;
+  AsyncLogWriter(const AsyncLogWriter &) = delete;
+  AsyncLogWriter &operator=(const AsyncLogWriter &) = delete;
+
+  struct Slot {
+    std::atomic<size_t> seq{0};
+    std::shared_ptr<LogSink> sink;
+    std::string line;
+  };
+
+  void ensure_started();
+  void run();
+  size_t write_batch(); // Into the stream buffers of the sinks
+  void flush_sinks();   // Flushes dirty_ and publishes written_
+  bool has_record() const; // Writer only: the slot at tail_ is readable
+  void wake_writer();      // After a push, if the writer sleeps
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_ = 0;
+  size_t capacity_ = DEFAULT_CAPACITY;
+  std::atomic<LogOverflow> overflow_{LogOverflow::BLOCK};
+  std::atomic<bool> started_{false};
+  std::atomic<bool> stop_{false};
+
+  alignas(64) std::atomic<size_t> head_{0}; // Next enqueue position
+  alignas(64) size_t tail_ = 0;             // Next dequeue (writer only)
+  std::vector<std::shared_ptr<LogSink>> dirty_; // Writer only: unflushed
+  alignas(64) std::atomic<uint64_t> consumed_{0}; // Positions freed
+  std::atomic<uint64_t> written_{0};              // Positions flushed
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<int> flush_waiters_{0};
+
+  // The writer sleeps on wake_ only after announcing it in writer_idle_, so
+  // producers take the mutex just to wake an idle writer. written_cv_ is
+  // notified after every batch and flush for flush() and producers blocked
+  // on a full ring.
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  std::condition_variable written_cv_;
+  std::atomic<bool> writer_idle_{false};
+
+  std::mutex start_mutex_;
+  std::thread writer_;
+};
+
+class KakuroBoard;
+class CandidateMap;
+
 class GenerationLogger {
 public:
   // Stages (Aliases for efficiency)
@@ -161,12 +434,31 @@ public:
   static constexpr const char *SUBSTAGE_TIMING = "tm";     // timing
 
 private:
-  std::ofstream log_file_;
-  std::ofstream prof_file_;
+  std::shared_ptr<LogSink> log_sink_;
+  std::shared_ptr<LogSink> prof_sink_;
   int step_id_ = 0;
   bool enabled_ = false;
   std::string current_kakuro_id_;
   std::chrono::steady_clock::time_point last_step_time_;
+  static inline std::atomic<uint64_t> next_sequence_{0};
+
+  // Process-wide runtime switches, see configure()
+  static inline std::atomic<LogLevel> level_{LogLevel::FULL};
+  static inline std::atomic<bool> async_{false};
+
+  // Records are formatted into reused per-logger buffers so that stream
+  // formatting state carries over between records exactly as it did when
+  // writing straight to the files
+  std::ostringstream log_buf_;
+  std::ostringstream prof_buf_;
+
+  // Last grid written to the step log. Grids are written as deltas against
+  // it, with a full keyframe every KEYFRAME_INTERVAL grids.
+  static constexpr int KEYFRAME_INTERVAL = 64;
+  std::vector<LogCell> last_frame_;
+  size_t frame_w_ = 0;
+  size_t frame_h_ = 0;
+  int frames_since_keyframe_ = 0;
 
   static std::string escape_json(const std::string &s) {
     std::ostringstream oss;
@@ -187,17 +479,187 @@ private:
     return oss.str();
   }
 
+  // Stage-level records: start/complete/failure and final results, i.e.
+  // everything except per-step progress
+  static bool is_stage_substage(const std::string &substage) {
+    return substage == SUBSTAGE_START || substage == SUBSTAGE_COMPLETE ||
+           substage == SUBSTAGE_FAILED ||
+           substage == SUBSTAGE_VALIDATION_FAILED ||
+           substage == SUBSTAGE_REPAIR_ATTEMPT ||
+           substage == "uniqueness_conflict" ||
+           substage == "ambiguity_rejection";
+  }
+
+  // Hands one finished JSONL line to its file, synchronously or through the
+  // background writer. Returns false if the line was dropped.
+  static bool emit(const std::shared_ptr<LogSink> &sink,
+                   std::ostringstream &buf) {
+    if (async_.load(std::memory_order_relaxed))
+      return AsyncLogWriter::instance().push(sink, buf.str());
+    sink->out << buf.str();
+    sink->out.flush();
+    return true;
+  }
+
+  static std::ostringstream &begin_record(std::ostringstream &buf) {
+    buf.str("");
+    buf.clear();
+    return buf;
+  }
+
+  // Grid writers take the grid as cell(r, c) -> LogCell, so a board can be
+  // read in place instead of through a snapshot
+  template <typename CellFn>
+  static void write_grid(std::ostream &os, size_t h, size_t w,
+                         const CellFn &cell) {
+    os << ",\"wh\":[" << w << "," << h << "]";
+
+    // Log White Cells
+    os << ",\"g\":[";
+    bool first_cell = true;
+    for (size_t r = 0; r < h; r++) {
+      for (size_t c = 0; c < w; c++) {
+        LogCell lc = cell(r, c);
+        if (lc.type == CellType::WHITE) {
+          if (!first_cell) os << ",";
+          os << "[" << r << "," << c << "," << lc.value << "]";
+          first_cell = false;
+        }
+      }
+    }
+    os << "]";
+
+    // Log Block Clues
+    os << ",\"b\":[";
+    first_cell = true;
+    for (size_t r = 0; r < h; r++) {
+      for (size_t c = 0; c < w; c++) {
+        LogCell lc = cell(r, c);
+        if (lc.type == CellType::BLOCK && (lc.clue_h > 0 || lc.clue_v > 0)) {
+          if (!first_cell) os << ",";
+          os << "[" << r << "," << c << "," << lc.clue_h << "," << lc.clue_v << "]";
+          first_cell = false;
+        }
+      }
+    }
+    os << "]";
+  }
+
+  template <typename CellFn>
+  void store_frame(size_t h, size_t w, const CellFn &cell) {
+    frame_h_ = h;
+    frame_w_ = w;
+    last_frame_.resize(h * w);
+    for (size_t r = 0; r < h; r++)
+      for (size_t c = 0; c < w; c++)
+        last_frame_[r * w + c] = cell(r, c);
+    frames_since_keyframe_ = 0;
+  }
+
+  // Writes a keyframe ("wh", "g", "b") or only the cells that changed since
+  // the last grid: "dg" sets cells to WHITE with a value, "db" sets cells to
+  // BLOCK with their clues.
+  template <typename CellFn>
+  void write_frame(std::ostream &os, size_t h, size_t w, const CellFn &cell) {
+    if (last_frame_.empty() || frame_h_ != h || frame_w_ != w ||
+        ++frames_since_keyframe_ >= KEYFRAME_INTERVAL) {
+      write_grid(os, h, w, cell);
+      store_frame(h, w, cell);
+      return;
+    }
+
+    std::ostringstream blocks;
+    os << ",\"dg\":[";
+    bool first_white = true;
+    bool first_block = true;
+    for (size_t r = 0; r < h; r++) {
+      for (size_t c = 0; c < w; c++) {
+        LogCell lc = cell(r, c);
+        LogCell &prev = last_frame_[r * w + c];
+        if (lc == prev)
+          continue;
+        prev = lc;
+        if (lc.type == CellType::WHITE) {
+          if (!first_white) os << ",";
+          os << "[" << r << "," << c << "," << lc.value << "]";
+          first_white = false;
+        } else {
+          if (!first_block) blocks << ",";
+          blocks << "[" << r << "," << c << "," << lc.clue_h << "," << lc.clue_v << "]";
+          first_block = false;
+        }
+      }
+    }
+    os << "],\"db\":[" << blocks.str() << "]";
+  }
+
+  // Starts a step record; the grid and end_step() follow
+  std::ostringstream &begin_step(const std::string &stage,
+                                 const std::string &substage,
+                                 const std::string &message) {
+    auto now = std::chrono::steady_clock::now();
+    double duration_ms = std::chrono::duration<double, std::milli>(now - last_step_time_).count();
+    last_step_time_ = now;
+
+    // JSONL: Each entry is a single-line JSON object
+    std::ostringstream &line = begin_record(log_buf_);
+    line << "{\"id\":" << step_id_++
+         << ",\"dur\":" << std::fixed << std::setprecision(2) << duration_ms
+         << ",\"s\":\"" << stage << "\""
+         << ",\"ss\":\"" << substage << "\""
+         << ",\"m\":\"" << escape_json(message) << "\"";
+    return line;
+  }
+
+  void end_step(std::ostringstream &line, const std::string &extra_data) {
+    if (!extra_data.empty()) {
+      line << ",\"d\":" << extra_data;
+    }
+    line << "}\n"; // End of line for JSONL
+    if (!emit(log_sink_, line))
+      last_frame_.clear(); // A lost delta would corrupt replay
+  }
+
 public:
   GenerationLogger() = default;
 
   ~GenerationLogger() { close(); }
 
+  // Runtime switches for every logger in the process. Loggers that are
+  // already open keep their files; the level applies to new records.
+  static void configure(LogLevel level, bool async = false,
+                        size_t buffer_records = AsyncLogWriter::DEFAULT_CAPACITY,
+                        LogOverflow overflow = LogOverflow::BLOCK) {
+    level_ = level;
+    if (async)
+      AsyncLogWriter::instance().configure(buffer_records, overflow);
+    else if (async_)
+      AsyncLogWriter::instance().flush(); // Keep line order when switching
+    async_ = async;
+  }
+  static LogLevel level() { return level_.load(); }
+
+  // Waits until the background writer has written every queued record
+  static void flush_all() { AsyncLogWriter::instance().flush(); }
+
   bool is_enabled() const { return enabled_; }
 
+  // Whether a step record with this substage would be written, so callers
+  // can skip building the data of a record the level drops
+  bool wants_step(const std::string &substage) const {
+    if (!enabled_ || !log_sink_)
+      return false;
+    LogLevel level = level_.load(std::memory_order_relaxed);
+    return level != LogLevel::OFF &&
+           (level != LogLevel::STAGE || is_stage_substage(substage));
+  }
+
   void start_new_kakuro(const std::string &log_dir = "kakuro_logs") {
 #if KAKURO_ENABLE_LOGGING
-    if (log_file_.is_open())
+    if (log_sink_)
       return; // Continue in the same file if already open
+    if (level_ == LogLevel::OFF)
+      return;
 
     std::error_code ec;
     std::filesystem::create_directories(log_dir, ec);
@@ -209,16 +671,24 @@ public:
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
                   now.time_since_epoch())
                   .count();
-    current_kakuro_id_ = "kakuro_" + std::to_string(ms);
+    // The sequence number keeps ids unique when several boards start in the
+    // same millisecond (e.g. batch generation workers).
+    current_kakuro_id_ = "kakuro_" + std::to_string(ms) + "_" +
+                         std::to_string(next_sequence_++);
 
     std::string filepath = log_dir + "/" + current_kakuro_id_ + ".jsonl";
     std::string prof_filepath = log_dir + "/_" + current_kakuro_id_ + ".jsonl";
-    log_file_.open(filepath);
-    prof_file_.open(prof_filepath);
-
-    if (log_file_.is_open() && prof_file_.is_open()) {
+    auto log_sink = std::make_shared<LogSink>();
+    auto prof_sink = std::make_shared<LogSink>();
+    log_sink->out.open(filepath);
+    prof_sink->out.open(prof_filepath);
+
+    if (log_sink->out.is_open() && prof_sink->out.is_open()) {
+      log_sink_ = std::move(log_sink);
+      prof_sink_ = std::move(prof_sink);
       enabled_ = true;
       step_id_ = 0;
+      last_frame_.clear();
       last_step_time_ = std::chrono::steady_clock::now();
       // JSONL: No opening bracket
     }
@@ -226,13 +696,17 @@ public:
   }
 
   void close() {
-    if (log_file_.is_open()) {
-      log_file_.flush();
-      log_file_.close();
+    // In async mode the writer still holds the sinks of queued records; the
+    // files close once those are written
+    if (log_sink_) {
+      if (!async_)
+        log_sink_->out.flush();
+      log_sink_.reset();
     }
-    if (prof_file_.is_open()) {
-      prof_file_.flush();
-      prof_file_.close();
+    if (prof_sink_) {
+      if (!async_)
+        prof_sink_->out.flush();
+      prof_sink_.reset();
     }
     enabled_ = false;
   }
@@ -245,65 +719,27 @@ public:
       const std::vector<std::vector<LogCell>> &grid_state,
       const std::string &extra_data = "") {
 #if KAKURO_ENABLE_LOGGING
-    if (!enabled_ || !log_file_.is_open())
+    if (!wants_step(substage))
       return;
-
-    auto now = std::chrono::steady_clock::now();
-    double duration_ms = std::chrono::duration<double, std::milli>(now - last_step_time_).count();
-    last_step_time_ = now;
-
-    // JSONL: Each entry is a single-line JSON object
-    log_file_ << "{\"id\":" << step_id_++
-              << ",\"dur\":" << std::fixed << std::setprecision(2) << duration_ms
-              << ",\"s\":\"" << stage << "\""
-              << ",\"ss\":\"" << substage << "\""
-              << ",\"m\":\"" << escape_json(message) << "\"";
-
+    std::ostringstream &line = begin_step(stage, substage, message);
     if (!grid_state.empty()) {
-      log_file_ << ",\"wh\":[" << grid_state[0].size() << "," << grid_state.size() << "]";
-      
-      // Log White Cells
-      log_file_ << ",\"g\":[";
-      bool first_cell = true;
-      for (size_t r = 0; r < grid_state.size(); r++) {
-        for (size_t c = 0; c < grid_state[r].size(); c++) {
-          const auto &cell = grid_state[r][c];
-          if (cell.type == "WHITE") {
-            if (!first_cell) log_file_ << ",";
-            log_file_ << "[" << r << "," << c << "," << cell.value << "]";
-            first_cell = false;
-          }
-        }
-      }
-      log_file_ << "]";
-
-      // Log Block Clues
-      log_file_ << ",\"b\":[";
-      first_cell = true;
-      for (size_t r = 0; r < grid_state.size(); r++) {
-        for (size_t c = 0; c < grid_state[r].size(); c++) {
-          const auto &cell = grid_state[r][c];
-          if (cell.type == "BLOCK" && (cell.clue_h > 0 || cell.clue_v > 0)) {
-            if (!first_cell) log_file_ << ",";
-            log_file_ << "[" << r << "," << c << "," << cell.clue_h << "," << cell.clue_v << "]";
-            first_cell = false;
-          }
-        }
-      }
-      log_file_ << "]";
-
+      write_frame(line, grid_state.size(), grid_state[0].size(),
+                  [&](size_t r, size_t c) { return grid_state[r][c]; });
     } else {
-      log_file_ << ",\"g\":[],\"b\":[]";
-    }
-
-    if (!extra_data.empty()) {
-      log_file_ << ",\"d\":" << extra_data;
+      line << ",\"g\":[],\"b\":[]";
     }
-    log_file_ << "}\n"; // End of line for JSONL
-    log_file_.flush();
+    end_step(line, extra_data);
 #endif
   }
 
+  // As above, but reads the cells straight from `board`, so no snapshot is
+  // built; cells whose mask in `candidates` is a single digit show that
+  // digit. Prefer it for per-step records.
+  void log_step(const std::string &stage, const std::string &substage,
+                const std::string &message, const KakuroBoard &board,
+                const CandidateMap *candidates = nullptr,
+                const std::string &extra_data = "");
+
   void log_step_with_highlights(
       const std::string &stage, const std::string &substage,
       const std::string &message,
@@ -312,7 +748,7 @@ public:
       const std::vector<std::vector<LogCell>> &alt_grid =
           {}) {
 #if KAKURO_ENABLE_LOGGING
-    if (!enabled_ || !log_file_.is_open())
+    if (!enabled_ || !log_sink_)
       return;
 
     std::ostringstream data;
@@ -334,7 +770,7 @@ public:
           const auto &cell = alt_grid[r][c];
           // We only log WHITE cells to save space, matching the main grid
           // format
-          if (cell.type == "WHITE") {
+          if (cell.type == CellType::WHITE) {
             if (!first_val)
               data << ",";
             data << "[" << r << "," << c << "," << cell.value << "]";
@@ -352,119 +788,68 @@ public:
 
   void log_params(const FillParams &fill_p, const TopologyParams &topo_p) {
 #if KAKURO_ENABLE_LOGGING
-    if (!enabled_ || !log_file_.is_open())
+    if (!enabled_ || !log_sink_)
       return;
 
-    log_file_ << "{\"id\":" << step_id_++ << ",\"s\":\"params\",\"ss\":\"init\",\"m\":\"Generation Parameters\"";
+    std::ostringstream &line = begin_record(log_buf_);
+    line << "{\"id\":" << step_id_++ << ",\"s\":\"params\",\"ss\":\"init\",\"m\":\"Generation Parameters\"";
 
     // Serialize FillParams
-    log_file_ << ",\"fill\":{";
-    log_file_ << "\"difficulty\":\"" << fill_p.difficulty << "\"";
+    line << ",\"fill\":{";
+    line << "\"difficulty\":\"" << fill_p.difficulty << "\"";
     if (fill_p.max_nodes)
-      log_file_ << ",\"max_nodes\":" << *fill_p.max_nodes;
+      line << ",\"max_nodes\":" << *fill_p.max_nodes;
     if (fill_p.partition_preference)
-      log_file_ << ",\"partition_preference\":\"" << *fill_p.partition_preference << "\"";
+      line << ",\"partition_preference\":\"" << *fill_p.partition_preference << "\"";
     if (fill_p.weights) {
-      log_file_ << ",\"weights\":[";
+      line << ",\"weights\":[";
       for (size_t i = 0; i < fill_p.weights->size(); ++i) {
-        log_file_ << (*fill_p.weights)[i] << (i < fill_p.weights->size() - 1 ? "," : "");
+        line << (*fill_p.weights)[i] << (i < fill_p.weights->size() - 1 ? "," : "");
       }
-      log_file_ << "]";
+      line << "]";
     }
-    log_file_ << "}";
+    line << "}";
 
     // Serialize TopologyParams
-    log_file_ << ",\"topo\":{";
-    log_file_ << "\"difficulty\":\"" << topo_p.difficulty << "\"";
-    if (topo_p.density) log_file_ << ",\"density\":" << *topo_p.density;
-    if (topo_p.max_sector_length) log_file_ << ",\"max_sector_length\":" << *topo_p.max_sector_length;
-    if (topo_p.num_stamps) log_file_ << ",\"num_stamps\":" << *topo_p.num_stamps;
-    if (topo_p.min_cells) log_file_ << ",\"min_cells\":" << *topo_p.min_cells;
-    if (topo_p.max_run_len) log_file_ << ",\"max_run_len\":" << *topo_p.max_run_len;
-    if (topo_p.max_run_len_soft) log_file_ << ",\"max_run_len_soft\":" << *topo_p.max_run_len_soft;
-    if (topo_p.max_run_len_soft_prob) log_file_ << ",\"max_run_len_soft_prob\":" << *topo_p.max_run_len_soft_prob;
-    if (topo_p.max_patch_size) log_file_ << ",\"max_patch_size\":" << *topo_p.max_patch_size;
-    if (topo_p.island_mode) log_file_ << ",\"island_mode\":" << (*topo_p.island_mode ? "true" : "false");
+    line << ",\"topo\":{";
+    line << "\"difficulty\":\"" << topo_p.difficulty << "\"";
+    if (topo_p.density) line << ",\"density\":" << *topo_p.density;
+    if (topo_p.max_sector_length) line << ",\"max_sector_length\":" << *topo_p.max_sector_length;
+    if (topo_p.num_stamps) line << ",\"num_stamps\":" << *topo_p.num_stamps;
+    if (topo_p.min_cells) line << ",\"min_cells\":" << *topo_p.min_cells;
+    if (topo_p.max_run_len) line << ",\"max_run_len\":" << *topo_p.max_run_len;
+    if (topo_p.max_run_len_soft) line << ",\"max_run_len_soft\":" << *topo_p.max_run_len_soft;
+    if (topo_p.max_run_len_soft_prob) line << ",\"max_run_len_soft_prob\":" << *topo_p.max_run_len_soft_prob;
+    if (topo_p.max_patch_size) line << ",\"max_patch_size\":" << *topo_p.max_patch_size;
+    if (topo_p.island_mode) line << ",\"island_mode\":" << (*topo_p.island_mode ? "true" : "false");
     if (topo_p.stamps) {
-      log_file_ << ",\"stamps\":[";
+      line << ",\"stamps\":[";
       for (size_t i = 0; i < topo_p.stamps->size(); ++i) {
-        log_file_ << "[" << (*topo_p.stamps)[i].first << "," << (*topo_p.stamps)[i].second << "]"
-                  << (i < topo_p.stamps->size() - 1 ? "," : "");
+        line << "[" << (*topo_p.stamps)[i].first << "," << (*topo_p.stamps)[i].second << "]"
+             << (i < topo_p.stamps->size() - 1 ? "," : "");
       }
-      log_file_ << "]";
+      line << "]";
     }
-    log_file_ << "}}\n"; // Close object and end line
-    log_file_.flush();
+    line << "}}\n"; // Close object and end line
+    emit(log_sink_, line);
 #endif
   }
 
-  void log_difficulty(
-      const DifficultyResult &diff,
-      const std::vector<std::vector<LogCell>> &grid_state) {
-#if KAKURO_ENABLE_LOGGING
-    if (!enabled_ || !log_file_.is_open())
-      return;
-
-    log_file_ << "{\"id\":" << step_id_++ 
-              << ",\"s\":\"" << STAGE_DIFFICULTY << "\""
-              << ",\"ss\":\"" << SUBSTAGE_COMPLETE << "\""
-              << ",\"m\":\"Difficulty estimation complete: " << escape_json(diff.rating) << "\""
-              << ",\"difficulty\":{"
-              << "\"rating\":\"" << escape_json(diff.rating) << "\""
-              << ",\"score\":" << diff.score
-              << ",\"max_tier\":" << (int)diff.max_tier
-              << ",\"solution_count\":" << diff.solution_count
-              << ",\"uniqueness\":\"" << escape_json(diff.uniqueness) << "\"}";
-
-    if (!grid_state.empty()) {
-      log_file_ << ",\"wh\":[" << grid_state[0].size() << "," << grid_state.size() << "]"
-                << ",\"g\":[";
-      bool first_cell = true;
-      for (size_t r = 0; r < grid_state.size(); r++) {
-        for (size_t c = 0; c < grid_state[r].size(); c++) {
-          const auto &cell = grid_state[r][c];
-          if (cell.type == "WHITE") {
-            if (!first_cell) log_file_ << ",";
-            log_file_ << "[" << r << "," << c << "," << cell.value << "]";
-            first_cell = false;
-          }
-        }
-      }
-      log_file_ << "]"; // Close 'g'
-      
-      // Log Block Clues
-      log_file_ << ",\"b\":[";
-      first_cell = true;
-      for (size_t r = 0; r < grid_state.size(); r++) {
-        for (size_t c = 0; c < grid_state[r].size(); c++) {
-          const auto &cell = grid_state[r][c];
-          if (cell.type == "BLOCK" && (cell.clue_h > 0 || cell.clue_v > 0)) {
-            if (!first_cell) log_file_ << ",";
-            log_file_ << "[" << r << "," << c << "," << cell.clue_h << "," << cell.clue_v << "]";
-            first_cell = false;
-          }
-        }
-      }
-      log_file_ << "]}";
-    } else {
-      log_file_ << ",\"g\":[]}";
-    }
-    log_file_ << "\n";
-    log_file_.flush();
-#endif
-  }
+  // Result of an estimate, with the board as a keyframe
+  void log_difficulty(const DifficultyResult &diff, const KakuroBoard &board);
 
   void log_profile(const std::string &name, double duration_ms) {
 #if KAKURO_ENABLE_PROFILE_LOGGING
-    if (!enabled_ || !prof_file_.is_open())
+    if (!enabled_ || !prof_sink_ || level_ != LogLevel::FULL)
       return;
 
-    prof_file_ << "{\"id\":" << step_id_++ 
-               << ",\"s\":\"" << STAGE_PROFILE << "\""
-               << ",\"ss\":\"" << SUBSTAGE_TIMING << "\""
-               << ",\"m\":\"Profile: " << escape_json(name) << "\""
-               << ",\"dur\":" << std::fixed << std::setprecision(3) << duration_ms << "}\n";
-    prof_file_.flush();
+    std::ostringstream &line = begin_record(prof_buf_);
+    line << "{\"id\":" << step_id_++ 
+         << ",\"s\":\"" << STAGE_PROFILE << "\""
+         << ",\"ss\":\"" << SUBSTAGE_TIMING << "\""
+         << ",\"m\":\"Profile: " << escape_json(name) << "\""
+         << ",\"dur\":" << std::fixed << std::setprecision(3) << duration_ms << "}\n";
+    emit(prof_sink_, line);
 #endif
   }
 };
@@ -473,33 +858,109 @@ public:
 // PROFILING TOOLS
 // ============================================================================
 
-class ScopedTimer {
+// Scopes are registered once per call site and aggregated per thread, so a
+// timed scope costs two clock reads and a few uncontended atomic adds.
+// Define KAKURO_ENABLE_PROFILING=0 to compile the scopes out entirely.
+#ifndef KAKURO_ENABLE_PROFILING
+#define KAKURO_ENABLE_PROFILING 1
+#endif
+
+constexpr int PROFILE_MAX_SCOPES = 128;
+// Bucket b counts samples in [2^b, 2^(b+1)) ns; the last bucket is open-ended
+constexpr int PROFILE_BUCKETS = 32;
+
+struct ProfileScopeStats {
+  std::string name;
+  uint64_t count = 0;
+  double total_ms = 0;
+  double min_ms = 0;
+  double max_ms = 0;
+  std::array<uint64_t, PROFILE_BUCKETS> histogram{};
+};
+
+class ProfileRegistry {
 public:
-  ScopedTimer(const std::string &name, std::shared_ptr<GenerationLogger> logger)
-      : name_(name), logger_(logger),
-        start_(std::chrono::steady_clock::now()) {}
-
-  ~ScopedTimer() {
-    auto end = std::chrono::steady_clock::now();
-    double duration =
-        std::chrono::duration<double, std::milli>(end - start_).count();
-    if (logger_ && logger_->is_enabled()) {
-      logger_->log_profile(name_, duration);
-    }
+  // Returns the id of a named scope, registering it on first use
+  static int register_scope(const char *name);
+
+  // Adds one sample to the calling thread's storage
+  static void record(int id, uint64_t ns);
+
+  // Merges every thread's storage; scopes without samples are left out
+  static std::vector<ProfileScopeStats> summary();
+  static void reset();
+
+  static void set_enabled(bool enabled) { enabled_ = enabled; }
+  static bool is_enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  static const char *scope_name(int id);
+
+private:
+  static inline std::atomic<bool> enabled_{true};
+};
+
+class ProfileScope {
+public:
+  ProfileScope(int id, GenerationLogger *logger)
+      : id_(id), active_(id >= 0 && ProfileRegistry::is_enabled()) {
+#if KAKURO_ENABLE_PROFILE_LOGGING
+    logger_ = logger && logger->is_enabled() ? logger : nullptr;
+    active_ = active_ || logger_;
+#else
+    (void)logger;
+#endif
+    if (active_)
+      start_ = std::chrono::steady_clock::now();
   }
 
+  ~ProfileScope() {
+    if (!active_)
+      return;
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    ProfileRegistry::record(
+        id_, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 elapsed)
+                 .count());
+#if KAKURO_ENABLE_PROFILE_LOGGING
+    if (logger_)
+      logger_->log_profile(
+          ProfileRegistry::scope_name(id_),
+          std::chrono::duration<double, std::milli>(elapsed).count());
+#endif
+  }
+
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
 private:
-  std::string name_;
-  std::shared_ptr<GenerationLogger> logger_;
+  int id_;
+  bool active_;
   std::chrono::steady_clock::time_point start_;
+#if KAKURO_ENABLE_PROFILE_LOGGING
+  GenerationLogger *logger_ = nullptr;
+#endif
 };
 
+#define KAKURO_PROFILE_CONCAT_(a, b) a##b
+#define KAKURO_PROFILE_CONCAT(a, b) KAKURO_PROFILE_CONCAT_(a, b)
+
+#if KAKURO_ENABLE_PROFILING
+// The lambda gives every call site its own static id
 #define PROFILE_SCOPE(name, logger)                                            \
-  kakuro::ScopedTimer timer##__LINE__(name, logger)
+  kakuro::ProfileScope KAKURO_PROFILE_CONCAT(profile_scope_, __LINE__)(        \
+      [](const char *scope_name) {                                             \
+        static const int id =                                                  \
+            kakuro::ProfileRegistry::register_scope(scope_name);               \
+        return id;                                                             \
+      }(name),                                                                 \
+      (logger).get())
+#else
+#define PROFILE_SCOPE(name, logger) ((void)0)
+#endif
 #define PROFILE_FUNCTION(logger) PROFILE_SCOPE(__func__, logger)
 
-enum class CellType { BLOCK, WHITE };
-
 enum class UniquenessResult { UNIQUE, MULTIPLE, INCONCLUSIVE };
 
 struct Cell {
@@ -510,44 +971,320 @@ struct Cell {
   std::optional<int> clue_h; // Sum of the row to the right
   std::optional<int> clue_v; // Sum of the col below
 
-  // Pointers to sectors (for fast access during solving)
-  std::shared_ptr<std::vector<Cell *>> sector_h;
-  std::shared_ptr<std::vector<Cell *>> sector_v;
+  // Ids into KakuroBoard::sectors_h / sectors_v (-1 for none)
+  int sector_h;
+  int sector_v;
+
+  // Position in KakuroBoard::white_cells (-1 for blocks)
+  int idx;
 
   Cell(int row, int col, CellType t = CellType::WHITE)
       : r(row), c(col), type(t), value(std::nullopt), clue_h(std::nullopt),
-        clue_v(std::nullopt), sector_h(nullptr), sector_v(nullptr) {}
+        clue_v(std::nullopt), sector_h(-1), sector_v(-1), idx(-1) {}
+};
+
+// A sector's cells in run order. Points into its SectorTable and stays valid
+// for the board's lifetime.
+class SectorSpan {
+public:
+  SectorSpan() = default;
+  SectorSpan(Cell *const *first, int size, int id)
+      : first_(first), size_(size), id_(id) {}
+
+  Cell *const *begin() const { return first_; }
+  Cell *const *end() const { return first_ + size_; }
+  Cell *operator[](size_t i) const { return first_[i]; }
+  size_t size() const { return (size_t)size_; }
+  bool empty() const { return size_ == 0; }
+  int id() const { return id_; }
+
+private:
+  Cell *const *first_ = nullptr;
+  int size_ = 0;
+  int id_ = -1;
+};
+
+// The sectors of one direction in flat arrays. Line i (row i for horizontal
+// sectors, column i for vertical ones) owns a fixed block of slots, so
+// rebuilding one line leaves every other sector id unchanged. The cell
+// array lists every line's cells in order, and a sector is the slice at its
+// offset; unused slots are empty. Iterating yields the non-empty sectors in
+// board order.
+class SectorTable {
+public:
+  class iterator {
+  public:
+    iterator(const SectorTable *table, int id) : table_(table), id_(id) {
+      skip_empty();
+    }
+    SectorSpan operator*() const { return (*table_)[id_]; }
+    iterator &operator++() {
+      id_++;
+      skip_empty();
+      return *this;
+    }
+    bool operator!=(const iterator &other) const { return id_ != other.id_; }
+
+  private:
+    void skip_empty() {
+      while (id_ < table_->capacity() && table_->length_[id_] == 0)
+        id_++;
+    }
+    const SectorTable *table_;
+    int id_;
+  };
+
+  // No sectors. `sector_of` is the Cell field that receives sector ids.
+  void reset(int lines, int line_length, int Cell::*sector_of);
+  void set_cell(int line, int pos, Cell *cell) {
+    cells_[line * line_length_ + pos] = cell;
+  }
+  // Re-derives one line's sectors from its white bits (bit p = position p)
+  void rebuild_line(int line, uint64_t white);
+
+  int capacity() const { return (int)length_.size(); } // Ids are < capacity
+  size_t size() const { return (size_t)count_; }       // Non-empty sectors
+  bool empty() const { return count_ == 0; }
+  int length(int id) const { return length_[id]; }
+  SectorSpan operator[](int id) const {
+    return {cells_.data() + offset_[id], length_[id], id};
+  }
+  // The block holding the sector's clue; nullptr for an empty slot or a
+  // sector that starts at the edge
+  Cell *clue_cell(int id) const {
+    int pos = offset_[id] % line_length_;
+    return length_[id] && pos > 0 ? cells_[offset_[id] - 1] : nullptr;
+  }
+
+  iterator begin() const { return iterator(this, 0); }
+  iterator end() const { return iterator(this, capacity()); }
+
+private:
+  int line_length_ = 0;
+  int slots_per_line_ = 0;
+  int count_ = 0;
+  int Cell::*sector_of_ = nullptr;
+  std::vector<Cell *> cells_;   // line * line_length + pos
+  std::vector<int> offset_;     // By id, into cells_
+  std::vector<int> length_;     // By id, 0 = unused
+  std::vector<int> line_count_; // Sectors per line
 };
 
+// Candidate bitmasks for the white cells of a board, indexed by Cell::idx.
+// Storage is inline, so copying a search branch is a memcpy of the active
+// cells and never allocates.
+class CandidateMap {
+public:
+  static constexpr int MAX_CELLS = 1024; // Covers boards up to 32x32
+
+  CandidateMap() = default;
+  CandidateMap(int size, uint16_t mask) { assign(size, mask); }
+  CandidateMap(const CandidateMap &other) : size_(other.size_) {
+    std::copy_n(other.masks_.data(), size_, masks_.data());
+  }
+  CandidateMap &operator=(const CandidateMap &other) {
+    size_ = other.size_;
+    std::copy_n(other.masks_.data(), size_, masks_.data());
+    return *this;
+  }
+
+  void assign(int size, uint16_t mask) {
+    size_ = std::min(size, MAX_CELLS);
+    std::fill_n(masks_.data(), size_, mask);
+  }
+
+  int size() const { return size_; }
+
+  uint16_t &operator[](const Cell *cell) { return masks_[cell->idx]; }
+  uint16_t operator[](const Cell *cell) const { return masks_[cell->idx]; }
+  uint16_t &at(const Cell *cell) { return masks_[cell->idx]; }
+  uint16_t at(const Cell *cell) const { return masks_[cell->idx]; }
+
+private:
+  int size_ = 0;
+  std::array<uint16_t, MAX_CELLS> masks_;
+};
+
+// Up to nine digits in the order a search tries them. Storage is inline, so
+// the per-node domain lists of the fill and uniqueness searches never
+// allocate.
+class DigitList {
+public:
+  void push_back(int digit) { digits_[size_++] = digit; }
+  void clear() { size_ = 0; }
+  int size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  int operator[](int i) const { return digits_[i]; }
+
+  int *begin() { return digits_.data(); }
+  int *end() { return digits_.data() + size_; }
+  const int *begin() const { return digits_.data(); }
+  const int *end() const { return digits_.data() + size_; }
+
+private:
+  std::array<int, 9> digits_;
+  int size_ = 0;
+};
+
+// std::hash<int> is the identity, so a plain shift and xor made grid
+// coordinates collide often ((0,1) and (2,0) hashed alike). The packed pair
+// is mixed instead.
 struct PairHash {
   template <class T1, class T2>
   std::size_t operator()(const std::pair<T1, T2> &p) const {
-    auto h1 = std::hash<T1>{}(p.first);
-    auto h2 = std::hash<T2>{}(p.second);
-    return h1 ^ (h2 << 1);
+    uint64_t h1 = std::hash<T1>{}(p.first);
+    uint64_t h2 = std::hash<T2>{}(p.second);
+    uint64_t x = (h1 << 32 | (h2 & 0xFFFFFFFFULL)) * 0x9E3779B97F4A7C15ULL;
+    return (std::size_t)(x ^ (x >> 29));
   }
 };
 
+// Deadline and cancellation shared by every engine working on one request.
+// cancel() may be called from any thread. A child budget ends no later than
+// its parent and is cancelled with it, which is how a total deadline is split
+// across stages. Always held by shared_ptr (children keep their parent).
+class GenerationBudget
+    : public std::enable_shared_from_this<GenerationBudget> {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // `seconds` <= 0 means no deadline
+  static std::shared_ptr<GenerationBudget> create(double seconds = 0) {
+    auto budget = std::make_shared<GenerationBudget>();
+    budget->set_deadline(seconds);
+    return budget;
+  }
+
+  void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+  // Deadline `seconds` from now; <= 0 removes it
+  void set_deadline(double seconds) {
+    Clock::rep deadline = NO_DEADLINE;
+    if (seconds > 0)
+      deadline = (Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                     std::chrono::duration<double>(seconds)))
+                     .time_since_epoch()
+                     .count();
+    deadline_.store(deadline, std::memory_order_relaxed);
+  }
+
+  // One relaxed load per level; cheap enough for every search node
+  bool is_cancelled() const {
+    for (const GenerationBudget *b = this; b; b = b->parent_.get()) {
+      if (b->cancelled_.load(std::memory_order_relaxed))
+        return true;
+    }
+    return false;
+  }
+
+  // Cancelled or past the deadline. Reads the clock, so hot loops call it
+  // every few hundred nodes.
+  bool expired() const {
+    if (is_cancelled())
+      return true;
+    Clock::rep deadline = effective_deadline();
+    return deadline != NO_DEADLINE &&
+           Clock::now().time_since_epoch().count() >= deadline;
+  }
+
+  // Seconds left, or infinity without a deadline
+  double remaining_sec() const {
+    Clock::rep deadline = effective_deadline();
+    if (deadline == NO_DEADLINE)
+      return std::numeric_limits<double>::infinity();
+    Clock::duration left =
+        Clock::duration(deadline) - Clock::now().time_since_epoch();
+    return std::max(0.0, std::chrono::duration<double>(left).count());
+  }
+
+  // Ends `max_seconds` from now (<= 0: with this budget) or with this
+  // budget, whichever comes first
+  std::shared_ptr<GenerationBudget> child(double max_seconds = 0) const {
+    auto budget = create(max_seconds);
+    budget->parent_ = shared_from_this();
+    return budget;
+  }
+
+  // Gets `fraction` of the time this budget has left
+  std::shared_ptr<GenerationBudget> child_fraction(double fraction) const {
+    double remaining = remaining_sec();
+    return child(std::isinf(remaining) ? 0 : std::max(1e-3, remaining * fraction));
+  }
+
+private:
+  static constexpr Clock::rep NO_DEADLINE =
+      std::numeric_limits<Clock::rep>::max();
+
+  Clock::rep effective_deadline() const {
+    Clock::rep deadline = NO_DEADLINE;
+    for (const GenerationBudget *b = this; b; b = b->parent_.get())
+      deadline = std::min(deadline, b->deadline_.load(std::memory_order_relaxed));
+    return deadline;
+  }
+
+  std::atomic<bool> cancelled_{false};
+  std::atomic<Clock::rep> deadline_{NO_DEADLINE}; // steady_clock ticks
+  std::shared_ptr<const GenerationBudget> parent_;
+};
+
+// Kernel microbenchmarks (kakuro_microbench.cpp); reach private kernels
+struct KernelBench;
+
 class KakuroBoard {
 public:
+  // Rows and columns are packed into one uint64_t each
+  static constexpr int MAX_DIMENSION = 64;
+
   int width;
   int height;
   std::vector<std::vector<Cell>> grid;
+  // White map with bit c of white_rows[r] and bit r of white_cols[c] set for
+  // a WHITE cell. set_block/set_white keep it current; after writing
+  // Cell::type directly, collect_white_cells() or sync_white_bits() rebuilds
+  // it.
+  std::vector<uint64_t> white_rows;
+  std::vector<uint64_t> white_cols;
   std::vector<Cell *> white_cells;
-  std::vector<std::shared_ptr<std::vector<Cell *>>> sectors_h;
-  std::vector<std::shared_ptr<std::vector<Cell *>>> sectors_v;
+  // Rebuilt by identify_sectors() for the lines that changed since its last
+  // call
+  SectorTable sectors_h;
+  SectorTable sectors_v;
 
   std::shared_ptr<GenerationLogger> logger;
+  // Checked by the topology loops; set by the solver for each generation
+  std::shared_ptr<const GenerationBudget> budget;
 
   // Random number generator
   std::mt19937 rng;
 
   KakuroBoard(int w, int h);
+  KakuroBoard(int w, int h, uint32_t seed); // Reproducible topology
+
+  // Deep copy with its own cells and sectors. The copy gets a fresh, disabled
+  // logger so it can be searched on another thread.
+  std::shared_ptr<KakuroBoard> clone() const;
+  // Copies types, values and clues from a board of the same size, then
+  // rebuilds white cells and sectors
+  void copy_cells_from(const KakuroBoard &other);
 
   Cell *get_cell(int r, int c);
   void reset_values();
   void set_block(int r, int c);
   void set_white(int r, int c);
+  void sync_white_bits();
+  // Makes the cells in bit c of rows[r] WHITE and every other cell BLOCK,
+  // clears values and clues, then rebuilds white cells and sectors
+  void load_white_rows(const uint64_t *rows);
+  SectorSpan h_sector(const Cell *cell) const {
+    return cell->sector_h < 0 ? SectorSpan() : sectors_h[cell->sector_h];
+  }
+  SectorSpan v_sector(const Cell *cell) const {
+    return cell->sector_v < 0 ? SectorSpan() : sectors_v[cell->sector_v];
+  }
+  bool is_white(int r, int c) const {
+    return r >= 0 && r < height && c >= 0 && c < width &&
+           ((white_rows[r] >> c) & 1);
+  }
 
   // Topology generation
   bool generate_topology(const TopologyParams &params = TopologyParams());
@@ -589,6 +1326,20 @@ public:
       const std::unordered_map<Cell *, int> *assignment = nullptr) const;
 
 private:
+  friend struct KernelBench;
+  void mark_white_bit(int r, int c, bool white);
+  // Replaces the white map with rows[0..height), marking the lines that
+  // differ as dirty
+  void assign_white_rows(const uint64_t *rows);
+  // Interior cells of row r without a white neighbour on one axis
+  uint64_t single_run_cells(int r) const;
+  // Slices every run longer than min_len for which should_slice() agrees
+  template <typename ShouldSlice>
+  bool slice_runs(int min_len, ShouldSlice should_slice);
+
+  // Lines whose sectors are stale: bit r for rows, bit c for columns
+  uint64_t dirty_rows_ = 0;
+  uint64_t dirty_cols_ = 0;
   // bool limit_sector_lengths(int max_length);
   // int count_neighbors_filled(Cell* cell, const std::unordered_map<Cell*,
   // int>& assignment); bool is_connected(const
@@ -596,6 +1347,47 @@ private:
   //                   std::hash<std::pair<int, int>>>& coords);
 };
 
+// Components of the white cells over a flat r * width + c index. Union-find
+// absorbs cells turning white; for cells turning black, would_disconnect()
+// answers locally instead of re-flooding the board.
+class GridConnectivity {
+public:
+  void reset(int width, int height); // All cells black
+  void build(const KakuroBoard &board);
+  void add_white(int r, int c);
+
+  bool is_white(int r, int c) const {
+    int i = r * width_ + c;
+    return (white_[i >> 6] >> (i & 63)) & 1;
+  }
+  int num_white() const { return num_white_; }
+  int num_components() const { return num_components_; }
+
+  // Component per cell (-1 for black), numbered in row-major order of each
+  // component's first cell
+  std::vector<int> labels();
+
+  // Whether blocking `cells` splits the remaining white cells. Assumes they
+  // are currently connected; the state itself is not changed.
+  bool would_disconnect(const std::vector<std::pair<int, int>> &cells);
+
+private:
+  int find(int i);
+  bool white_at(int r, int c, const std::vector<int> &removed) const;
+  bool ring_connected(int r, int c, const std::vector<int> &removed) const;
+
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<uint64_t> white_;
+  std::vector<int> parent_;
+  std::vector<int> size_;
+  int num_white_ = 0;
+  int num_components_ = 0;
+  // Flood-fill scratch
+  std::vector<uint64_t> visited_;
+  std::vector<int> queue_;
+};
+
 struct PuzzleCell {
   CellType type;
   std::optional<int> clue_h;
@@ -603,11 +1395,294 @@ struct PuzzleCell {
   std::optional<int> solution;
 };
 
+// Per-stage counters and wall time of the last generate_puzzle call
+struct GenerationStats {
+  int topology_attempts = 0;
+  int pooled_topologies = 0; // Attempts served by a TopologyPool
+  int fill_attempts = 0;
+  int repairs = 0;
+
+  // Why fills were thrown away
+  int failed_fills = 0;          // No fill found under the current constraints
+  int rejected_ambiguity = 0;    // has_high_global_ambiguity()
+  int rejected_tier = 0;         // Logic rating far from the requested tier
+  int rejected_refuted = 0;      // Prefilter search found a second solution
+  int rejected_multiple = 0;     // Hybrid search found a second solution
+  int rejected_inconclusive = 0; // Hybrid search hit its limits
+  int rejected_estimator = 0;    // Hybrid said unique, estimator disagreed
+
+  // Search nodes per engine
+  long long fill_nodes = 0;
+  long long prefilter_nodes = 0;
+  long long uniqueness_nodes = 0;
+  long long estimator_nodes = 0;
+
+  double topology_ms = 0;
+  double fill_ms = 0;
+  double prefilter_ms = 0;
+  double uniqueness_ms = 0;
+  double difficulty_ms = 0;
+  double repair_ms = 0;
+  double total_ms = 0;
+
+  void merge(const GenerationStats &other) {
+    topology_attempts += other.topology_attempts;
+    pooled_topologies += other.pooled_topologies;
+    fill_attempts += other.fill_attempts;
+    repairs += other.repairs;
+    failed_fills += other.failed_fills;
+    rejected_ambiguity += other.rejected_ambiguity;
+    rejected_tier += other.rejected_tier;
+    rejected_refuted += other.rejected_refuted;
+    rejected_multiple += other.rejected_multiple;
+    rejected_inconclusive += other.rejected_inconclusive;
+    rejected_estimator += other.rejected_estimator;
+    fill_nodes += other.fill_nodes;
+    prefilter_nodes += other.prefilter_nodes;
+    uniqueness_nodes += other.uniqueness_nodes;
+    estimator_nodes += other.estimator_nodes;
+    topology_ms += other.topology_ms;
+    fill_ms += other.fill_ms;
+    prefilter_ms += other.prefilter_ms;
+    uniqueness_ms += other.uniqueness_ms;
+    difficulty_ms += other.difficulty_ms;
+    repair_ms += other.repair_ms;
+  }
+};
+
+// Adds the lifetime of the scope to a GenerationStats field
+class StageTimer {
+public:
+  explicit StageTimer(double &total_ms)
+      : total_ms_(total_ms), start_(std::chrono::steady_clock::now()) {}
+  ~StageTimer() {
+    total_ms_ += std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start_)
+                     .count();
+  }
+
+private:
+  double &total_ms_;
+  std::chrono::steady_clock::time_point start_;
+};
+
 struct GeneratedPuzzle {
   DifficultyResult difficulty;
   int width;
   int height;
   std::vector<std::vector<PuzzleCell>> grid;
+  GenerationStats stats; // Summed over every attempt that led to this puzzle
+};
+
+// Copies the board's types, clues and values into a self-contained puzzle.
+GeneratedPuzzle make_generated_puzzle(const KakuroBoard &board,
+                                      DifficultyResult difficulty);
+
+// A grid symmetry plus optional digit complement (v -> 10 - v, so a clue over
+// n cells becomes 10n - clue). Solutions map one to one, so a unique puzzle
+// stays unique. The transposition is applied before the mirrors.
+struct PuzzleTransform {
+  bool transpose = false;
+  bool mirror_cols = false;
+  bool mirror_rows = false;
+  bool complement = false;
+};
+
+// Applies `transform` to a solved puzzle and recomputes its clues with
+// CSPSolver::calculate_clues. The difficulty is estimated again on the
+// variant, or carried over when `reestimate` is false; a carried over rating
+// holds, but the score can differ since techniques fire in another order.
+// Returns false if a white cell has no solution or a run would lose its clue
+// cell.
+bool transform_puzzle(const GeneratedPuzzle &puzzle,
+                      const PuzzleTransform &transform, GeneratedPuzzle &out,
+                      bool reestimate = true);
+// Up to `max_variants` distinct variants of `puzzle`, not counting itself.
+// The complement and the transposition come first, then the mirrors.
+std::vector<GeneratedPuzzle> puzzle_variants(const GeneratedPuzzle &puzzle,
+                                             int max_variants = 3,
+                                             bool reestimate = true);
+
+// ============================================================================
+// EXPORT
+// ============================================================================
+
+// Cells packed as uint8 planes, laid out [plane][row][col] in one buffer so
+// Python can wrap it without copying. 0 marks a missing clue or value.
+struct GridPlanes {
+  enum Plane { TYPE = 0, CLUE_H, CLUE_V, SOLUTION, PLANE_COUNT };
+  static constexpr uint8_t TYPE_BLOCK = 0;
+  static constexpr uint8_t TYPE_WHITE = 1;
+
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> data;
+
+  GridPlanes() = default;
+  GridPlanes(int w, int h)
+      : width(w), height(h), data((size_t)PLANE_COUNT * w * h, 0) {}
+
+  uint8_t &at(Plane plane, int r, int c) {
+    return data[((size_t)plane * height + r) * width + c];
+  }
+  uint8_t at(Plane plane, int r, int c) const {
+    return data[((size_t)plane * height + r) * width + c];
+  }
+};
+
+GridPlanes export_planes(const KakuroBoard &board);
+GridPlanes export_planes(const GeneratedPuzzle &puzzle);
+
+// JSON in the shapes the service stores. Grids use the KakuroBoard::to_dict
+// layout (rows of {"r","c","type",["value","clue_h","clue_v"]} with string
+// values); difficulty is {"rating","score","max_tier","total_steps",
+// "uniqueness","solution_count","solve_path":[{"technique","weight",
+// "cells"}]}, score rounded to 2 decimals.
+std::string grid_to_json(const KakuroBoard &board);
+std::string grid_to_json(const GeneratedPuzzle &puzzle);
+std::string difficulty_to_json(const DifficultyResult &difficulty);
+// {"width","height","difficulty":{...},"grid":[...]}
+std::string puzzle_to_json(const GeneratedPuzzle &puzzle);
+
+// Versioned binary encoding, a few hundred bytes per puzzle:
+//   "KKP" version | width height | max_tier solution_count total_steps(u16)
+//   score(f32) | rating, uniqueness (u8 length + bytes)
+//   white-cell bitmap (row-major, LSB first) | clue_h clue_v per block cell
+//   solution nibbles per white cell (0 = none)
+// Integers are little-endian. solve_path and solutions are not stored.
+constexpr uint8_t PUZZLE_FORMAT_VERSION = 1;
+std::vector<uint8_t> encode_puzzle(const GeneratedPuzzle &puzzle);
+// Returns false for truncated data, a bad magic or an unknown version
+bool decode_puzzle(const uint8_t *data, size_t size, GeneratedPuzzle &out);
+
+// Append-only pool file: a 16-byte header ("KKPL", version) followed by
+// records of [u32 payload size][u8 label length][difficulty label][payload],
+// the payload being an encode_puzzle() blob. A record is written with one
+// call, so a reader only ever misses a trailing partial record.
+class PuzzlePoolWriter {
+public:
+  ~PuzzlePoolWriter() { close(); }
+  // Creates the file or validates the header of an existing one
+  bool open(const std::string &path);
+  bool append(const GeneratedPuzzle &puzzle, const std::string &difficulty);
+  void close();
+  bool is_open() const { return out_.is_open(); }
+
+private:
+  std::ofstream out_;
+};
+
+// Memory-mapped, read-only view of a pool file. Records are indexed by
+// (difficulty, width, height) and by difficulty alone, so a random pick is
+// an index lookup plus a decode straight from the mapping. Thread-safe.
+class PuzzlePool {
+public:
+  PuzzlePool();
+  ~PuzzlePool();
+  PuzzlePool(const PuzzlePool &) = delete;
+  PuzzlePool &operator=(const PuzzlePool &) = delete;
+
+  bool open(const std::string &path);
+  // Maps and indexes records appended since open(); cheap when none were.
+  // Returns false if the file can no longer be read.
+  bool refresh();
+  void close();
+
+  size_t size() const;
+  // width/height 0 matches any size
+  size_t count(const std::string &difficulty, int width = 0,
+               int height = 0) const;
+  bool random_puzzle(const std::string &difficulty, int width, int height,
+                     GeneratedPuzzle &out);
+
+private:
+  struct Record {
+    size_t offset;
+    size_t size;
+  };
+  using Key = std::tuple<std::string, int, int>;
+
+  bool map_file();
+  void unmap_file();
+  void index_from(size_t offset);
+
+  mutable std::mutex mutex_;
+  std::string path_;
+  const uint8_t *data_ = nullptr;
+  size_t mapped_size_ = 0;
+  size_t indexed_end_ = 0;
+  std::vector<uint8_t> buffer_; // Fallback copy where mmap is unavailable
+  std::map<Key, std::vector<Record>> index_;
+  size_t num_records_ = 0;
+  std::mt19937 rng_;
+};
+
+// Validated topologies (white maps that passed validate_topology_structure)
+// kept by board size and the caller's unresolved TopologyParams, so
+// generation can skip the topology passes. Each topology is handed out once;
+// a background producer tops every requested key back up to `per_key`,
+// skipping white maps it already holds or was told to evict. Thread-safe.
+class TopologyPool {
+public:
+  static constexpr int MAX_KEYS = 32; // Past this the oldest request is dropped
+  // Consecutive failed or duplicate builds before the producer leaves a key
+  // alone until its next request
+  static constexpr int MAX_PRODUCER_FAILURES = 8;
+  static constexpr size_t MAX_EVICTED = 4096; // Per key; cleared when full
+
+  explicit TopologyPool(int per_key = 4);
+  ~TopologyPool(); // Stops the producer
+  TopologyPool(const TopologyPool &) = delete;
+  TopologyPool &operator=(const TopologyPool &) = delete;
+
+  void start(); // Starts the producer thread; no-op while it runs
+  void stop();  // Stops the producer and waits for it
+
+  // Loads a ready topology for (board size, params) onto `board` and
+  // returns its white-map hash in `hash`. Returns false when none is ready;
+  // the key is then queued for the producer.
+  bool acquire(KakuroBoard &board, const TopologyParams &params,
+               uint64_t &hash);
+  // The topology produced no unique fill: never hand it out again
+  void evict(int width, int height, const TopologyParams &params,
+             uint64_t hash);
+  size_t ready(int width, int height, const TopologyParams &params) const;
+
+  static uint64_t params_hash(const TopologyParams &params);
+  static uint64_t white_map_hash(const KakuroBoard &board);
+
+private:
+  struct Topology {
+    std::vector<uint64_t> white_rows;
+    uint64_t hash;
+  };
+  struct Slot {
+    Slot(int w, int h, uint64_t key, TopologyParams p)
+        : width(w), height(h), params_key(key), params(std::move(p)) {}
+
+    int width;
+    int height;
+    uint64_t params_key;
+    TopologyParams params;
+    std::deque<Topology> ready;
+    std::unordered_set<uint64_t> evicted;
+    uint64_t last_request = 0;
+    int failures = 0;
+  };
+
+  Slot *find_slot(int width, int height, uint64_t params_key);
+  Slot *next_slot_to_fill();
+  void produce();
+
+  int per_key_;
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::vector<Slot> slots_;
+  uint64_t request_clock_ = 0;
+  bool stopping_ = false;
+  std::thread producer_;
+  std::shared_ptr<GenerationBudget> producer_budget_; // Cancelled by stop()
+  std::mt19937 rng_;
 };
 
 class CSPSolver {
@@ -616,9 +1691,28 @@ public:
   std::mt19937 rng;
 
   CSPSolver(std::shared_ptr<KakuroBoard> b);
+  CSPSolver(std::shared_ptr<KakuroBoard> b, uint32_t seed);
   void apply_fill_defaults(FillParams &params);
 
   void set_time_limit(double seconds) { time_limit_sec_ = seconds; }
+  // Caller-owned deadline/cancellation; generation also stops at the time
+  // limit, whichever comes first
+  void set_budget(std::shared_ptr<GenerationBudget> budget) {
+    user_budget_ = std::move(budget);
+  }
+  // Worker threads for the uniqueness search (1 = sequential, deterministic)
+  void set_uniqueness_threads(int threads) { uniqueness_threads_ = threads; }
+  // Concurrent fills per topology (1 = sequential). Each member fills its own
+  // board copy; the first one that validates is copied back into `board`.
+  void set_fill_portfolio(int members) { fill_portfolio_ = members; }
+  // Draw topologies from `pool` before building them in place
+  void set_topology_pool(std::shared_ptr<TopologyPool> pool) {
+    topology_pool_ = std::move(pool);
+  }
+  const GenerationStats &last_stats() const { return stats_; }
+  // Estimator result that validated the last successful generate_puzzle
+  // call; empty (solution_count 0) after a failed one
+  const DifficultyResult &last_difficulty() const { return difficulty_; }
 
   struct ScoreInfo {
     int value;
@@ -634,6 +1728,98 @@ public:
     std::vector<int> values;
   };
 
+  // Partial fills known to be dead or ambiguous on the current topology,
+  // as sets of (Cell::idx, value) literals. Single-literal nogoods are
+  // per-cell digit masks; longer ones are hashed for dedupe and indexed by
+  // literal with a count of currently true literals, so checking a
+  // candidate costs one mask test plus its (short) watch list.
+  // Soft nogoods rest on heuristics and are dropped when a fill under them
+  // fails; the rest hold until the topology changes.
+  class NogoodStore {
+  public:
+    static constexpr int MAX_LITERALS = 32;
+    static constexpr int MAX_NOGOODS = 4096;
+
+    void reset(int cell_count);
+    int cell_count() const { return (int)hard_units_.size(); }
+    void forbid(int idx, int value, bool soft);
+    // `cells` and `values` (by Cell::idx) give the literals. Returns false
+    // for duplicates and nogoods over the size or count limits
+    bool add(const std::vector<int> &cells, const std::vector<int> &values,
+             bool soft);
+    void clear_soft();
+    bool has_soft() const { return soft_count_ > 0; }
+    size_t size() const { return nogoods_.size(); }
+
+    bool unit_forbidden(int idx, int value) const {
+      return ((hard_units_[idx] | soft_units_[idx]) >> value) & 1;
+    }
+    // A nogood that assigning `value` to `idx` would complete, or -1
+    int violated_by(int idx, int value) const;
+    const std::vector<int> &literals(int nogood) const {
+      return nogoods_[nogood].literals;
+    }
+    static int literal_cell(int literal) { return literal / 10; }
+
+    // Keep the true-literal counts in step with the search
+    void on_assign(int idx, int value);
+    void on_unassign(int idx, int value);
+    void clear_assignment();
+
+  private:
+    struct Nogood {
+      std::vector<int> literals; // idx * 10 + value, sorted
+      int true_count = 0;
+      bool soft = false;
+    };
+    std::vector<uint16_t> hard_units_;
+    std::vector<uint16_t> soft_units_;
+    std::vector<Nogood> nogoods_;
+    std::vector<std::vector<int>> watches_; // literal -> nogood ids
+    std::vector<int> assigned_;             // Search value by idx, 0 = none
+    std::unordered_set<uint64_t> hashes_;
+    int soft_count_ = 0;
+
+    static uint64_t hash(const std::vector<int> &literals);
+    void index(int nogood);
+  };
+
+  // Incremental bookkeeping for the fill search. Sector sums, used-digit
+  // masks and fill counts are updated on assign/unassign, so consistency and
+  // domain checks cost O(1) per sector instead of a sector rescan.
+  struct FillState {
+    struct SectorView {
+      int sum;
+      uint16_t used;
+      int filled;
+      int length;
+    };
+
+    std::vector<int> values;      // Current value by Cell::idx, 0 = empty
+    std::vector<int> base_values; // Values already on the board
+    std::vector<int> cell_h;      // Sector id by Cell::idx, -1 = none
+    std::vector<int> cell_v;
+    std::vector<int> sector_sum;
+    std::vector<uint16_t> sector_used;
+    std::vector<int> sector_filled;
+    std::vector<int> sector_len;
+    std::vector<uint64_t> unassigned; // Bitset by Cell::idx
+    int num_unassigned = 0;
+
+    void init(const KakuroBoard &board);
+    void assign(const Cell *cell, int value);
+    void unassign(const Cell *cell);
+    bool is_assigned(const Cell *cell) const {
+      return !(unassigned[cell->idx >> 6] & (1ULL << (cell->idx & 63)));
+    }
+    // Sector state as seen by `cell`, i.e. without its own value
+    SectorView view(int sector, const Cell *cell) const;
+
+  private:
+    void place(int idx, int value);
+    void remove(int idx);
+  };
+
   bool generate_puzzle(const FillParams &params = FillParams(),
                        const TopologyParams &topo_params = TopologyParams());
   bool generate_puzzle(const std::string &difficulty = "medium"); // Legacy
@@ -655,32 +1841,64 @@ public:
   check_uniqueness(int max_nodes = 10000, int seed_offset = 0);
 
 private:
+  friend struct KernelBench;
   // --- Time Limit Members ---
-  std::chrono::steady_clock::time_point start_time_;
   double time_limit_sec_ = 180.0; // Default 180 seconds
+  int uniqueness_threads_ = 1;
+  int fill_portfolio_ = 1;
+  GenerationStats stats_;
+  DifficultyResult difficulty_;
+  std::shared_ptr<GenerationBudget> user_budget_;
+  // Budget of the running generation: the user budget capped at the time
+  // limit. Portfolio members share a child that the winner cancels.
+  std::shared_ptr<GenerationBudget> budget_;
+  std::shared_ptr<TopologyPool> topology_pool_;
+  static constexpr double UNIQUENESS_BUDGET_FRACTION = 0.5;
+  // Prefilter search nodes per fill; second solutions of generated fills
+  // typically turn up within a few dozen
+  static constexpr long long PREFILTER_NODES = 256;
+  // Logic rating this many tiers from the requested one rejects a fill
+  static constexpr int PREFILTER_TIER_GAP = 3;
   bool check_timeout(); // Returns true if timed out and handles logging/closing
 
-  bool
-  backtrack_fill(std::unordered_map<Cell *, int> &assignment, int &node_count,
-                 int max_nodes, const std::vector<int> &weights,
-                 bool ignore_clues, const std::string &partition_preference,
-                 const std::vector<ValueConstraint> &forbidden_constraints);
+  // Per-solve scratch for conflict-directed backjumping. `conflict(d)` is
+  // the set of assigned cells (bitset by Cell::idx) that the level at
+  // depth d blames for its failure.
+  struct FillSearch {
+    NogoodStore *nogoods = nullptr;
+    bool aborted = false; // Node limit or timeout, conflicts are not proofs
+    size_t words = 0;
+    std::vector<uint64_t> conflicts; // One row per depth, sized up front
+    std::vector<int> culprits;       // Nogood learning scratch, reused
+
+    uint64_t *conflict(int depth) { return conflicts.data() + depth * words; }
+  };
+
+  bool solve_fill(const FillParams &params,
+                  const std::unordered_map<Cell *, int> &forced_assignments,
+                  NogoodStore &nogoods, bool ignore_clues);
+  bool backtrack_fill(FillState &state, FillSearch &search, int depth,
+                      int &node_count, int max_nodes,
+                      const std::vector<int> &weights, bool ignore_clues,
+                      const std::string &partition_preference);
+  void blame_value(Cell *var, int value, const FillState &state,
+                   const FillSearch &search, bool ignore_clues,
+                   uint64_t *conflict);
   bool attempt_fill_and_validate(const FillParams &params);
+  bool attempt_fill_portfolio(const FillParams &params);
+  bool is_cancelled() const { return budget_ && budget_->is_cancelled(); }
   bool prepare_new_topology(const TopologyParams &topo_params);
   std::pair<
       UniquenessResult,
       std::optional<std::unordered_map<std::pair<int, int>, int, PairHash>>>
   perform_robust_uniqueness_check();
-  int count_neighbors_filled(Cell *cell,
-                             const std::unordered_map<Cell *, int> &assignment);
-  bool is_consistent_number(Cell *var, int value,
-                            const std::unordered_map<Cell *, int> &assignment,
+  int count_neighbors_filled(Cell *cell, const FillState &state);
+  bool is_consistent_number(Cell *var, int value, const FillState &state,
                             bool ignore_clues);
-  int estimate_future_domain_size(
-      Cell *cell, int value, char direction,
-      const std::unordered_map<Cell *, int> &assignment);
-  double estimate_intersection_entropy(
-      Cell *cell, int value, const std::unordered_map<Cell *, int> &assignment);
+  int estimate_future_domain_size(Cell *cell, int value, char direction,
+                                  const FillState &state);
+  double estimate_intersection_entropy(Cell *cell, int value,
+                                       const FillState &state);
   bool has_high_global_ambiguity();
   void solve_for_uniqueness(
       std::vector<std::unordered_map<std::pair<int, int>, int, PairHash>>
@@ -688,13 +1906,11 @@ private:
       const std::unordered_map<std::pair<int, int>, int, PairHash> &avoid_sol,
       int &node_count, int max_nodes, int seed, bool &timed_out);
 
-  int get_domain_size(
-      Cell *cell, const std::unordered_map<Cell *, int> *assignment = nullptr,
-      bool ignore_clues = false);
-  bool
-  is_valid_move(Cell *cell, int val,
-                const std::unordered_map<Cell *, int> *assignment = nullptr,
-                bool ignore_clues = false);
+  // Without a fill state these read the values currently on the board
+  int get_domain_size(Cell *cell, const FillState *state = nullptr,
+                      bool ignore_clues = false);
+  bool is_valid_move(Cell *cell, int val, const FillState *state = nullptr,
+                     bool ignore_clues = false);
   bool repair_topology_robust(
       const std::unordered_map<std::pair<int, int>, int, PairHash> &alt_sol);
   std::unordered_map<Cell *, int> generate_breaking_constraints(
@@ -703,26 +1919,18 @@ private:
 
   bool
   is_connected(const std::unordered_set<std::pair<int, int>, PairHash> &coords);
-  std::vector<int> get_partition_aware_domain(
-      Cell *cell, const std::unordered_map<Cell *, int> &assignment,
-      const std::string &preference, const std::vector<int> &weights);
+  DigitList get_partition_aware_domain(Cell *cell, const FillState &state,
+                                       const std::string &preference,
+                                       const std::vector<int> &weights);
 
-  double
-  calculate_partition_score(Cell *cell, int value,
-                            const std::unordered_map<Cell *, int> &assignment,
-                            char direction, const std::string &preference);
+  double calculate_partition_score(Cell *cell, int value,
+                                   const FillState &state, char direction,
+                                   const std::string &preference);
 
   int count_partitions(int target_sum, int length);
 
-  int count_partitions_recursive(int remaining_sum, int remaining_length,
-                                 int min_digit, std::unordered_set<int> &used);
-
-  bool validate_partition_difficulty(
-      const std::unordered_map<Cell *, int> &assignment,
-      const std::string &preference);
-
-  // Cache for partition counts
-  std::unordered_map<std::pair<int, int>, int, PairHash> partition_cache;
+  bool validate_partition_difficulty(const FillState &state,
+                                     const std::string &preference);
 
   // Track scores for the current cell being filled (for logging)
   Cell *last_scored_cell = nullptr;
@@ -732,7 +1940,7 @@ private:
 class KakuroDifficultyEstimator {
 public:
   struct SectorInfo {
-    std::vector<Cell *> cells;
+    SectorSpan cells;
     int clue;
     bool is_horz;
   };
@@ -741,24 +1949,55 @@ public:
     int clue;
     int length;
   };
-  typedef std::unordered_map<Cell *, uint16_t> CandidateMap;
+  typedef kakuro::CandidateMap CandidateMap;
+
+  // What the techniques alone, without trial and error, make of the board
+  struct LogicProbe {
+    bool solved = false;        // Every cell fixed, so the solution is unique
+    bool contradiction = false; // A cell lost every digit: no solution
+    TechniqueTier max_tier = TechniqueTier::VERY_EASY; // EXTREME if unsolved
+    int open_cells = 0;  // Cells left with two or more digits
+    float open_bits = 0; // log2 of the digit combinations left open
+  };
 
   explicit KakuroDifficultyEstimator(std::shared_ptr<KakuroBoard> b);
   DifficultyResult estimate_difficulty_detailed();
+  // Runs only the logic phase of estimate_difficulty_detailed(). The next
+  // estimate of the same board continues from it instead of repeating it.
+  LogicProbe probe_logic();
+  // Bounded search for a solution other than the board's current values,
+  // following those values first so the difference stays small. Sound, unlike
+  // the techniques: anything found is a full solution.
+  bool find_alternative(
+      long long max_nodes,
+      std::unordered_map<std::pair<int, int>, int, PairHash> &alternative);
   float estimate_difficulty();
   bool apply_sector_constraints(const SectorInfo &sec, CandidateMap &candidates);
 
+  // Each estimate runs on a child of this budget that also ends after
+  // DEFAULT_DEADLINE_SEC; the search stops when it expires or after
+  // MAX_NODES nodes
+  void set_budget(std::shared_ptr<const GenerationBudget> budget) {
+    budget_ = std::move(budget);
+  }
+
+  // Search nodes used by the last estimate
+  long long get_nodes_explored() const { return nodes_explored; }
+  // Search nodes used by the last find_alternative
+  long long get_alternative_nodes() const { return alternative_nodes_; }
+
 private:
-  
+  friend struct KernelBench;
 
-  std::unordered_map<Cell *, SectorMetadata> cell_to_h;
-  std::unordered_map<Cell *, SectorMetadata> cell_to_v;
+  // Indexed by Cell::idx
+  std::vector<SectorMetadata> cell_to_h;
+  std::vector<SectorMetadata> cell_to_v;
 
   std::shared_ptr<KakuroBoard> board;
   std::vector<SolveStep> solve_log;
   std::vector<std::unordered_map<Cell *, int>> found_solutions;
   std::vector<SectorInfo> all_sectors;
-  std::unordered_set<Cell *> logged_singles;
+  std::vector<bool> logged_singles; // Indexed by Cell::idx
 
   // Using bitmasks (1 << value) for performance. 0x3FE = digits 1-9.
   
@@ -766,8 +2005,23 @@ private:
 
   int mask_to_digit(uint16_t mask) const;
 
+  // Every candidate change is logged as (cell, old mask) so the search and
+  // bifurcation work in place and undo on backtrack instead of copying
+  struct TrailEntry {
+    int idx;
+    uint16_t mask;
+  };
+  std::vector<TrailEntry> trail_;
+  void set_candidates(CandidateMap &candidates, Cell *cell, uint16_t mask);
+  void undo_to(size_t mark, CandidateMap &candidates);
+
   // Internal Logic Engine
   void run_solve_loop(CandidateMap &candidates, bool silent);
+  void run_logic_loop(CandidateMap &candidates, bool silent);
+  // Resets the limits and runs the logic phase into logic_state_
+  bool begin_estimate();
+  CandidateMap logic_state_;
+  bool logic_ready_ = false; // logic_state_ holds a probe not yet estimated
   bool apply_logic_pass(CandidateMap &candidates, bool silent, int iteration);
 
   // Techniques
@@ -782,48 +2036,53 @@ private:
   bool analyze_sector_pairs(CandidateMap &candidates);
   bool test_value_propagation(Cell *target, int val,
                               const CandidateMap &current_candidates);
-  std::vector<std::shared_ptr<std::vector<Cell *>>>
+  std::vector<SectorSpan>
   find_highly_constrained_sectors(const CandidateMap &candidates);
 
   // Infrastructure
-  void discover_solutions(CandidateMap candidates, int limit);
+  // Leaves `candidates` as it found them
+  void discover_solutions(CandidateMap &candidates, int limit);
+  // Leaves `candidates` at the alternative when it finds one
+  bool search_alternative(CandidateMap &candidates, long long &nodes,
+                          long long max_nodes);
   bool try_bifurcation(CandidateMap &candidates);
 
   // Helpers
-  std::optional<int> get_clue(const std::vector<Cell *> &sector, bool is_horz);
-  std::vector<std::vector<int>> get_partitions(int sum, int len);
-  uint16_t get_partition_bits(int sum, int len);
+  std::optional<int> get_clue(SectorSpan sector, bool is_horz);
   bool verify_math(const std::unordered_map<Cell *, int> &sol) const;
   std::vector<std::vector<std::optional<int>>>
   render_solution(const std::unordered_map<Cell *, int> &sol) const;
 
   // Avoid getting stuck
   long long nodes_explored = 0;
-  const long long MAX_NODES = 50000000; // Adjust based on desired effort
-  std::chrono::steady_clock::time_point start_time;
-  const double TIME_LIMIT_SEC = 30.0;
+  long long alternative_nodes_ = 0;
+  // MAX_NODES is the limit that repeats with a seed; the deadline, capped
+  // by budget_ when the caller sets one, only ends a search still running
+  static constexpr long long MAX_NODES = 50000000;
+  static constexpr double DEFAULT_DEADLINE_SEC = 30.0;
   bool search_aborted = false;
+  std::shared_ptr<const GenerationBudget> budget_;
+  std::shared_ptr<const GenerationBudget> estimate_budget_; // Current estimate
+
+  // Starts estimate_budget_ for a new estimate
+  void reset_deadline() {
+    estimate_budget_ = budget_ ? budget_->child(DEFAULT_DEADLINE_SEC)
+                               : GenerationBudget::create(DEFAULT_DEADLINE_SEC);
+  }
 
   bool is_limit_exceeded() {
     if (search_aborted)
       return true;
-    if (++nodes_explored > MAX_NODES) {
+    // The clock is read every few hundred nodes, cancellation every node
+    bool check_clock = ++nodes_explored % 512 == 0;
+    if (nodes_explored > MAX_NODES ||
+        (estimate_budget_ && (check_clock ? estimate_budget_->expired()
+                                          : estimate_budget_->is_cancelled()))) {
       search_aborted = true;
       return true;
     }
-    if (nodes_explored % 500 == 0) {
-      auto now = std::chrono::steady_clock::now();
-      std::chrono::duration<double> elapsed = now - start_time;
-      if (elapsed.count() > TIME_LIMIT_SEC) { // 2.5 second timeout
-        search_aborted = true;
-        return true;
-      }
-    }
     return false;
   }
-
-  std::map<std::pair<int, int>, std::vector<std::vector<int>>> partition_cache;
-  std::unordered_map<uint32_t, uint16_t> partition_mask_cache;
 };
 
 class HybridUniquenessChecker {
@@ -836,11 +2095,44 @@ public:
               std::optional<std::unordered_map<std::pair<int, int>, int, PairHash>>>
     check_uniqueness_hybrid(int max_nodes = 150000, int seed_offset = 0);
 
+    // Solves the board from its clues alone, ignoring and then restoring
+    // Cell::value: the uniqueness check's root reduction and search, with no
+    // solution to avoid. Stops once `limit` solutions are in `solutions`.
+    // Returns false if the node limit or budget ran out first, in which case
+    // `solutions` may be short.
+    bool solve_clues(int limit, int max_nodes,
+                     std::vector<std::unordered_map<std::pair<int, int>, int, PairHash>> &solutions);
+
+    // Splits the search after logical reduction over `threads` workers that
+    // steal subtrees from each other. The node budget is shared and the first
+    // alternative solution cancels the remaining work. Default is sequential.
+    void set_num_threads(int threads) { num_threads_ = std::max(1, threads); }
+    // Aborts the search when the budget is cancelled or runs out; the
+    // result is then INCONCLUSIVE
+    void set_budget(std::shared_ptr<const GenerationBudget> budget) { budget_ = std::move(budget); }
+
+    // Search nodes used by the last check
+    long long last_node_count() const { return last_node_count_; }
+
 private:
+    friend struct KernelBench;
     std::shared_ptr<KakuroBoard> board_;
+    int num_threads_ = 1;
+    int worker_id_ = 0;
+    std::shared_ptr<const GenerationBudget> budget_;
+    long long last_node_count_ = 0;
+    // Partition matching at search nodes is limited to sectors with at
+    // most this many open cells; the root reduction matches every sector.
+    // Larger limits cut nodes but cost more per node than they save.
+    static constexpr int SEARCH_PARTITION_OPEN_CELLS = 3;
+
+    using SolutionMap = std::unordered_map<std::pair<int, int>, int, PairHash>;
+    struct SearchState; // Node count, cancellation and results shared by workers
+    struct SearchTask;  // Subtree: candidate masks after propagation
+    class WorkPool;     // Per-worker task deques with stealing
     
     // Candidate tracking (bitmask per cell)
-    using CandidateMap = std::unordered_map<Cell*, uint16_t>;
+    using CandidateMap = kakuro::CandidateMap;
     static constexpr uint16_t ALL_CANDIDATES = 0x3FE; // bits 1-9
     
     // Result enum for logical steps
@@ -850,30 +2142,197 @@ private:
         CONTRADICTION
     };
 
+    // Event-driven propagation. Narrowing a mask queues the cell's two
+    // sectors, and every narrowing goes on a trail, so a search branch only
+    // revisits and undoes what it touched. Sector ids are horizontal ids,
+    // then sectors_h.capacity() + vertical id. Cell::value is kept set for
+    // exactly the cells whose mask is a single digit.
+    struct TrailEntry {
+        int idx;
+        uint16_t mask; // Before the change
+    };
+    std::vector<int> sector_queue_;
+    size_t queue_head_ = 0;
+    std::vector<char> sector_queued_;
+    std::vector<int> sector_clue_; // By sector id, 0 = no clue
+    std::vector<TrailEntry> trail_;
+
+    void init_propagation();
+    void enqueue_sectors(const Cell* cell);
+    SectorSpan sector_by_id(int id) const;
+    bool narrow(Cell* cell, uint16_t mask, CandidateMap& candidates);
+    // Runs the queue to a fixpoint; false on a contradiction. Partition
+    // matching is skipped for sectors with more open cells than the limit
+    bool propagate(CandidateMap& candidates, int partition_open_cells);
+    bool revise_sector(int id, CandidateMap& candidates, int partition_open_cells);
+    void undo_to(size_t mark, CandidateMap& candidates);
+
     // Apply logical deduction to reduce search space
-    ReductionResult apply_logical_reduction(CandidateMap& candidates, 
+    ReductionResult apply_logical_reduction(CandidateMap& candidates,
                                   const std::unordered_map<std::pair<int, int>, int, PairHash>& avoid_sol);
     
     // Hybrid search: logic first, then backtrack
     void hybrid_search(
-        std::vector<std::unordered_map<std::pair<int, int>, int, PairHash>>& found_solutions,
-        const std::unordered_map<std::pair<int, int>, int, PairHash>& avoid_sol,
+        SearchState& state,
+        const SolutionMap& avoid_sol,
         CandidateMap& candidates,
-        int& node_count, 
         int max_nodes, 
         int seed, 
-        bool& timed_out,
         bool is_on_avoid_path = true);
+
+    // Runs hybrid_search on board clones, one per worker thread
+    void parallel_search(SearchState& state, const SolutionMap& avoid_sol,
+                         const CandidateMap& candidates, int max_nodes, int seed);
+    // Parallel search when threads are set, else the sequential one
+    void run_search(SearchState& state, const SolutionMap& avoid_sol,
+                    CandidateMap& candidates, int max_nodes, int seed);
     
     // Convert between bitmask and vector
-    std::vector<int> mask_to_values(uint16_t mask) const;
+    DigitList mask_to_values(uint16_t mask) const;
     
     // Check if a value is valid given current partial solution
     bool is_valid_with_candidates(Cell* cell, int val, const CandidateMap& candidates);
-    bool can_assign_partition_to_sector(const std::vector<int>& partition, const std::vector<Cell*>& sector, const CandidateMap& candidates, int fixed_cell_idx, int fixed_val);
-    bool can_match_values_to_cells(const std::vector<int>& values, const std::vector<Cell*>& sector, const CandidateMap& candidates, int used_mask);
+    bool can_assign_partition_to_sector(uint16_t partition, SectorSpan sector, const CandidateMap& candidates, int fixed_cell_idx, int fixed_val);
+    bool can_match_values_to_cells(uint16_t values, SectorSpan sector, const CandidateMap& candidates, int used_mask);
+};
+
+// ============================================================================
+// BATCH GENERATION
+// ============================================================================
+
+// Generates up to `count` puzzles on `threads` workers (0 = hardware
+// concurrency). Every worker owns its board and solver, so the jobs share no
+// state. Board sizes are drawn uniformly from the inclusive width/height
+// ranges. Puzzles that still fail after a few retries are dropped, so the
+// result may hold fewer than `count` entries. Once `budget` expires the
+// running puzzles stop and the remaining slots are skipped.
+std::vector<GeneratedPuzzle>
+generate_batch(int count, std::pair<int, int> width_range,
+               std::pair<int, int> height_range,
+               const FillParams &fill_params = FillParams(),
+               const TopologyParams &topo_params = TopologyParams(),
+               int threads = 0,
+               std::shared_ptr<GenerationBudget> budget = nullptr);
+
+// One entry of a PuzzleStream's mix. Board sizes are drawn as in
+// generate_batch; `weight` is the target's share of new puzzles, 0 = none.
+struct StreamTarget {
+  std::pair<int, int> width_range{10, 10};
+  std::pair<int, int> height_range{10, 10};
+  FillParams fill_params;
+  TopologyParams topo_params;
+  double weight = 1.0;
+  // Queued plus in-progress puzzles of this difficulty before the target
+  // pauses, so a mix keeps every level stocked. 0 = only the capacity.
+  int max_queued = 0;
+};
+
+struct StreamedPuzzle {
+  std::string difficulty; // The target's fill_params.difficulty
+  GeneratedPuzzle puzzle;
+};
+
+// Producer threads generate puzzles for a weighted mix of targets into a
+// queue of at most `capacity` puzzles. A producer only starts a puzzle when
+// the queued and in-progress ones leave room, so a consumer that falls behind
+// stops production instead of piling up puzzles. Thread-safe.
+class PuzzleStream {
+public:
+  static constexpr int DEFAULT_CAPACITY = 16;
+
+  // Runs on the producer thread after a puzzle is queued, without the lock
+  using ReadyCallback =
+      std::function<void(const std::string &difficulty, size_t queued)>;
+
+  // `threads` = 0 uses hardware concurrency
+  explicit PuzzleStream(std::vector<StreamTarget> targets,
+                        int capacity = DEFAULT_CAPACITY, int threads = 0);
+  ~PuzzleStream(); // Stops the producers
+  PuzzleStream(const PuzzleStream &) = delete;
+  PuzzleStream &operator=(const PuzzleStream &) = delete;
+
+  void start(); // Starts the producers; no-op while they run
+  // Cancels the puzzles in progress and waits for the producers. Queued
+  // puzzles can still be popped.
+  void stop();
+  bool running() const;
+
+  // Replaces the mix; running producers pick it up with their next puzzle
+  void set_targets(std::vector<StreamTarget> targets);
+  void set_on_ready(ReadyCallback callback);
+  // Waits up to `timeout_ms` (< 0 = no limit) for a puzzle, the oldest of
+  // `difficulty` if given. Returns false on timeout, or once the stream is
+  // stopped without a matching puzzle.
+  bool pop(StreamedPuzzle &out, int timeout_ms = -1,
+           const std::string &difficulty = "");
+  size_t size() const;
+  size_t size(const std::string &difficulty) const; // Queued of `difficulty`
+  int capacity() const { return capacity_; }
+  long long produced() const;
+  long long failed() const; // Slots where every attempt failed
+
+private:
+  // -1 if every weight is 0 or every target is at its max_queued
+  int pick_target(std::mt19937 &rng) const;
+  int pending(const std::string &difficulty) const; // Queued + in progress
+  void produce(uint32_t seed);
+
+  int capacity_;
+  int threads_;
+  mutable std::mutex mutex_;
+  std::condition_variable space_; // Producers: room or new targets
+  std::condition_variable ready_; // Consumers: a puzzle or stop
+  std::vector<StreamTarget> targets_;
+  std::deque<StreamedPuzzle> queue_;
+  std::vector<std::string> in_progress_; // Difficulties being generated
+  ReadyCallback on_ready_;
+  long long produced_ = 0;
+  long long failed_ = 0;
+  bool running_ = false;
+  std::vector<std::thread> producers_;
+  std::shared_ptr<GenerationBudget> budget_; // Cancelled by stop()
 };
 
+// ============================================================================
+// BATCH SOLVING
+// ============================================================================
+
+enum class SolveMode {
+  SOLVE,  // The first solution found
+  COUNT,  // Solutions up to max_solutions
+  VERIFY, // Uniqueness, then the entries against the unique solution
+};
+
+struct SolveResult {
+  // False if the planes do not describe a board: sizes that do not match the
+  // data, an unknown cell type, or a run without a block and clue before it
+  bool valid = false;
+  // At most max_solutions (1 for SOLVE, 2 for VERIFY); only a lower bound
+  // when the node limit or budget ran out
+  int solution_count = 0;
+  bool exhausted = false;
+  long long nodes = 0;
+  // The first solution, [row][col] with 0 on blocks; empty if none was found
+  std::vector<uint8_t> solution;
+  // VERIFY on a puzzle with exactly one solution: the entries (non-zero
+  // SOLUTION plane cells) are compared against it. `solved` means every
+  // white cell holds its digit.
+  bool checked = false;
+  bool solved = false;
+  std::vector<std::pair<int, int>> wrong_cells;
+};
+
+// Solves grids given as export_planes lays them out; only the TYPE, CLUE_H
+// and CLUE_V planes are read, plus SOLUTION as the player's entries for
+// VERIFY. Runs the hybrid logic+search solver on `threads` workers (0 =
+// hardware concurrency) with `max_nodes` per grid. Results are in input
+// order. Grids left when `budget` expires are skipped with only `exhausted`
+// set.
+std::vector<SolveResult>
+solve_many(const std::vector<GridPlanes> &puzzles, SolveMode mode,
+           int max_solutions = 2, int threads = 0, int max_nodes = 150000,
+           std::shared_ptr<GenerationBudget> budget = nullptr);
+
 } // namespace kakuro
 
 #endif // KAKURO_CPP_H
\ No newline at end of file
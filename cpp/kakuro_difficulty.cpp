@@ -2,74 +2,146 @@
 
 namespace kakuro {
 
+namespace {
+
+// Tier and score weight of a solve_log technique
+TechniqueTier technique_tier(const std::string &technique, float &weight) {
+  if (technique == "unique_intersection" ||
+      technique == "elimination_singles") {
+    weight = 1.0f;
+    return TechniqueTier::VERY_EASY;
+  }
+  if (technique == "simple_partition") {
+    weight = 2.5f;
+    return TechniqueTier::EASY;
+  }
+  if (technique == "hidden_singles" || technique == "constraint_propagation") {
+    weight = 5.0f;
+    return TechniqueTier::MEDIUM;
+  }
+  if (technique == "complex_intersection") {
+    weight = 12.0f;
+    return TechniqueTier::HARD;
+  }
+  weight = 50.0f; // trial_and_error
+  return TechniqueTier::EXTREME;
+}
+
+} // namespace
+
 KakuroDifficultyEstimator::KakuroDifficultyEstimator(
     std::shared_ptr<KakuroBoard> b)
     : board(b) {
-  auto get_clue_internal = [&](const std::vector<Cell *> &s,
-                               bool is_h) -> std::optional<int> {
-    if (s.empty())
-      return std::nullopt;
-    int r = is_h ? s[0]->r : s[0]->r - 1;
-    int c = is_h ? s[0]->c - 1 : s[0]->c;
-    if (r < 0 || c < 0 || r >= board->height || c >= board->width)
-      return std::nullopt;
-    return is_h ? board->grid[r][c].clue_h : board->grid[r][c].clue_v;
-  };
-
-  for (auto &s : board->sectors_h) {
-    auto clue = get_clue_internal(*s, true);
-    if (clue) {
-      all_sectors.push_back({*s, *clue, true});
-      for (Cell *c : *s) {
-        cell_to_h[c] = {*clue, (int)s->size()};
-      }
-    }
-  }
-  for (auto &s : board->sectors_v) {
-    auto clue = get_clue_internal(*s, false);
-    if (clue) {
-      all_sectors.push_back({*s, *clue, false});
-      for (Cell *c : *s) {
-        cell_to_v[c] = {*clue, (int)s->size()};
+  cell_to_h.assign(board->white_cells.size(), SectorMetadata{0, 0});
+  cell_to_v.assign(board->white_cells.size(), SectorMetadata{0, 0});
+
+  auto add_sectors = [&](const SectorTable &sectors, bool is_h,
+                         std::vector<SectorMetadata> &cell_to) {
+    for (SectorSpan s : sectors) {
+      Cell *clue_cell = sectors.clue_cell(s.id());
+      std::optional<int> clue;
+      if (clue_cell)
+        clue = is_h ? clue_cell->clue_h : clue_cell->clue_v;
+      if (clue) {
+        all_sectors.push_back({s, *clue, is_h});
+        for (Cell *c : s) {
+          cell_to[c->idx] = {*clue, (int)s.size()};
+        }
       }
     }
-  }
+  };
+  add_sectors(board->sectors_h, true, cell_to_h);
+  add_sectors(board->sectors_v, false, cell_to_v);
 }
 
-DifficultyResult KakuroDifficultyEstimator::estimate_difficulty_detailed() {
-  PROFILE_FUNCTION(board->logger);
+bool KakuroDifficultyEstimator::begin_estimate() {
   solve_log.clear();
   found_solutions.clear();
-  partition_cache.clear();
-  logged_singles.clear();
+  trail_.clear();
+  logged_singles.assign(board->white_cells.size(), false);
+  logic_ready_ = false;
 
   // Reset limits
   nodes_explored = 0;
   search_aborted = false;
-  start_time = std::chrono::steady_clock::now();
+  reset_deadline();
 
   if (board->white_cells.empty() || all_sectors.empty())
-    return DifficultyResult();
-
-  CandidateMap logic_state;
-  for (Cell *c : board->white_cells) {
-    logic_state[c] = ALL_CANDIDATES;
+    return false;
+  if ((int)board->white_cells.size() > CandidateMap::MAX_CELLS) {
+    LOG_ERROR("Board has too many white cells for difficulty estimation: "
+              << board->white_cells.size());
+    return false;
   }
 
+  logic_state_.assign((int)board->white_cells.size(), ALL_CANDIDATES);
+
 #if KAKURO_ENABLE_LOGGING
   if (board->logger->is_enabled()) {
     board->logger->log_step(
         GenerationLogger::STAGE_DIFFICULTY, GenerationLogger::SUBSTAGE_START,
-        "Starting detailed difficulty analysis", board->get_grid_state());
+        "Starting detailed difficulty analysis", *board);
   }
 #endif
 
-  run_solve_loop(logic_state, false);
+  run_logic_loop(logic_state_, false);
+  trail_.clear(); // The logic pass is never undone
+  logic_ready_ = true;
+  return true;
+}
+
+KakuroDifficultyEstimator::LogicProbe
+KakuroDifficultyEstimator::probe_logic() {
+  PROFILE_FUNCTION(board->logger);
+  LogicProbe probe;
+  if (!begin_estimate()) {
+    probe.max_tier = TechniqueTier::EXTREME;
+    return probe;
+  }
+
+  for (const auto &step : solve_log) {
+    float weight;
+    probe.max_tier =
+        std::max(probe.max_tier, technique_tier(step.technique, weight));
+  }
+  for (auto *c : board->white_cells) {
+    int n = popcount9(logic_state_[c]);
+    if (n == 0)
+      probe.contradiction = true;
+    else if (n > 1) {
+      probe.open_cells++;
+      probe.open_bits += std::log2((float)n);
+    }
+  }
+  probe.solved = !probe.contradiction && probe.open_cells == 0;
+  // Like the estimate, an emptied cell does not count as open
+  if (probe.open_cells > 0)
+    probe.max_tier = TechniqueTier::EXTREME; // Needs trial and error
+  return probe;
+}
+
+DifficultyResult KakuroDifficultyEstimator::estimate_difficulty_detailed() {
+  PROFILE_FUNCTION(board->logger);
+  if (logic_ready_)
+    reset_deadline(); // A fresh deadline
+  else if (!begin_estimate())
+    return DifficultyResult();
+  logic_ready_ = false;
+
+  // Only if logic is stuck, try one level of bifurcation
+  bool solved = true;
+  for (auto *c : board->white_cells)
+    if (popcount9(logic_state_[c]) > 1)
+      solved = false;
+  if (!solved && !is_limit_exceeded()) {
+    solve_log.emplace_back("trial_and_error", 20.0f, 0);
+    try_bifurcation(logic_state_);
+  }
+  trail_.clear();
 
   // Now check solutions. Use 1-9 mask for search, NOT logic_state.
-  CandidateMap search_start;
-  for (Cell *c : board->white_cells)
-    search_start[c] = ALL_CANDIDATES;
+  const int num_cells = (int)board->white_cells.size();
+  CandidateMap search_start(num_cells, ALL_CANDIDATES);
   discover_solutions(search_start, 3);
 
   DifficultyResult res;
@@ -78,27 +150,8 @@ DifficultyResult KakuroDifficultyEstimator::estimate_difficulty_detailed() {
 
   for (const auto &step : solve_log) {
     // Map technique names to Tiers and Weights
-    TechniqueTier current_tier;
     float weight;
-
-    if (step.technique == "unique_intersection" ||
-        step.technique == "elimination_singles") {
-      current_tier = TechniqueTier::VERY_EASY;
-      weight = 1.0f;
-    } else if (step.technique == "simple_partition") {
-      current_tier = TechniqueTier::EASY;
-      weight = 2.5f;
-    } else if (step.technique == "hidden_singles" ||
-               step.technique == "constraint_propagation") {
-      current_tier = TechniqueTier::MEDIUM;
-      weight = 5.0f;
-    } else if (step.technique == "complex_intersection") {
-      current_tier = TechniqueTier::HARD;
-      weight = 12.0f;
-    } else { // trial_and_error
-      current_tier = TechniqueTier::EXTREME;
-      weight = 50.0f;
-    }
+    TechniqueTier current_tier = technique_tier(step.technique, weight);
 
     if ((int)current_tier > (int)highest_tier)
       highest_tier = current_tier;
@@ -142,7 +195,7 @@ DifficultyResult KakuroDifficultyEstimator::estimate_difficulty_detailed() {
 
 #if KAKURO_ENABLE_LOGGING
   if (board->logger && board->logger->is_enabled()) {
-    board->logger->log_difficulty(res, board->get_grid_state());
+    board->logger->log_difficulty(res, *board);
   }
 #endif
 
@@ -151,7 +204,7 @@ DifficultyResult KakuroDifficultyEstimator::estimate_difficulty_detailed() {
   return res;
 }
 
-void KakuroDifficultyEstimator::run_solve_loop(CandidateMap &candidates,
+void KakuroDifficultyEstimator::run_logic_loop(CandidateMap &candidates,
                                                bool silent) {
   bool changed = true;
   int iterations = 0;
@@ -160,6 +213,11 @@ void KakuroDifficultyEstimator::run_solve_loop(CandidateMap &candidates,
       return;
     changed = apply_logic_pass(candidates, silent, ++iterations);
   }
+}
+
+void KakuroDifficultyEstimator::run_solve_loop(CandidateMap &candidates,
+                                               bool silent) {
+  run_logic_loop(candidates, silent);
 
   // Only if logic is stuck, try one level of bifurcation
   bool solved = true;
@@ -214,7 +272,7 @@ bool KakuroDifficultyEstimator::find_hidden_singles(CandidateMap &candidates,
         }
       }
       if (count == 1 && popcount9(candidates.at(target)) > 1) {
-        candidates[target] = (1 << v);
+        set_candidates(candidates, target, (uint16_t)(1 << v));
         affected++;
       }
     }
@@ -224,17 +282,12 @@ bool KakuroDifficultyEstimator::find_hidden_singles(CandidateMap &candidates,
       solve_log.emplace_back("hidden_singles", 5.0f, affected);
 #if KAKURO_ENABLE_LOGGING
       if (board->logger->is_enabled()) {
-        std::unordered_map<Cell *, int> viz_map;
-        for (auto &[c, m] : candidates) {
-          if (popcount9(m) == 1)
-            viz_map[c] = mask_to_digit(m);
-        }
         board->logger->log_step(
             GenerationLogger::STAGE_DIFFICULTY,
             GenerationLogger::SUBSTAGE_LOGIC_STEP,
             "Applied hidden_singles: " + std::to_string(affected) +
                 " cells affected",
-            board->get_grid_state(&viz_map));
+            *board, &candidates);
       }
 #endif
     }
@@ -246,14 +299,13 @@ bool KakuroDifficultyEstimator::find_hidden_singles(CandidateMap &candidates,
 bool KakuroDifficultyEstimator::find_naked_singles(CandidateMap &candidates,
                                                    bool silent, int iteration) {
   if (!silent && iteration == 1)
-    logged_singles.clear();
+    logged_singles.assign(board->white_cells.size(), false);
 
   int newly_solved = 0;
   for (auto *c : board->white_cells) {
-    if (popcount9(candidates.at(c)) == 1 &&
-        logged_singles.find(c) == logged_singles.end()) {
+    if (popcount9(candidates.at(c)) == 1 && !logged_singles[c->idx]) {
       if (!silent)
-        logged_singles.insert(c);
+        logged_singles[c->idx] = true;
       newly_solved++;
     }
   }
@@ -261,17 +313,12 @@ bool KakuroDifficultyEstimator::find_naked_singles(CandidateMap &candidates,
     solve_log.emplace_back("elimination_singles", 2.0f, newly_solved);
 #if KAKURO_ENABLE_LOGGING
     if (board->logger->is_enabled()) {
-      std::unordered_map<Cell *, int> viz_map;
-      for (auto &[c, m] : candidates) {
-        if (popcount9(m) == 1)
-          viz_map[c] = mask_to_digit(m);
-      }
       board->logger->log_step(
           GenerationLogger::STAGE_DIFFICULTY,
           GenerationLogger::SUBSTAGE_LOGIC_STEP,
           "Applied elimination_singles: " + std::to_string(newly_solved) +
               " cells solved",
-          board->get_grid_state(&viz_map));
+          *board, &candidates);
     }
 #endif
     return true;
@@ -286,85 +333,45 @@ bool KakuroDifficultyEstimator::apply_sector_constraints(
 
   bool changed = false;
   int n = (int)sec.cells.size();
+  if (n > PARTITION_MAX_LEN) {
+    // No partition of this length exists, so no digit survives
+    for (auto *c : sec.cells) {
+      if (candidates[c]) {
+        set_candidates(candidates, c, 0);
+        changed = true;
+      }
+    }
+    return changed;
+  }
+
+  // The three steps run on the gathered masks; changed cells are written
+  // back once at the end
+  const SectorKernel &kernel = sector_kernel();
+  SectorMasks masks;
+  masks.size = n;
 
   // STEP 1: Bitmask Filter (Instant)
   // Eliminate digits that don't exist in ANY mathematical partition for this
   // clue/length.
-  uint16_t sector_allowed_mask = get_partition_bits(sec.clue, n);
-  for (auto *c : sec.cells) {
-    uint16_t old = candidates[c];
-    candidates[c] &= sector_allowed_mask;
-    if (candidates[c] != old)
-      changed = true;
-  }
+  uint16_t sector_allowed_mask = partition_union(sec.clue, n);
+  for (int i = 0; i < n; ++i)
+    masks.mask[i] = candidates[sec.cells[i]] & sector_allowed_mask;
 
   // STEP 2: Reachability Math (O(N))
   // For each cell, check if its current values can actually reach the clue sum
   // given the min/max possibilities of the other cells in the sector.
-  if (n > 1) {
-    // We pre-calculate the min and max for all cells to avoid redundant loops
-    std::vector<int> c_mins(n), c_maxs(n);
-    int total_min = 0, total_max = 0;
-
-    for (int i = 0; i < n; ++i) {
-      int mi = 10, ma = 0;
-      uint16_t mask = candidates[sec.cells[i]];
-      for (int v = 1; v <= 9; ++v) {
-        if (mask & (1 << v)) {
-          if (v < mi)
-            mi = v;
-          if (v > ma)
-            ma = v;
-        }
-      }
-      c_mins[i] = mi;
-      c_maxs[i] = ma;
-      total_min += mi;
-      total_max += ma;
-    }
-
-    for (int i = 0; i < n; ++i) {
-      uint16_t mask = candidates[sec.cells[i]];
-      uint16_t new_mask = mask;
-
-      // The "others" are the sum of everything except the current cell
-      int others_min = total_min - c_mins[i];
-      int others_max = total_max - c_maxs[i];
-
-      for (int v = 1; v <= 9; ++v) {
-        if (mask & (1 << v)) {
-          // If I pick value 'v', can the rest of the cells fill the gap?
-          // Gap required = Clue - v
-          if (v + others_min > sec.clue || v + others_max < sec.clue) {
-            new_mask &= ~(1 << v);
-          }
-        }
-      }
-
-      if (new_mask != mask) {
-        candidates[sec.cells[i]] = new_mask;
-        changed = true;
-        // If we pruned a value, we should update the total_min/max
-        // for the next cell in this loop, but even without doing that,
-        // the next logic pass will catch it.
-      }
-    }
-  }
+  if (n > 1)
+    kernel.bound_to_sum(masks, sec.clue, kernel.summarize(masks));
 
   // STEP 3: Unique Value Check (Sudoku style)
   // If a value is already "solved" in one cell, no other cell in the sector can
   // have it.
-  uint16_t solved_mask = 0;
-  for (auto *c : sec.cells) {
-    if (popcount9(candidates[c]) == 1)
-      solved_mask |= candidates[c];
-  }
-  for (auto *c : sec.cells) {
-    if (popcount9(candidates[c]) > 1) {
-      uint16_t old = candidates[c];
-      candidates[c] &= ~solved_mask;
-      if (candidates[c] != old)
-        changed = true;
+  kernel.remove_from_open(masks, kernel.summarize(masks).singles);
+
+  for (int i = 0; i < n; ++i) {
+    if (masks.mask[i] != candidates[sec.cells[i]]) {
+      set_candidates(candidates, sec.cells[i], masks.mask[i]);
+      changed = true;
     }
   }
 
@@ -379,10 +386,34 @@ int KakuroDifficultyEstimator::mask_to_digit(uint16_t mask) const {
   return 0;
 }
 
-void KakuroDifficultyEstimator::discover_solutions(CandidateMap candidates,
+void KakuroDifficultyEstimator::set_candidates(CandidateMap &candidates,
+                                               Cell *cell, uint16_t mask) {
+  trail_.push_back({cell->idx, candidates[cell]});
+  candidates[cell] = mask;
+}
+
+void KakuroDifficultyEstimator::undo_to(size_t mark,
+                                        CandidateMap &candidates) {
+  while (trail_.size() > mark) {
+    const TrailEntry &entry = trail_.back();
+    candidates[board->white_cells[entry.idx]] = entry.mask;
+    trail_.pop_back();
+  }
+}
+
+void KakuroDifficultyEstimator::discover_solutions(CandidateMap &candidates,
                                                    int limit) {
   if (found_solutions.size() >= limit || is_limit_exceeded())
     return;
+
+  // Undo this node's propagation and branch choices on every return
+  struct TrailRewind {
+    KakuroDifficultyEstimator *self;
+    CandidateMap &candidates;
+    size_t mark;
+    ~TrailRewind() { self->undo_to(mark, candidates); }
+  } rewind{this, candidates, trail_.size()};
+
   for (int i = 0; i < 3; ++i) {
     bool progress = false;
     for (auto &sec : all_sectors)
@@ -436,15 +467,109 @@ void KakuroDifficultyEstimator::discover_solutions(CandidateMap candidates,
     if (mask & (1 << v)) {
       if (search_aborted)
         break;
-      CandidateMap branch = candidates;
-      branch[mrv] = (1 << v);
-      discover_solutions(branch, limit);
+      size_t mark = trail_.size();
+      set_candidates(candidates, mrv, (uint16_t)(1 << v));
+      discover_solutions(candidates, limit);
+      undo_to(mark, candidates);
       if (found_solutions.size() >= limit)
         break;
     }
   }
 }
 
+bool KakuroDifficultyEstimator::find_alternative(
+    long long max_nodes,
+    std::unordered_map<std::pair<int, int>, int, PairHash> &alternative) {
+  PROFILE_FUNCTION(board->logger);
+  alternative_nodes_ = 0;
+  if (board->white_cells.empty() ||
+      (int)board->white_cells.size() > CandidateMap::MAX_CELLS)
+    return false;
+
+  // Own candidates and trail segment, so a probed logic state survives
+  size_t mark = trail_.size();
+  CandidateMap candidates((int)board->white_cells.size(), ALL_CANDIDATES);
+  bool found = search_alternative(candidates, alternative_nodes_, max_nodes);
+  if (found) {
+    for (auto *c : board->white_cells)
+      alternative[{c->r, c->c}] = mask_to_digit(candidates[c]);
+  }
+  undo_to(mark, candidates);
+  return found;
+}
+
+bool KakuroDifficultyEstimator::search_alternative(CandidateMap &candidates,
+                                                   long long &nodes,
+                                                   long long max_nodes) {
+  if (++nodes > max_nodes || (budget_ && budget_->expired()))
+    return false;
+  size_t mark = trail_.size();
+
+  bool progress = true;
+  while (progress) {
+    progress = false;
+    for (auto &sec : all_sectors)
+      if (apply_sector_constraints(sec, candidates))
+        progress = true;
+  }
+  Cell *mrv = nullptr;
+  int min_b = 10;
+  for (auto *c : board->white_cells) {
+    int b = popcount9(candidates[c]);
+    if (b == 0) {
+      undo_to(mark, candidates);
+      return false;
+    }
+    if (b > 1 && b < min_b) {
+      min_b = b;
+      mrv = c;
+    }
+  }
+
+  if (!mrv) {
+    bool differs = false;
+    for (auto *c : board->white_cells)
+      if (mask_to_digit(candidates[c]) != c->value.value_or(0)) {
+        differs = true;
+        break;
+      }
+    for (auto &sec : all_sectors) {
+      if (!differs)
+        break;
+      int sum = 0;
+      uint16_t seen = 0;
+      for (auto *c : sec.cells) {
+        sum += mask_to_digit(candidates[c]);
+        seen |= candidates[c];
+      }
+      differs = sum == sec.clue && popcount9(seen) == (int)sec.cells.size();
+    }
+    if (!differs)
+      undo_to(mark, candidates);
+    return differs;
+  }
+
+  // The current value first, then the others in order
+  uint16_t mask = candidates[mrv];
+  int current = mrv->value.value_or(0);
+  uint16_t first = mask & (uint16_t)(1 << current);
+  for (uint16_t pending : {first, (uint16_t)(mask & ~first)}) {
+    for (int v = 1; v <= 9; ++v) {
+      if (!(pending & (1 << v)))
+        continue;
+      size_t branch = trail_.size();
+      set_candidates(candidates, mrv, (uint16_t)(1 << v));
+      if (search_alternative(candidates, nodes, max_nodes))
+        return true;
+      undo_to(branch, candidates);
+      if (nodes > max_nodes)
+        break;
+    }
+  }
+  undo_to(mark, candidates);
+  return false;
+}
+
 bool KakuroDifficultyEstimator::find_unique_intersections(
     CandidateMap &candidates, bool silent) {
   bool changed = false;
@@ -455,17 +580,17 @@ bool KakuroDifficultyEstimator::find_unique_intersections(
       continue;
 
     // O(1) Lookup: No more looping through all_sectors!
-    SectorMetadata &h = cell_to_h[cell];
-    SectorMetadata &v = cell_to_v[cell];
+    SectorMetadata &h = cell_to_h[cell->idx];
+    SectorMetadata &v = cell_to_v[cell->idx];
 
-    uint16_t h_mask = get_partition_bits(h.clue, h.length);
-    uint16_t v_mask = get_partition_bits(v.clue, v.length);
+    uint16_t h_mask = partition_union(h.clue, h.length);
+    uint16_t v_mask = partition_union(v.clue, v.length);
 
     uint16_t combined_constraint = h_mask & v_mask;
     uint16_t new_candidates = candidates[cell] & combined_constraint;
 
     if (new_candidates != candidates[cell]) {
-      candidates[cell] = new_candidates;
+      set_candidates(candidates, cell, new_candidates);
       changed = true;
       if (popcount9(new_candidates) == 1)
         affected++;
@@ -475,16 +600,11 @@ bool KakuroDifficultyEstimator::find_unique_intersections(
     solve_log.emplace_back("unique_intersection", 0.5f, affected);
 #if KAKURO_ENABLE_LOGGING
     if (board->logger->is_enabled()) {
-      std::unordered_map<Cell *, int> viz_map;
-      for (auto &[c, m] : candidates) {
-        if (popcount9(m) == 1)
-          viz_map[c] = mask_to_digit(m);
-      }
       board->logger->log_step(GenerationLogger::STAGE_DIFFICULTY,
                               GenerationLogger::SUBSTAGE_LOGIC_STEP,
                               "Applied unique_intersection: " +
                                   std::to_string(affected) + " cells affected",
-                              board->get_grid_state(&viz_map));
+                              *board, &candidates);
     }
 #endif
   }
@@ -496,15 +616,13 @@ bool KakuroDifficultyEstimator::apply_simple_partitions(
   bool ch = false;
   int aff = 0;
   for (auto &sec : all_sectors) {
-    auto ps = get_partitions(sec.clue, (int)sec.cells.size());
+    auto ps = partitions_of(sec.clue, (int)sec.cells.size());
     if (ps.size() == 1) {
-      uint16_t m = 0;
-      for (int v : ps[0])
-        m |= (1 << v);
+      uint16_t m = *ps.begin();
       for (auto *c : sec.cells) {
         uint16_t old = candidates.at(c);
-        candidates[c] &= m;
-        if (candidates.at(c) != old) {
+        if ((old & m) != old) {
+          set_candidates(candidates, c, old & m);
           ch = true;
           aff++;
         }
@@ -515,16 +633,11 @@ bool KakuroDifficultyEstimator::apply_simple_partitions(
     solve_log.emplace_back("simple_partition", 1.0f, aff);
 #if KAKURO_ENABLE_LOGGING
     if (board->logger->is_enabled()) {
-      std::unordered_map<Cell *, int> viz_map;
-      for (auto &[c, m] : candidates) {
-        if (popcount9(m) == 1)
-          viz_map[c] = mask_to_digit(m);
-      }
       board->logger->log_step(GenerationLogger::STAGE_DIFFICULTY,
                               GenerationLogger::SUBSTAGE_LOGIC_STEP,
                               "Applied simple_partition: " +
                                   std::to_string(aff) + " cells affected",
-                              board->get_grid_state(&viz_map));
+                              *board, &candidates);
     }
 #endif
   }
@@ -546,17 +659,12 @@ bool KakuroDifficultyEstimator::apply_constraint_propagation(
     solve_log.emplace_back("constraint_propagation", 4.0f, affected_cells);
 #if KAKURO_ENABLE_LOGGING
     if (board->logger->is_enabled()) {
-      std::unordered_map<Cell *, int> viz_map;
-      for (auto &[c, m] : candidates) {
-        if (popcount9(m) == 1)
-          viz_map[c] = mask_to_digit(m);
-      }
       board->logger->log_step(
           GenerationLogger::STAGE_DIFFICULTY,
           GenerationLogger::SUBSTAGE_LOGIC_STEP,
           "Applied constraint_propagation: " + std::to_string(affected_cells) +
               " cells affected",
-          board->get_grid_state(&viz_map));
+          *board, &candidates);
     }
 #endif
   }
@@ -581,14 +689,7 @@ bool KakuroDifficultyEstimator::analyze_complex_intersections(
             in = true;
         if (!in)
           continue;
-        bool p_ok = false;
-        for (auto &p : get_partitions(sec.clue, (int)sec.cells.size())) {
-          if (std::find(p.begin(), p.end(), v) != p.end()) {
-            p_ok = true;
-            break;
-          }
-        }
-        if (!p_ok) {
+        if (!(partition_union(sec.clue, (int)sec.cells.size()) & (1 << v))) {
           ok = false;
           break;
         }
@@ -597,7 +698,7 @@ bool KakuroDifficultyEstimator::analyze_complex_intersections(
         valid |= (1 << v);
     }
     if (valid != 0 && valid != mask) {
-      candidates[cell] = valid;
+      set_candidates(candidates, cell, valid);
       ch = true;
     }
   }
@@ -605,15 +706,10 @@ bool KakuroDifficultyEstimator::analyze_complex_intersections(
     solve_log.emplace_back("complex_intersection", 6.0f, 1);
 #if KAKURO_ENABLE_LOGGING
     if (board->logger->is_enabled()) {
-      std::unordered_map<Cell *, int> viz_map;
-      for (auto &[c, m] : candidates) {
-        if (popcount9(m) == 1)
-          viz_map[c] = mask_to_digit(m);
-      }
       board->logger->log_step(GenerationLogger::STAGE_DIFFICULTY,
                               GenerationLogger::SUBSTAGE_LOGIC_STEP,
                               "Applied complex_intersection",
-                              board->get_grid_state(&viz_map));
+                              *board, &candidates);
     }
 #endif
   }
@@ -640,62 +736,24 @@ bool KakuroDifficultyEstimator::try_bifurcation(CandidateMap &candidates) {
     if (mask & (1 << v)) {
       if (is_limit_exceeded())
         return false;
-      CandidateMap test = candidates;
-      test[target] = (1 << v);
-      run_solve_loop(test, true);
+      // Test the digit in place and keep the result only if it solves
+      size_t mark = trail_.size();
+      set_candidates(candidates, target, (uint16_t)(1 << v));
+      run_solve_loop(candidates, true);
       bool ok = true;
       for (auto *c : board->white_cells)
-        if (popcount9(test.at(c)) != 1) {
+        if (popcount9(candidates.at(c)) != 1) {
           ok = false;
           break;
         }
-      if (ok) {
-        candidates = test;
+      if (ok)
         return true;
-      }
+      undo_to(mark, candidates);
     }
   }
   return false;
 }
 
-std::vector<std::vector<int>>
-KakuroDifficultyEstimator::get_partitions(int sum, int len) {
-  if (partition_cache.count({sum, len}))
-    return partition_cache[{sum, len}];
-  std::vector<std::vector<int>> res;
-  std::vector<int> cur;
-  std::function<void(int, int, int)> bt = [&](int t, int k, int s) {
-    if (k == 0) {
-      if (t == 0)
-        res.push_back(cur);
-      return;
-    }
-    for (int i = s; i <= 9; ++i) {
-      if (i > t)
-        break;
-      cur.push_back(i);
-      bt(t - i, k - 1, i + 1);
-      cur.pop_back();
-    }
-  };
-  bt(sum, len, 1);
-  return partition_cache[{sum, len}] = res;
-}
-
-uint16_t KakuroDifficultyEstimator::get_partition_bits(int sum, int len) {
-  uint32_t key = (sum << 8) | len;
-  if (partition_mask_cache.count(key))
-    return partition_mask_cache[key];
-
-  uint16_t mask = 0;
-  auto partitions = get_partitions(sum, len); // Use your existing logic once
-  for (const auto &p : partitions) {
-    for (int v : p)
-      mask |= (1 << v);
-  }
-  return partition_mask_cache[key] = mask;
-}
-
 bool KakuroDifficultyEstimator::verify_math(
     const std::unordered_map<Cell *, int> &sol) const {
   for (auto &sec : all_sectors) {
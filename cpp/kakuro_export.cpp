@@ -0,0 +1,212 @@
+#include "kakuro_cpp.h"
+#include <cstdio>
+
+namespace kakuro {
+
+namespace {
+
+uint8_t plane_value(const std::optional<int> &v) {
+  return v ? (uint8_t)*v : 0;
+}
+
+void append_int(std::string &out, long long v) { out += std::to_string(v); }
+
+// Enough digits that the value parses back to the same double
+void append_double(std::string &out, double v, const char *format = "%.17g") {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), format, v);
+  out += buf;
+}
+
+void append_string(std::string &out, const std::string &s) {
+  out += '"';
+  for (char ch : s) {
+    switch (ch) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if ((unsigned char)ch < 0x20) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+        out += buf;
+      } else {
+        out += ch;
+      }
+    }
+  }
+  out += '"';
+}
+
+// Values are quoted to match the string map KakuroBoard::to_dict returns
+void append_quoted_int(std::string &out, int v) {
+  out += '"';
+  append_int(out, v);
+  out += '"';
+}
+
+void append_cell(std::string &out, int r, int c, CellType type,
+                 const std::optional<int> &value,
+                 const std::optional<int> &clue_h,
+                 const std::optional<int> &clue_v) {
+  out += "{\"r\":";
+  append_quoted_int(out, r);
+  out += ",\"c\":";
+  append_quoted_int(out, c);
+  out += type == CellType::BLOCK ? ",\"type\":\"BLOCK\"" : ",\"type\":\"WHITE\"";
+  if (value) {
+    out += ",\"value\":";
+    append_quoted_int(out, *value);
+  }
+  if (clue_h) {
+    out += ",\"clue_h\":";
+    append_quoted_int(out, *clue_h);
+  }
+  if (clue_v) {
+    out += ",\"clue_v\":";
+    append_quoted_int(out, *clue_v);
+  }
+  out += '}';
+}
+
+// `append_cell_at(r, c)` appends the object for one cell
+template <typename AppendCell>
+void append_grid(std::string &out, int width, int height,
+                 AppendCell append_cell_at) {
+  out += '[';
+  for (int r = 0; r < height; r++) {
+    if (r)
+      out += ',';
+    out += '[';
+    for (int c = 0; c < width; c++) {
+      if (c)
+        out += ',';
+      append_cell_at(r, c);
+    }
+    out += ']';
+  }
+  out += ']';
+}
+
+void append_puzzle_grid(std::string &out, const GeneratedPuzzle &puzzle) {
+  append_grid(out, puzzle.width, puzzle.height, [&](int r, int c) {
+    const PuzzleCell &cell = puzzle.grid[r][c];
+    append_cell(out, r, c, cell.type, cell.solution, cell.clue_h, cell.clue_v);
+  });
+}
+
+void append_difficulty(std::string &out, const DifficultyResult &d) {
+  out += "{\"rating\":";
+  append_string(out, d.rating);
+  out += ",\"score\":";
+  append_double(out, d.score, "%.2f");
+  out += ",\"max_tier\":";
+  append_int(out, (int)d.max_tier);
+  out += ",\"total_steps\":";
+  append_int(out, d.total_steps);
+  out += ",\"uniqueness\":";
+  append_string(out, d.uniqueness);
+  out += ",\"solution_count\":";
+  append_int(out, d.solution_count);
+  out += ",\"solve_path\":[";
+  for (size_t i = 0; i < d.solve_path.size(); i++) {
+    const SolveStep &step = d.solve_path[i];
+    if (i)
+      out += ',';
+    out += "{\"technique\":";
+    append_string(out, step.technique);
+    out += ",\"weight\":";
+    append_double(out, step.difficulty_weight);
+    out += ",\"cells\":";
+    append_int(out, step.cells_affected);
+    out += '}';
+  }
+  out += "]}";
+}
+
+} // namespace
+
+GridPlanes export_planes(const KakuroBoard &board) {
+  GridPlanes planes(board.width, board.height);
+  for (int r = 0; r < board.height; r++) {
+    for (int c = 0; c < board.width; c++) {
+      const Cell &cell = board.grid[r][c];
+      planes.at(GridPlanes::TYPE, r, c) = cell.type == CellType::WHITE
+                                              ? GridPlanes::TYPE_WHITE
+                                              : GridPlanes::TYPE_BLOCK;
+      planes.at(GridPlanes::CLUE_H, r, c) = plane_value(cell.clue_h);
+      planes.at(GridPlanes::CLUE_V, r, c) = plane_value(cell.clue_v);
+      planes.at(GridPlanes::SOLUTION, r, c) = plane_value(cell.value);
+    }
+  }
+  return planes;
+}
+
+GridPlanes export_planes(const GeneratedPuzzle &puzzle) {
+  GridPlanes planes(puzzle.width, puzzle.height);
+  for (int r = 0; r < puzzle.height; r++) {
+    for (int c = 0; c < puzzle.width; c++) {
+      const PuzzleCell &cell = puzzle.grid[r][c];
+      planes.at(GridPlanes::TYPE, r, c) = cell.type == CellType::WHITE
+                                              ? GridPlanes::TYPE_WHITE
+                                              : GridPlanes::TYPE_BLOCK;
+      planes.at(GridPlanes::CLUE_H, r, c) = plane_value(cell.clue_h);
+      planes.at(GridPlanes::CLUE_V, r, c) = plane_value(cell.clue_v);
+      planes.at(GridPlanes::SOLUTION, r, c) = plane_value(cell.solution);
+    }
+  }
+  return planes;
+}
+
+std::string grid_to_json(const KakuroBoard &board) {
+  std::string out;
+  // A clued or filled cell is about 50 bytes
+  out.reserve((size_t)board.width * board.height * 56);
+  append_grid(out, board.width, board.height, [&](int r, int c) {
+    const Cell &cell = board.grid[r][c];
+    append_cell(out, r, c, cell.type, cell.value, cell.clue_h, cell.clue_v);
+  });
+  return out;
+}
+
+std::string grid_to_json(const GeneratedPuzzle &puzzle) {
+  std::string out;
+  out.reserve((size_t)puzzle.width * puzzle.height * 56);
+  append_puzzle_grid(out, puzzle);
+  return out;
+}
+
+std::string difficulty_to_json(const DifficultyResult &difficulty) {
+  std::string out;
+  append_difficulty(out, difficulty);
+  return out;
+}
+
+std::string puzzle_to_json(const GeneratedPuzzle &puzzle) {
+  std::string out;
+  out.reserve((size_t)puzzle.width * puzzle.height * 56 + 1024);
+  out += "{\"width\":";
+  append_int(out, puzzle.width);
+  out += ",\"height\":";
+  append_int(out, puzzle.height);
+  out += ",\"difficulty\":";
+  append_difficulty(out, puzzle.difficulty);
+  out += ",\"grid\":";
+  append_puzzle_grid(out, puzzle);
+  out += '}';
+  return out;
+}
+
+} // namespace kakuro
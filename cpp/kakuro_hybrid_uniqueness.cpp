@@ -1,8 +1,115 @@
 #include "kakuro_cpp.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 
 namespace kakuro {
 
+struct HybridUniquenessChecker::SearchState {
+    std::atomic<int> node_count{0};
+    std::atomic<bool> timed_out{false};
+    std::atomic<bool> stop{false}; // Set once solution_limit are found or on timeout
+    std::atomic<bool> cancelled{false};
+    std::mutex found_mutex;
+    std::vector<SolutionMap> found_solutions;
+    size_t solution_limit = 1;
+    WorkPool* pool = nullptr; // Only set in parallel mode
+};
+
+struct HybridUniquenessChecker::SearchTask {
+    CandidateMap candidates;
+    bool on_avoid_path = true;
+};
+
+// Each worker pushes and pops subtrees at the back of its own deque; idle
+// workers steal the oldest (largest) subtree from the front of another one.
+class HybridUniquenessChecker::WorkPool {
+public:
+    explicit WorkPool(int workers) : queues_(workers), locks_(workers) {}
+
+    // True while more workers are waiting than tasks are queued
+    bool wants_work() const { return idle_.load() > queued_.load(); }
+
+    void push(int worker, SearchTask&& task) {
+        pending_++;
+        queued_++;
+        {
+            std::lock_guard<std::mutex> lock(locks_[worker]);
+            queues_[worker].push_back(std::move(task));
+        }
+        notify(false);
+    }
+
+    // Blocks until a task is available. Returns false once every task has
+    // finished or the search was cancelled; cancel() must follow a stop.
+    bool next(int worker, SearchTask& task, const std::atomic<bool>& stop) {
+        while (!stop.load()) {
+            if (try_pop(worker, task)) return true;
+            if (pending_.load() == 0) return false;
+
+            idle_++;
+            {
+                std::unique_lock<std::mutex> lock(wait_mutex_);
+                wake_.wait(lock, [&] {
+                    return queued_.load() > 0 || pending_.load() == 0 || stop.load();
+                });
+            }
+            idle_--;
+        }
+        return false;
+    }
+
+    void finish() {
+        if (--pending_ == 0) notify(true);
+    }
+
+    void cancel() { notify(true); }
+
+private:
+    std::vector<std::deque<SearchTask>> queues_;
+    std::vector<std::mutex> locks_;
+    std::atomic<int> pending_{0}; // Pushed but not yet finished
+    std::atomic<int> queued_{0};  // Pushed but not yet taken
+    std::atomic<int> idle_{0};
+    std::mutex wait_mutex_;
+    std::condition_variable wake_;
+
+    // Waiters test their predicate under wait_mutex_, so taking it after
+    // the change means none of them can miss the notify
+    void notify(bool all) {
+        { std::lock_guard<std::mutex> lock(wait_mutex_); }
+        if (all) wake_.notify_all();
+        else wake_.notify_one();
+    }
+
+    bool try_pop(int worker, SearchTask& task) {
+        {
+            std::lock_guard<std::mutex> lock(locks_[worker]);
+            auto& own = queues_[worker];
+            if (!own.empty()) {
+                task = std::move(own.back());
+                own.pop_back();
+                queued_--;
+                return true;
+            }
+        }
+        int n = (int)queues_.size();
+        for (int i = 1; i < n; i++) {
+            int victim = (worker + i) % n;
+            std::lock_guard<std::mutex> lock(locks_[victim]);
+            auto& other = queues_[victim];
+            if (!other.empty()) {
+                task = std::move(other.front());
+                other.pop_front();
+                queued_--;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
 // Implementation of HybridUniquenessChecker
 // (Class declaration should be in kakuro_cpp.h)
 std::pair<UniquenessResult, 
@@ -27,20 +134,21 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
     }
     
     // 2. Initialize candidates with full domain
-    CandidateMap candidates;
-    for (Cell* c : board_->white_cells) {
-        candidates[c] = ALL_CANDIDATES;
+    if ((int)board_->white_cells.size() > CandidateMap::MAX_CELLS) {
+        LOG_ERROR("Board has too many white cells for the uniqueness check: " << board_->white_cells.size());
+        for (auto& [c, v] : original_sol) c->value = v;
+        return {UniquenessResult::INCONCLUSIVE, std::nullopt};
     }
+    CandidateMap candidates((int)board_->white_cells.size(), ALL_CANDIDATES);
 
     // DEBUG: Verify that original_sol is actually valid for this topology
     {
         PROFILE_SCOPE("Uniqueness_IntegrityCheck", board_->logger);
         bool integrity_fail = false;
         
-        auto check_integrity = [&](const std::vector<std::shared_ptr<std::vector<Cell*>>>& sectors, bool is_horz) {
-            for (const auto& sec : sectors) {
-                if (sec->empty()) continue;
-                Cell* first = (*sec)[0];
+        auto check_integrity = [&](const SectorTable& sectors, bool is_horz) {
+            for (SectorSpan sec : sectors) {
+                Cell* first = sec[0];
                 std::optional<int> clue_opt;
                 if (is_horz && first->c > 0) clue_opt = board_->grid[first->r][first->c - 1].clue_h;
                 else if (!is_horz && first->r > 0) clue_opt = board_->grid[first->r - 1][first->c].clue_v;
@@ -56,7 +164,7 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
                 uint16_t used_mask = 0;
                 std::vector<int> vals;
                 
-                for (Cell* c : *sec) {
+                for (Cell* c : sec) {
                     if (original_sol.count(c)) {
                         int v = original_sol.at(c);
                         if (used_mask & (1 << v)) {
@@ -101,8 +209,8 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
             uint16_t valid_mask = ALL_CANDIDATES;
             
             // Check horizontal sector for used values
-            if (cell->sector_h) {
-                for (Cell* neighbor : *(cell->sector_h)) {
+            if (cell->sector_h >= 0) {
+                for (Cell* neighbor : board_->h_sector(cell)) {
                     if (neighbor != cell && neighbor->value.has_value()) {
                         valid_mask &= ~(1 << *neighbor->value);
                     }
@@ -110,8 +218,8 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
             }
             
             // Check vertical sector for used values
-            if (cell->sector_v) {
-                for (Cell* neighbor : *(cell->sector_v)) {
+            if (cell->sector_v >= 0) {
+                for (Cell* neighbor : board_->v_sector(cell)) {
                     if (neighbor != cell && neighbor->value.has_value()) {
                         valid_mask &= ~(1 << *neighbor->value);
                     }
@@ -122,12 +230,11 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
         }
         
         // Basic sum constraint filtering
-        auto init_sector_constraints = [&](const std::vector<std::shared_ptr<std::vector<Cell*>>>& sectors, bool is_horz) {
-            for (const auto& sector : sectors) {
-                if (sector->empty()) continue;
+        auto init_sector_constraints = [&](const SectorTable& sectors, bool is_horz) {
+            for (SectorSpan sector : sectors) {
                 
                 // Get the clue
-                Cell* first = (*sector)[0];
+                Cell* first = sector[0];
                 std::optional<int> clue_opt;
                 
                 if (is_horz && first->c > 0) {
@@ -138,7 +245,7 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
                 
                 if (!clue_opt.has_value()) continue;
                 int target = *clue_opt;
-                int length = sector->size();
+                int length = sector.size();
                 
                 // Calculate min and max possible sums for this sector
                 int min_sum = 0, max_sum = 0;
@@ -153,37 +260,12 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
                 if (target < min_sum || target > max_sum) continue;
                 
                 // FIX: Use proper partition-based filtering instead of loose bounds
-                // Generate all valid partitions for this clue/length
-                std::vector<std::vector<int>> valid_partitions;
-                {
-                    std::vector<int> cur;
-                    std::function<void(int, int, int)> gen_partitions = [&](int remaining, int slots, int start) {
-                        if (slots == 0) {
-                            if (remaining == 0) valid_partitions.push_back(cur);
-                            return;
-                        }
-                        for (int d = start; d <= 9; d++) {
-                            if (d > remaining) break;
-                            cur.push_back(d);
-                            gen_partitions(remaining - d, slots - 1, d + 1);
-                            cur.pop_back();
-                        }
-                    };
-                    gen_partitions(target, length, 1);
-                }
-                
-                if (valid_partitions.empty()) continue; // No valid partitions exist
-                
-                // Build a mask of all digits that appear in ANY valid partition
-                uint16_t valid_digits_mask = 0;
-                for (const auto& partition : valid_partitions) {
-                    for (int d : partition) {
-                        valid_digits_mask |= (1 << d);
-                    }
-                }
+                // Mask of all digits that appear in ANY valid partition
+                uint16_t valid_digits_mask = partition_union(target, length);
+                if (valid_digits_mask == 0) continue; // No valid partitions exist
                 
                 // Apply this mask to all cells in the sector
-                for (Cell* cell : *sector) {
+                for (Cell* cell : sector) {
                     candidates[cell] &= valid_digits_mask;
                 }
             }
@@ -202,17 +284,17 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
                     LOG_ERROR("INIT VALIDATION FAILED: Cell (" << c->r << "," << c->c << ") original value " << sol_val << " is not in candidates after init! Candidates mask: " << candidates[c]);
                     
                     // Log sector info for debugging
-                    if (c->sector_h) {
-                        Cell* first_h = (*c->sector_h)[0];
+                    if (c->sector_h >= 0) {
+                        Cell* first_h = board_->h_sector(c)[0];
                         std::optional<int> clue_h;
                         if (first_h->c > 0) clue_h = board_->grid[first_h->r][first_h->c - 1].clue_h;
-                        LOG_ERROR("  H-sector: length=" << c->sector_h->size() << ", clue=" << (clue_h ? std::to_string(*clue_h) : "NONE"));
+                        LOG_ERROR("  H-sector: length=" << board_->h_sector(c).size() << ", clue=" << (clue_h ? std::to_string(*clue_h) : "NONE"));
                     }
-                    if (c->sector_v) {
-                        Cell* first_v = (*c->sector_v)[0];
+                    if (c->sector_v >= 0) {
+                        Cell* first_v = board_->v_sector(c)[0];
                         std::optional<int> clue_v;
                         if (first_v->r > 0) clue_v = board_->grid[first_v->r - 1][first_v->c].clue_v;
-                        LOG_ERROR("  V-sector: length=" << c->sector_v->size() << ", clue=" << (clue_v ? std::to_string(*clue_v) : "NONE"));
+                        LOG_ERROR("  V-sector: length=" << board_->v_sector(c).size() << ", clue=" << (clue_v ? std::to_string(*clue_v) : "NONE"));
                     }
                 }
             }
@@ -225,7 +307,8 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
     // 5. Count how many cells are logically determined
     int determined_cells = 0;
     int total_candidates_start = 0;
-    for (auto& [cell, mask] : candidates) {
+    for (Cell* cell : board_->white_cells) {
+        uint16_t mask = candidates[cell];
         if (popcount9(mask) == 1) {
             determined_cells++;
         }
@@ -244,6 +327,7 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
     
     {
         PROFILE_SCOPE("Uniqueness_LogicalReduction", board_->logger);
+        init_propagation();
         ReductionResult result = apply_logical_reduction(candidates, original_sol_coords);
         
         if (result == ReductionResult::CHANGED) reduced = true;
@@ -252,8 +336,8 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
         if (result == ReductionResult::CONTRADICTION) {
             logic_consistent = false;
         } else {
-             for (auto& [c, m] : candidates) {
-                if (m == 0) {
+             for (Cell* c : board_->white_cells) {
+                if (candidates[c] == 0) {
                     logic_consistent = false;
                     break;
                 }
@@ -279,28 +363,17 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
                 GenerationLogger::STAGE_UNIQUENESS,
                 GenerationLogger::SUBSTAGE_LOGIC_STEP,
                 "Logical reduction caused contradiction: reverting",
-                board_->get_grid_state());
+                *board_);
         }
 #endif
     } else {
         LOG_DEBUG("    Logical reduction: " << (reduced ? "SUCCESS" : "NONE") 
                   << " (reduced search space)");
-      
-        for (Cell* c : board_->white_cells) {
-            uint16_t m = candidates[c];
-            if (popcount9(m) == 1) {
-                for (int d = 1; d <= 9; d++) {
-                    if (m & (1 << d)) {
-                        c->value = d;
-                        break;
-                    }
-                }
-            }
-        }
     
         // FIX: Count determined cells AFTER logical reduction succeeds
         determined_cells = 0;
-        for (auto& [cell, mask] : candidates) {
+        for (Cell* cell : board_->white_cells) {
+            uint16_t mask = candidates[cell];
             if (popcount9(mask) == 1) {
                 determined_cells++;
             }
@@ -309,19 +382,18 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
     }
     
     
+    // The search expects values set on exactly the single-candidate cells
+    for (Cell* c : board_->white_cells) {
+        uint16_t m = candidates[c];
+        c->value = popcount9(m) == 1 ? std::optional<int>(lowest_bit_index(m)) : std::nullopt;
+    }
+
     LOG_DEBUG("    Cells logically determined: " << determined_cells 
               << "/" << board_->white_cells.size());
 
 
 #if KAKURO_ENABLE_LOGGING
     if (board_->logger && board_->logger->is_enabled()) {
-        std::unordered_map<Cell *, int> viz_map;
-        for (auto &[c, m] : candidates) {
-            if (popcount9(m) == 1) {
-                auto vals = mask_to_values(m);
-                if (!vals.empty()) viz_map[c] = vals[0];
-            }
-        }
         std::string log_msg = "Logical reduction complete: " + std::to_string(determined_cells) + " cells determined";
         if (total_candidates_start > 0) {
              int removed = total_candidates_start - total_candidates_end;
@@ -332,20 +404,22 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
             GenerationLogger::STAGE_UNIQUENESS,
             GenerationLogger::SUBSTAGE_LOGIC_STEP,
             log_msg,
-            board_->get_grid_state(&viz_map));
+            *board_, &candidates);
     }
 #endif
     
     // 6. Hybrid search
-    std::vector<std::unordered_map<std::pair<int, int>, int, PairHash>> found;
-    int node_count = 0;
-    bool timed_out = false;
+    SearchState state;
     
     {
         PROFILE_SCOPE("Uniqueness_HybridSearch", board_->logger);
-        hybrid_search(found, original_sol_coords, candidates, 
-                     node_count, max_nodes, seed_offset, timed_out);
+        run_search(state, original_sol_coords, candidates, max_nodes, seed_offset);
     }
+    const auto& found = state.found_solutions;
+    int node_count = state.node_count.load();
+    last_node_count_ = node_count;
+    bool timed_out = state.timed_out.load();
+    bool cancelled = state.cancelled.load();
     
     // 7. Restore original solution
     {
@@ -361,7 +435,7 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
     LOG_DEBUG("    Hybrid search explored " << node_count << " nodes");
 
 #if KAKURO_ENABLE_LOGGING
-    if (board_->logger && board_->logger->is_enabled()) {
+    if (board_->logger && board_->logger->wants_step("hybrid_result")) {
         std::string search_status = "Hybrid search finished: " + std::to_string(node_count) + " nodes.";
         
         // Prepare visualization map for alternative solution
@@ -375,8 +449,7 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
                 GenerationLogger::STAGE_UNIQUENESS,
                 "hybrid_result",
                 search_status,
-                board_->get_grid_state()
-            );
+                *board_);
 
         } else if (!found.empty()) {
             search_status += " Found alternative solution.";
@@ -415,8 +488,7 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
                 GenerationLogger::STAGE_UNIQUENESS,
                 "hybrid_result",
                 search_status,
-                board_->get_grid_state()
-            );
+                *board_);
         }
         
         
@@ -426,6 +498,9 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
     if (!found.empty()) {
         return {UniquenessResult::MULTIPLE, found[0]};
     }
+    if (cancelled) {
+        return {UniquenessResult::INCONCLUSIVE, std::nullopt};
+    }
     if (timed_out) {
         LOG_INFO("Hybrid search timed out (" << node_count << " nodes). Assuming UNIQUE.");
     }
@@ -435,42 +510,37 @@ HybridUniquenessChecker::check_uniqueness_hybrid(int max_nodes, int seed_offset)
 // Helper to check if a partition can be assigned to a sector
 // with cell at cell_idx assigned to val
 bool HybridUniquenessChecker::can_assign_partition_to_sector(
-    const std::vector<int>& partition,
-    const std::vector<Cell*>& sector,
+    uint16_t partition,
+    SectorSpan sector,
     const CandidateMap& candidates,
     int fixed_cell_idx,
     int fixed_val) {
     
-    int n = sector.size();
-    std::vector<int> partition_copy = partition;
-    
     // Remove fixed_val from partition
-    auto it = std::find(partition_copy.begin(), partition_copy.end(), fixed_val);
-    if (it == partition_copy.end()) return false; // fixed_val not in partition
-    partition_copy.erase(it);
+    if (!(partition & (1 << fixed_val))) return false; // fixed_val not in partition
+    uint16_t remaining = partition & ~(1 << fixed_val);
     
     // Use bitmask for used cells (sector size <= 9)
     // fixed_cell_idx is already 'used'
     int used_mask = (1 << fixed_cell_idx);
     
-    return can_match_values_to_cells(partition_copy, sector, candidates, used_mask);
+    return can_match_values_to_cells(remaining, sector, candidates, used_mask);
 }
 
 bool HybridUniquenessChecker::can_match_values_to_cells(
-    const std::vector<int>& values,
-    const std::vector<Cell*>& sector,
+    uint16_t values,
+    SectorSpan sector,
     const CandidateMap& candidates,
     int used_mask) {
     
-    if (values.empty()) return true; // All values assigned
+    if (values == 0) return true; // All values assigned
     
-    int val = values[0];
+    // Place the lowest remaining digit first
+    int val = 1;
+    while (!(values & (1 << val))) val++;
+    uint16_t remaining_values = values & ~(1 << val);
     
-    // We pass slice of values by index/pointer to avoid copying vector every time? 
-    // Actually, vector copy for size < 9 is very fast (simd). Keeping it simple.
-    std::vector<int> remaining_values(values.begin() + 1, values.end());
-    
-    for (int i = 0; i < sector.size(); i++) {
+    for (int i = 0; i < (int)sector.size(); i++) {
         if (used_mask & (1 << i)) continue; // Skip used cells
         
         Cell* cell = sector[i];
@@ -496,319 +566,213 @@ bool HybridUniquenessChecker::can_match_values_to_cells(
 
 
 
-HybridUniquenessChecker::ReductionResult HybridUniquenessChecker::apply_logical_reduction(
-    CandidateMap& candidates,
-    const std::unordered_map<std::pair<int, int>, int, PairHash>& avoid_sol) {
-    
-    // Backup Cell values in case we need to revert due to contradiction
-    std::vector<std::pair<Cell*, std::optional<int>>> local_val_backup;
-    for(auto c : board_->white_cells) local_val_backup.push_back({c, c->value});
+namespace {
 
-    // Partition Cache
-    static std::map<std::pair<int, int>, std::vector<std::vector<int>>> partition_cache;
+int min_digit(uint16_t mask) { return lowest_bit_index(mask); }
 
-    // Mutex removed to avoid dependency issues in single-threaded env
-    
-    auto get_partitions = [&](int sum, int len) -> const std::vector<std::vector<int>>& {
-        static std::vector<std::vector<int>> empty; 
-        if(len > 9 || len < 1) return empty;
-        
-        if (partition_cache.count({sum, len})) return partition_cache[{sum, len}];
-        
-        std::vector<std::vector<int>> res;
-        std::vector<int> cur;
-        std::function<void(int, int, int)> bt = [&](int t, int k, int s) {
-            if (k == 0) {
-                if (t == 0) res.push_back(cur);
-                return;
-            }
-            for (int i = s; i <= 9; ++i) {
-                if (i > t) break;
-                cur.push_back(i);
-                bt(t - i, k - 1, i + 1);
-                cur.pop_back();
-            }
-        };
-        bt(sum, len, 1);
-        partition_cache[{sum, len}] = res;
-        return partition_cache[{sum, len}];
-    };
-    
-    // ... apply_partition_pruning defined below ...
-    // (We need to jump to the loop to insert the call)
+} // namespace
 
+void HybridUniquenessChecker::init_propagation() {
+    int h_capacity = board_->sectors_h.capacity();
+    int total = h_capacity + board_->sectors_v.capacity();
+    sector_queue_.clear();
+    queue_head_ = 0;
+    sector_queued_.assign(total, 0);
+    trail_.clear();
+    sector_clue_.assign(total, 0);
+    for (int id = 0; id < total; id++) {
+        bool is_horz = id < h_capacity;
+        Cell* clue = is_horz ? board_->sectors_h.clue_cell(id)
+                             : board_->sectors_v.clue_cell(id - h_capacity);
+        if (!clue) continue;
+        std::optional<int> value = is_horz ? clue->clue_h : clue->clue_v;
+        sector_clue_[id] = value.value_or(0);
+    }
+}
 
+SectorSpan HybridUniquenessChecker::sector_by_id(int id) const {
+    int h_capacity = board_->sectors_h.capacity();
+    return id < h_capacity ? board_->sectors_h[id]
+                           : board_->sectors_v[id - h_capacity];
+}
 
-    auto apply_partition_pruning = [&](const std::vector<std::shared_ptr<std::vector<Cell*>>>& sectors, bool is_horz, const CandidateMap& reference_candidates) -> ReductionResult {
-        bool local_change = false;
-        for (const auto& sector : sectors) {
-            if (sector->empty()) continue;
-            
-            // Get Clue
-            Cell* first = (*sector)[0];
-            std::optional<int> clue_opt;
-            if (is_horz && first->c > 0) clue_opt = board_->grid[first->r][first->c - 1].clue_h;
-            else if (!is_horz && first->r > 0) clue_opt = board_->grid[first->r - 1][first->c].clue_v;
-            
-            if (!clue_opt) continue;
-            int target = *clue_opt;
-            int len = sector->size();
-            
-            // FIX: Use SOUND partition generation (theoretical), not union-based
-            const auto& valid_partitions = get_partitions(target, len);
-            
-            if (valid_partitions.empty()) {
-                for(Cell* c : *sector) candidates[c] = 0;
-                return ReductionResult::CONTRADICTION; 
-            }
-            
-            for (int cell_idx = 0; cell_idx < len; cell_idx++) {
-                Cell* c = (*sector)[cell_idx];
-                // FIX: Read old_mask from REFERENCE (snapshot) candidates, not mutating candidates
-                // This ensures we use consistent state when checking partition assignments
-                uint16_t old_mask = reference_candidates.at(c);
-                uint16_t new_mask = 0;
-                
-                // For each candidate value of this cell
-                for (int val = 1; val <= 9; val++) {
-                    if (!(old_mask & (1 << val))) continue;
-                    
-                    // Check if there exists a valid partition where this cell can be 'val'
-                    bool found_valid_assignment = false;
-                    
-                    for (const auto& partition : valid_partitions) {
-                        // Does this partition contain val?
-                        bool has_val = false;
-                        for (int pv : partition) {
-                            if (pv == val) {
-                                has_val = true;
-                                break;
-                            }
-                        }
-                        if (!has_val) continue;
-                        
-                        // FIX: Use reference_candidates (snapshot) for checking, not mutating candidates
-                        // This prevents cascading incorrect eliminations
-                        if (can_assign_partition_to_sector(partition, *sector, reference_candidates, cell_idx, val)) {
-                            found_valid_assignment = true;
-                            break;
-                        }
-                    }
-                    
-                    if (found_valid_assignment) {
-                        new_mask |= (1 << val);
-                    }
-                }
-                
-                if (new_mask != old_mask) {
-                    // Soundness check: Did we just eliminate the correct value?
-                    if (avoid_sol.count({c->r, c->c})) {
-                        int correct_val = avoid_sol.at({c->r, c->c});
-                        if ((old_mask & (1 << correct_val)) && !(new_mask & (1 << correct_val))) {
-                            LOG_ERROR("[SOUNDNESS BUG] Partition pruning eliminated correct value " << correct_val << " for cell (" << c->r << "," << c->c << ")!");
-                            LOG_ERROR("  Sector: " << (is_horz ? "H" : "V") << " Target: " << target << " Len: " << len);
-                        }
-                    }
+void HybridUniquenessChecker::enqueue_sectors(const Cell* cell) {
+    for (int id : {cell->sector_h,
+                   cell->sector_v < 0 ? -1 : board_->sectors_h.capacity() + cell->sector_v}) {
+        if (id >= 0 && !sector_queued_[id]) {
+            sector_queued_[id] = 1;
+            sector_queue_.push_back(id);
+        }
+    }
+}
 
-                    candidates[c] = new_mask;
-                    local_change = true;
-                    if (new_mask == 0) {
-                        // DEBUG: Log detailed contradiction info
-                        LOG_ERROR("CONTRADICTION in partition pruning: Cell (" << c->r << "," << c->c << ") has no valid candidates for any partition");
-                        LOG_ERROR("  Target sum: " << target << ", Sector length: " << len);
-                        LOG_ERROR("  Old mask (before pruning): " << old_mask);
-                        LOG_ERROR("  Valid partitions for this sector:");
-                        for (const auto& p : valid_partitions) {
-                            std::string pstr = "{";
-                            for (size_t pidx = 0; pidx < p.size(); pidx++) {
-                                if (pidx > 0) pstr += ",";
-                                pstr += std::to_string(p[pidx]);
-                            }
-                            pstr += "}";
-                            LOG_ERROR("    " << pstr);
-                        }
-                        LOG_ERROR("  Reference candidates for other cells in sector:");
-                        for (int idx = 0; idx < len; idx++) {
-                            Cell* sc = (*sector)[idx];
-                            LOG_ERROR("    Cell (" << sc->r << "," << sc->c << "): mask=" << reference_candidates.at(sc));
-                        }
-#if KAKURO_ENABLE_LOGGING
-                        if (board_->logger && board_->logger->is_enabled()) {
-                            board_->logger->log_step(
-                                GenerationLogger::STAGE_UNIQUENESS,
-                                "contradiction_debug",
-                                "Partition pruning contradiction: Cell (" + std::to_string(c->r) + "," + std::to_string(c->c) + ") has no valid values for target=" + std::to_string(target) + " len=" + std::to_string(len),
-                                board_->get_grid_state());
-                        }
-#endif
-                        return ReductionResult::CONTRADICTION; // Contradiction
-                    }
-                }
-            }
+bool HybridUniquenessChecker::narrow(Cell* cell, uint16_t mask, CandidateMap& candidates) {
+    uint16_t old_mask = candidates[cell];
+    if (mask == old_mask) return true;
+    trail_.push_back({cell->idx, old_mask});
+    candidates[cell] = mask;
+    if (mask == 0) return false;
+    if (popcount9(mask) == 1) cell->value = min_digit(mask);
+    enqueue_sectors(cell);
+    return true;
+}
+
+void HybridUniquenessChecker::undo_to(size_t mark, CandidateMap& candidates) {
+    while (trail_.size() > mark) {
+        const TrailEntry& entry = trail_.back();
+        Cell* cell = board_->white_cells[entry.idx];
+        candidates[cell] = entry.mask;
+        if (popcount9(entry.mask) == 1) cell->value = min_digit(entry.mask);
+        else cell->value = std::nullopt;
+        trail_.pop_back();
+    }
+}
+
+bool HybridUniquenessChecker::propagate(CandidateMap& candidates, int partition_open_cells) {
+    while (queue_head_ < sector_queue_.size()) {
+        int id = sector_queue_[queue_head_++];
+        sector_queued_[id] = 0;
+        if (!revise_sector(id, candidates, partition_open_cells)) {
+            for (size_t i = queue_head_; i < sector_queue_.size(); i++)
+                sector_queued_[sector_queue_[i]] = 0;
+            sector_queue_.clear();
+            queue_head_ = 0;
+            return false;
         }
+    }
+    sector_queue_.clear();
+    queue_head_ = 0;
+    return true;
+}
 
-        return local_change ? ReductionResult::CHANGED : ReductionResult::NO_CHANGE; 
+bool HybridUniquenessChecker::revise_sector(int id, CandidateMap& candidates, int partition_open_cells) {
+    SectorSpan sector = sector_by_id(id);
+    int len = sector.size();
+    if (len > PARTITION_MAX_LEN) return false; // No partition has this many digits
+
+    // Steps 1 and 2 narrow the gathered masks, then write them back in cell
+    // order
+    const SectorKernel& kernel = sector_kernel();
+    SectorMasks masks;
+    masks.size = len;
+    for (int i = 0; i < len; i++) masks.mask[i] = candidates[sector[i]];
+    auto store = [&]() {
+        for (int i = 0; i < len; i++) {
+            if (!narrow(sector[i], masks.mask[i], candidates)) return false;
+        }
+        return true;
     };
 
+    // 1. Determined digits appear once and nowhere else in the sector
+    SectorSummary summary = kernel.summarize(masks);
+    if (popcount9(summary.singles) != summary.single_count) return false;
+    kernel.remove_from_open(masks, summary.singles);
+    if (!store()) return false;
 
-    bool any_change = false;
-    int iterations = 0;
-    const int MAX_QUICK_ITERATIONS = 10; // Increased slightly
-    
-    while (iterations++ < MAX_QUICK_ITERATIONS) {
-        bool changed = false;
-        
-        // FIX: Take a snapshot of candidates at the start of each iteration
-        // This prevents cascading incorrect eliminations in partition pruning
-        CandidateMap candidates_snapshot = candidates;
-
-        // 1. Naked singles propagation - FIXED VERSION
-        // Use a queue to process newly-determined cells
-        std::queue<Cell*> to_process;
-        std::unordered_set<Cell*> processed;
-        
-        // Find all currently determined cells
-        for (Cell* cell : board_->white_cells) {
-            uint16_t mask = candidates[cell];
-            if (popcount9(mask) == 1) {
-                to_process.push(cell);
-            }
-        }
-        
-        // Process each determined cell and propagate
-        while (!to_process.empty()) {
-            Cell* cell = to_process.front();
-            to_process.pop();
-            
-            if (processed.count(cell)) continue;
-            processed.insert(cell);
-            
-            uint16_t mask = candidates[cell];
-            if (popcount9(mask) != 1) continue; // Cell is no longer determined
+    int target = sector_clue_[id];
+    if (target == 0) return true;
 
-            for(int d=1; d<=9; d++) {
-                if(mask & (1<<d)) { cell->value = d; break; }
-            }
-            
-            auto propagate_to_neighbors = [&](const std::shared_ptr<std::vector<Cell*>>& sec, const char* sec_name) {
-                if (!sec) return true;
-                for (Cell* neighbor : *sec) {
-                    if (neighbor != cell && (candidates[neighbor] & mask)) {
-                        uint16_t old_mask = candidates[neighbor];
-                        candidates[neighbor] &= ~mask;
-                        changed = true;
-                        
-                        if (candidates[neighbor] == 0) {
-                            // DEBUG: Log contradiction source
-                            LOG_ERROR("CONTRADICTION in naked singles propagation: Cell (" << neighbor->r << "," << neighbor->c << ") became empty after removing value from cell (" << cell->r << "," << cell->c << ") via " << sec_name << " sector");
-#if KAKURO_ENABLE_LOGGING
-                            if (board_->logger && board_->logger->is_enabled()) {
-                                board_->logger->log_step(
-                                    GenerationLogger::STAGE_UNIQUENESS,
-                                    "contradiction_debug",
-                                    "Naked singles contradiction: Cell (" + std::to_string(neighbor->r) + "," + std::to_string(neighbor->c) + ") candidates=0 after removing value from (" + std::to_string(cell->r) + "," + std::to_string(cell->c) + ")",
-                                    board_->get_grid_state());
-                            }
-#endif
-                            return false; // Contradiction
-                        }
-                        
-                        if (popcount9(old_mask) > 1 && popcount9(candidates[neighbor]) == 1) {
-                            to_process.push(neighbor);
-                        }
-                    }
-                }
-                return true;
-            };
+    // 2. Each cell's digit must leave a reachable sum for the others
+    summary = kernel.summarize(masks);
+    if (summary.min_sum > target || summary.max_sum < target) return false;
+    kernel.bound_to_sum(masks, target, summary);
+    if (!store()) return false;
 
-            if (!propagate_to_neighbors(cell->sector_h, "horizontal")) goto contradiction;
-            if (!propagate_to_neighbors(cell->sector_v, "vertical")) goto contradiction;
-        
+    int open_cells = 0;
+    for (int i = 0; i < len; i++) open_cells += popcount9(masks.mask[i]) > 1;
+    if (open_cells > partition_open_cells) return true;
+
+    // 3. Each digit must fit a partition of the clue matched to the cells.
+    // The matching is exponential in the open cells, so the search only
+    // runs it on nearly-filled sectors
+    const PartitionRange valid_partitions = partitions_of(target, len);
+    if (valid_partitions.empty()) return false;
+
+    for (int cell_idx = 0; cell_idx < len; cell_idx++) {
+        Cell* c = sector[cell_idx];
+        uint16_t old_mask = candidates[c];
+        uint16_t new_mask = 0;
+
+        // Any matching partition must contain the values already placed
+        // in the other cells, so only those partitions are worth trying
+        uint16_t fixed_others = 0;
+        for (int idx = 0; idx < len; idx++) {
+            Cell* sc = sector[idx];
+            if (idx != cell_idx && sc->value.has_value()) fixed_others |= (1 << *sc->value);
         }
-        
-        // 2. Hidden singles (one pass)
-        auto check_hidden_singles_once = [&]() {
-            bool found = false;
-            auto process_sectors = [&](const std::vector<std::shared_ptr<std::vector<Cell*>>>& sectors) {
-                    for (const auto& sector : sectors) {
-                        if (sector->empty()) continue;
-                        std::array<int, 10> digit_count = {0};
-                        std::array<Cell*, 10> digit_cell = {nullptr};
-                        for (Cell* cell : *sector) {
-                            uint16_t mask = candidates[cell];
-                            for (int d = 1; d <= 9; d++) {
-                                if (mask & (1 << d)) {
-                                    digit_count[d]++;
-                                    digit_cell[d] = cell;
-                                }
-                            }
-                        }
-                        for (int d = 1; d <= 9; d++) {
-                            if (digit_count[d] == 1 && digit_cell[d]) {
-                                Cell* cell = digit_cell[d];
-                                if (popcount9(candidates[cell]) > 1) {
-                                    candidates[cell] = (1 << d);
-                                    found = true;
-                                    changed = true; // Mark global change
-                                    // Sync value
-                                    cell->value = d;
-                                }
-                            }
-                        }
-                    }
-                };
-                process_sectors(board_->sectors_h);
-                process_sectors(board_->sectors_v);
-                return found;
-            };
-            
-            /* 
-            // HIDDEN SINGLES - DISABLED
-            // This heuristic is incorrect for Kakuro because a sector doesn't contain all digits.
-            // Just because a digit D fits in only one cell doesn't mean D must be used!
-            if (check_hidden_singles_once()) {
-                changed = true;
-            }
-            */
-
-            // 3. Partition Pruning (Moved to end of loop as requested)
-            // Check returned false if contradiction occurred inside
-            // 3. Partition Pruning (Moved to end of loop as requested)
-            // Check returned false if contradiction occurred inside
-            // 3. Partition Pruning (Restored)
-            ReductionResult h_res = apply_partition_pruning(board_->sectors_h, true, candidates_snapshot);
-            if (h_res == ReductionResult::CONTRADICTION) goto contradiction;
-            if (h_res == ReductionResult::CHANGED) changed = true;
-            else {
-                // Check for actual contradiction (empty mask)
-                 for(auto c : board_->white_cells) if(candidates[c] == 0) goto contradiction;
-            }
+        uint16_t reachable = partition_allowed(target, len, fixed_others);
 
-            ReductionResult v_res = apply_partition_pruning(board_->sectors_v, false, candidates_snapshot);
-            if (v_res == ReductionResult::CONTRADICTION) goto contradiction;
-            if (v_res == ReductionResult::CHANGED) changed = true;
-            else {
-                for(auto c : board_->white_cells) if(candidates[c] == 0) goto contradiction;
+        for (int val = 1; val <= 9; val++) {
+            if (!(old_mask & (1 << val))) continue;
+            if (!(reachable & (1 << val))) continue;
+
+            uint16_t required = fixed_others | (1 << val);
+            for (uint16_t partition : valid_partitions) {
+                if ((partition & required) != required) continue;
+                if (can_assign_partition_to_sector(partition, sector, candidates, cell_idx, val)) {
+                    new_mask |= (1 << val);
+                    break;
+                }
             }
+        }
 
-            if (!changed) break; 
+        if (new_mask != old_mask && !narrow(c, new_mask, candidates)) return false;
+    }
+    return true;
+}
 
-            // Soundness check after each iteration
-            for (Cell* c : board_->white_cells) {
-                if (avoid_sol.count({c->r, c->c})) {
-                    int correct_val = avoid_sol.at({c->r, c->c});
-                    if (!(candidates[c] & (1 << correct_val))) {
-                        LOG_ERROR("[SOUNDNESS BUG] Logical reduction incorrectly eliminated correct value " << correct_val << " for cell (" << c->r << "," << c->c << ")!");
-                    }
-                    if (c->value.has_value() && *c->value != correct_val) {
-                        LOG_ERROR("[SOUNDNESS BUG] Logical reduction incorrectly assigned value " << *c->value << " to cell (" << c->r << "," << c->c << "). Should be " << correct_val << "!");
-                    }
+HybridUniquenessChecker::ReductionResult HybridUniquenessChecker::apply_logical_reduction(
+    CandidateMap& candidates,
+    const std::unordered_map<std::pair<int, int>, int, PairHash>& avoid_sol) {
+    
+    // Backup Cell values in case we need to revert due to contradiction
+    std::vector<std::pair<Cell*, std::optional<int>>> local_val_backup;
+    for(auto c : board_->white_cells) local_val_backup.push_back({c, c->value});
+
+    // Everything is new at the root: settle singles from the initial
+    // filtering and visit every sector once. Later visits only happen for
+    // sectors whose cells narrowed.
+    for (Cell* c : board_->white_cells) {
+        uint16_t mask = candidates[c];
+        if (mask == 0) goto contradiction;
+        if (popcount9(mask) == 1) c->value = min_digit(mask);
+    }
+    for (int id = 0; id < (int)sector_queued_.size(); id++) {
+        if (sector_by_id(id).empty()) continue;
+        sector_queued_[id] = 1;
+        sector_queue_.push_back(id);
+    }
+
+    {
+        size_t mark = trail_.size();
+        bool consistent = propagate(candidates, 9);
+        bool any_change = trail_.size() > mark;
+        trail_.resize(mark); // Root reductions are never undone
+        if (!consistent) {
+            LOG_ERROR("CONTRADICTION in logical reduction: a cell has no candidates left");
+#if KAKURO_ENABLE_LOGGING
+            if (board_->logger && board_->logger->is_enabled()) {
+                board_->logger->log_step(
+                    GenerationLogger::STAGE_UNIQUENESS,
+                    "contradiction_debug",
+                    "Logical reduction contradiction: a cell has no valid values",
+                    *board_);
+            }
+#endif
+            goto contradiction;
+        }
+
+        // Soundness check against the known solution
+        for (Cell* c : board_->white_cells) {
+            if (avoid_sol.count({c->r, c->c})) {
+                int correct_val = avoid_sol.at({c->r, c->c});
+                if (!(candidates[c] & (1 << correct_val))) {
+                    LOG_ERROR("[SOUNDNESS BUG] Logical reduction incorrectly eliminated correct value " << correct_val << " for cell (" << c->r << "," << c->c << ")!");
                 }
             }
-            any_change = true;
         }
-        
         return any_change ? ReductionResult::CHANGED : ReductionResult::NO_CHANGE;
+    }
 
 contradiction:
     // Restore logic state values on contradiction
@@ -816,69 +780,171 @@ contradiction:
     return ReductionResult::CONTRADICTION;
 }
 
+void HybridUniquenessChecker::run_search(
+    SearchState& state,
+    const SolutionMap& avoid_sol,
+    CandidateMap& candidates,
+    int max_nodes,
+    int seed) {
+    if (num_threads_ > 1)
+        parallel_search(state, avoid_sol, candidates, max_nodes, seed);
+    else
+        hybrid_search(state, avoid_sol, candidates, max_nodes, seed);
+}
+
+bool HybridUniquenessChecker::solve_clues(int limit, int max_nodes,
+                                          std::vector<SolutionMap>& solutions) {
+    PROFILE_FUNCTION(board_->logger);
+    solutions.clear();
+    last_node_count_ = 0;
+    int n = (int)board_->white_cells.size();
+    if (n > CandidateMap::MAX_CELLS) {
+        LOG_ERROR("Board has too many white cells to solve: " << n);
+        return false;
+    }
+
+    std::vector<std::optional<int>> saved_values;
+    saved_values.reserve(n);
+    for (Cell* c : board_->white_cells) {
+        saved_values.push_back(c->value);
+        c->value = std::nullopt;
+    }
+
+    // Only digits of some partition of the clue; runs whose clue no
+    // partition reaches are contradictions from the start
+    CandidateMap candidates(n, ALL_CANDIDATES);
+    for (int pass = 0; pass < 2; pass++) {
+        const SectorTable& sectors = pass ? board_->sectors_v : board_->sectors_h;
+        for (SectorSpan sector : sectors) {
+            Cell* first = sector[0];
+            std::optional<int> clue =
+                pass ? (first->r > 0 ? board_->grid[first->r - 1][first->c].clue_v : std::nullopt)
+                     : (first->c > 0 ? board_->grid[first->r][first->c - 1].clue_h : std::nullopt);
+            if (!clue) continue;
+            uint16_t digits = partition_union(*clue, (int)sector.size());
+            for (Cell* c : sector) candidates[c] &= digits;
+        }
+    }
+
+    // Root reduction as in apply_logical_reduction, without the reporting:
+    // a contradiction here just means the clues have no solution
+    SearchState state;
+    state.solution_limit = (size_t)std::max(1, limit);
+    init_propagation();
+    bool consistent = true;
+    for (Cell* c : board_->white_cells) {
+        uint16_t mask = candidates[c];
+        if (mask == 0) consistent = false;
+        else if (popcount9(mask) == 1) c->value = min_digit(mask);
+    }
+    if (consistent) {
+        for (int id = 0; id < (int)sector_queued_.size(); id++) {
+            if (sector_by_id(id).empty()) continue;
+            sector_queued_[id] = 1;
+            sector_queue_.push_back(id);
+        }
+        consistent = propagate(candidates, 9);
+        trail_.clear();
+    }
+    if (consistent) {
+        for (Cell* c : board_->white_cells) {
+            uint16_t m = candidates[c];
+            c->value = popcount9(m) == 1 ? std::optional<int>(lowest_bit_index(m)) : std::nullopt;
+        }
+        PROFILE_SCOPE("Uniqueness_HybridSearch", board_->logger);
+        run_search(state, SolutionMap(), candidates, max_nodes, 0);
+        last_node_count_ = state.node_count.load();
+    }
+
+    for (int i = 0; i < n; i++) board_->white_cells[i]->value = saved_values[i];
+    solutions = std::move(state.found_solutions);
+    return !state.timed_out.load() && !state.cancelled.load();
+}
+
+void HybridUniquenessChecker::parallel_search(
+    SearchState& state,
+    const SolutionMap& avoid_sol,
+    const CandidateMap& candidates,
+    int max_nodes,
+    int seed) {
+    WorkPool pool(num_threads_);
+    state.pool = &pool;
+    pool.push(0, SearchTask{candidates, true});
+
+    // Clones are made up front: the search mutates Cell::value on board_
+    std::vector<std::shared_ptr<KakuroBoard>> boards;
+    for (int i = 0; i < num_threads_; i++) boards.push_back(board_->clone());
+
+    auto worker = [&](int id) {
+        HybridUniquenessChecker local(boards[id]);
+        local.worker_id_ = id;
+        local.init_propagation();
+        local.budget_ = budget_;
+        SearchTask task;
+        while (pool.next(id, task, state.stop)) {
+            // Tasks are fully described by their masks
+            for (Cell* c : boards[id]->white_cells) {
+                uint16_t mask = task.candidates[c];
+                if (popcount9(mask) == 1) c->value = lowest_bit_index(mask);
+                else c->value = std::nullopt;
+            }
+            local.hybrid_search(state, avoid_sol, task.candidates,
+                                max_nodes, seed, task.on_avoid_path);
+            // Idle workers sleep until notified, so wake them to see a stop
+            if (state.stop.load()) pool.cancel();
+            pool.finish();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_threads_; i++) threads.emplace_back(worker, i);
+    worker(0);
+    pool.cancel();
+    for (auto& t : threads) t.join();
+    state.pool = nullptr;
+}
+
 void HybridUniquenessChecker::hybrid_search(
-    std::vector<std::unordered_map<std::pair<int, int>, int, PairHash>>& found_solutions,
-    const std::unordered_map<std::pair<int, int>, int, PairHash>& avoid_sol,
+    SearchState& state,
+    const SolutionMap& avoid_sol,
     CandidateMap& candidates,
-    int& node_count,
     int max_nodes,
     int seed,
-    bool& timed_out,
     bool is_on_avoid_path) {
     
-    if (!found_solutions.empty()) return;
-    if (node_count > max_nodes) {
-        timed_out = true;
+    if (state.stop.load(std::memory_order_relaxed)) return;
+    if (budget_ && budget_->is_cancelled()) {
+        state.cancelled = true;
+        state.stop = true;
+        return;
+    }
+    if (state.node_count.load(std::memory_order_relaxed) > max_nodes) {
+        state.timed_out = true;
+        state.stop = true;
+        return;
+    }
+    [[maybe_unused]] int node_count = ++state.node_count;
+    // Unlike the node cap, running out of time proves nothing either way
+    if (node_count % 1000 == 0 && budget_ && budget_->expired()) {
+        state.cancelled = true;
+        state.stop = true;
         return;
     }
-    node_count++;
 
 #if KAKURO_ENABLE_LOGGING
     if (node_count % 1000 == 0 && board_->logger && board_->logger->is_enabled()) {
-        std::unordered_map<Cell *, int> viz_map;
         int determined = 0;
-        for (auto &[c, m] : candidates) {
-            if (popcount9(m) == 1) {
-                determined++;
-                int val = 0;
-                for(int d=1; d<=9; d++) { if(m & (1<<d)) { val=d; break; } }
-                if(val) viz_map[c] = val;
-            }
+        for (Cell* c : board_->white_cells) {
+            if (popcount9(candidates[c]) == 1) determined++;
         }
         board_->logger->log_step(
             GenerationLogger::STAGE_UNIQUENESS,
             "search_step",
             "Hybrid search: " + std::to_string(node_count) + " nodes, " + std::to_string(determined) + " cells determined",
-            board_->get_grid_state(&viz_map));
+            *board_, &candidates);
     }
 #endif
     
-    // RAII helper to restore values of determined cells upon return
-    // This prevents "leakage" of temporary values to sibling search branches (Soundness fix)
-    struct DeterminedValueRestorer {
-        std::vector<Cell*> cells;
-        ~DeterminedValueRestorer() {
-             for (Cell* c : cells) c->value = std::nullopt;
-        }
-    };
-    DeterminedValueRestorer determined_updates;
-
-    // **FIX 1: First, assign all logically determined values to cell->value**
-    // This ensures constraint checking sees them
-    for (Cell* c : board_->white_cells) {
-        uint16_t mask = candidates[c];
-        if (popcount9(mask) == 1 && !c->value.has_value()) {
-            // Extract the single value
-            for (int d = 1; d <= 9; d++) {
-                if (mask & (1 << d)) {
-                    c->value = d;
-                    determined_updates.cells.push_back(c);
-                    break;
-                }
-            }
-        }
-    }
-
     // Find first cell that needs assignment (has multiple candidates)
     Cell* var = nullptr;
     int min_candidates = 10;
@@ -893,29 +959,16 @@ void HybridUniquenessChecker::hybrid_search(
     
     // All cells are determined (have exactly 1 candidate) - we have a complete solution
     if (!var) {
-        // Build the solution from candidate masks (NOT cell->value)
-        std::unordered_map<std::pair<int, int>, int, PairHash> sol;
-        bool is_different = false;
-        
-        // Populate solution map
-        for (Cell* c : board_->white_cells) {
-             if (!c->value.has_value()) {
-                 // Fallback to extraction from mask if value not set (shouldn't happen with FIX 1 logic, but safer)
-                uint16_t mask = candidates[c];
-                int val = 0;
-                for(int d=1; d<=9; d++) if(mask & (1<<d)) { val=d; break; }
-                if (val == 0) return; // Should not happen
-                sol[{c->r, c->c}] = val;
-             } else {
-                 sol[{c->r, c->c}] = *c->value;
-             }
-        }
+        // Read the digits from the candidate masks (NOT cell->value, which
+        // propagation keeps set only as a mirror of the singles)
+        auto digit_of = [&](Cell* c) {
+            return c->value ? *c->value : min_digit(candidates[c]);
+        };
 
-        auto validate_sectors = [&](const std::vector<std::shared_ptr<std::vector<Cell*>>>& sectors, bool is_horz) -> bool {
-            for (const auto& sector : sectors) {
-                if (sector->empty()) continue;
+        auto validate_sectors = [&](const SectorTable& sectors, bool is_horz) -> bool {
+            for (SectorSpan sector : sectors) {
                 
-                Cell* first = (*sector)[0];
+                Cell* first = sector[0];
                 std::optional<int> clue;
                 
                 if (is_horz) {
@@ -931,19 +984,17 @@ void HybridUniquenessChecker::hybrid_search(
                 if (!clue.has_value()) continue; // No clue to validate
                 
                 int sum = 0;
-                std::unordered_set<int> used;
+                uint16_t used = 0;
                 
-                for (Cell* c : *sector) {
-                    if (!sol.count({c->r, c->c})) {
-                        return false; // Incomplete sector
-                    }
-                    int val = sol.at({c->r, c->c});
+                for (Cell* c : sector) {
+                    int val = digit_of(c);
+                    if (val == 0) return false; // Should not happen
                     
                     // Check for duplicates
-                    if (used.count(val)) {
+                    if (used & (1 << val)) {
                         return false;
                     }
-                    used.insert(val);
+                    used |= 1 << val;
                     sum += val;
                 }
                 
@@ -964,18 +1015,28 @@ void HybridUniquenessChecker::hybrid_search(
         }
 
 
-        // Check difference from original solution
-        for (const auto& [coords, val] : sol) {
-            if (avoid_sol.count(coords) && val != avoid_sol.at(coords)) {
-                is_different = true;
-                break;
-            }
+        // Check difference from original solution; with none to avoid,
+        // every solution counts
+        bool is_different = avoid_sol.empty();
+        for (Cell* c : board_->white_cells) {
+            if (is_different) break;
+            auto it = avoid_sol.find({c->r, c->c});
+            is_different = it != avoid_sol.end() && digit_of(c) != it->second;
         }
         
         if (is_different) {
-            found_solutions.push_back(sol);
+            // Only an alternative is kept, so only it needs a map
+            SolutionMap sol;
+            for (Cell* c : board_->white_cells) sol[{c->r, c->c}] = digit_of(c);
+            {
+                std::lock_guard<std::mutex> lock(state.found_mutex);
+                // Other workers may have filled the limit already
+                if (state.found_solutions.size() >= state.solution_limit) return;
+                state.found_solutions.push_back(sol);
+                if (state.found_solutions.size() >= state.solution_limit) state.stop = true;
+            }
 #if KAKURO_ENABLE_LOGGING
-            if (board_->logger && board_->logger->is_enabled()) {
+            if (board_->logger && board_->logger->wants_step("alternative_found")) {
                 std::unordered_map<Cell*, int> alt_map;
                 std::unordered_map<Cell*, int> orig_map;
                 std::vector<std::pair<int, int>> highlights;
@@ -1015,10 +1076,11 @@ void HybridUniquenessChecker::hybrid_search(
     }
     
     // Try values from candidate set
-    std::vector<int> values = mask_to_values(candidates[var]);
+    DigitList values = mask_to_values(candidates[var]);
     
     // Deprioritize the value from the original solution
-    int avoid_val = avoid_sol.at({var->r, var->c});
+    auto avoid_it = avoid_sol.find({var->r, var->c});
+    int avoid_val = avoid_it != avoid_sol.end() ? avoid_it->second : 0;
     std::partition(values.begin(), values.end(), 
                    [avoid_val](int v) { return v != avoid_val; });
     
@@ -1026,229 +1088,34 @@ void HybridUniquenessChecker::hybrid_search(
         bool is_correct_val = (val == avoid_val);
         bool next_on_avoid_path = (is_on_avoid_path && is_correct_val);
 
-        // Save the original candidate mask for var
-        uint16_t var_orig_mask = candidates[var];
-        std::optional<int> var_orig_value = var->value;
-
-        candidates[var] = (1 << val);
-        var->value = val;
-        
-        std::vector<std::pair<Cell*, uint16_t>> saved_candidates;
-        std::vector<std::pair<Cell*, std::optional<int>>> saved_values;
-
-        saved_candidates.reserve(20);
-        saved_values.reserve(20);
-        
-        bool conflict = false;
+        // Assign and propagate; only sectors whose cells narrow are revisited
+        size_t mark = trail_.size();
+        bool conflict = !narrow(var, (uint16_t)(1 << val), candidates) ||
+                        !propagate(candidates, SEARCH_PARTITION_OPEN_CELLS);
+        if (conflict && next_on_avoid_path) {
+            // Every choice so far matches the original solution
+            LOG_ERROR("[SOUNDNESS BUG] Propagation refuted the original solution at (" << var->r << "," << var->c << ")=" << val);
+        }
 
-        // Propagate assignment (simple forward checking + sum reasoning)
-        auto propagate = [&](const std::shared_ptr<std::vector<Cell*>>& sec, bool is_horizontal) {
-            if (!sec) return true;
-            
-            Cell* first = (*sec)[0];
-            int target = 0;
-            if (is_horizontal) {
-                // Horizontal sector: clue is to the left
-                 if (first->c > 0 && board_->grid[first->r][first->c-1].clue_h)
-                    target = *board_->grid[first->r][first->c-1].clue_h;
+        if (!conflict) {
+            if (state.pool && state.pool->wants_work()) {
+                // Hand the subtree to an idle worker instead of descending
+                state.pool->push(worker_id_, SearchTask{candidates, next_on_avoid_path});
             } else {
-                // Vertical sector: clue is above
-                 if (first->r > 0 && board_->grid[first->r-1][first->c].clue_v)
-                    target = *board_->grid[first->r-1][first->c].clue_v;
-            }
-            if (target == 0) return true; // Should not happen for valid sectors
-
-            int current_sum = 0;
-            int unknown_count = 0;
-            int min_remaining = 0;
-            int max_remaining = 0;
-            Cell* last_unknown = nullptr;
-
-            for (Cell* n : *sec) {
-                if (n->value.has_value()) {
-                    // Check duplicate
-                    if (n != var && *n->value == val) {
-                        // Soundness check: Only if we are on the correct path and val is the correct one for var
-                        if (next_on_avoid_path) {
-                            if (avoid_sol.count({n->r, n->c}) && avoid_sol.at({n->r, n->c}) == *n->value) {
-                                LOG_ERROR("[SOUNDNESS BUG] Pruning duplicate value " << val << " in sector that should contain it according to avoid_sol!");
-                            }
-                        }
-                        return false;
-                    }
-                    current_sum += *n->value;
-                } else {
-                    unknown_count++;
-                    last_unknown = n;
-                    // Estimate bounds for remaining cells
-                    uint16_t mask = candidates[n];
-                    // If n == var, we shouldn't be here since var has value, but just in case
-                    if (n == var) { current_sum += val; continue; }
-                    
-                    // Simple update: remove 'val' from candidates of neighbors
-                    if (mask & (1 << val)) {
-                         uint16_t old_mask = mask;
-                         uint16_t new_mask = old_mask & ~(1 << val);
-                         if (new_mask == 0) {
-                             if (next_on_avoid_path && avoid_sol.count({n->r, n->c}) && avoid_sol.at({n->r, n->c}) == val) {
-                                 LOG_ERROR("[SOUNDNESS BUG] Domain empty for cell (" << n->r << "," << n->c << ") because " << val << " was removed, but it's the correct value!");
-                             }
-                             return false; 
-                         }
-                         
-                         // Temporarily update mask for bound calculation (commit to map)
-                         if (candidates[n] != new_mask) {
-                             saved_candidates.push_back({n, old_mask});
-                             candidates[n] = new_mask;
-                             mask = new_mask;
-                             
-                             // Soundness check
-                             if (next_on_avoid_path && avoid_sol.count({n->r, n->c})) {
-                                 int correct_val = avoid_sol.at({n->r, n->c});
-                                 if (!(new_mask & (1 << correct_val))) {
-                                     LOG_ERROR("[SOUNDNESS BUG] Removed correct value " << correct_val << " from cell (" << n->r << "," << n->c << ") candidates!");
-                                 }
-                             }
-                         }
-                    }
-                    
-                    // Add min/max candidates to bounds
-                    int local_min = 10, local_max = 0;
-                    for(int d=1; d<=9; d++) {
-                        if (mask & (1<<d)) {
-                            if (d < local_min) local_min = d;
-                            if (d > local_max) local_max = d;
-                        }
-                    }
-                    min_remaining += local_min;
-                    max_remaining += local_max;
-                }
-            }
-
-            // CRITICAL FIX: If only one cell remains unknown, force exact value
-            if (unknown_count == 1 && last_unknown != nullptr && last_unknown != var) {
-                int required = target - current_sum;
-                
-                // Check if required value is valid (1-9)
-                if (required < 1 || required > 9) {
-                    if (next_on_avoid_path && avoid_sol.count({last_unknown->r, last_unknown->c})) {
-                        LOG_ERROR("[SOUNDNESS BUG] Last cell requires invalid value " << required 
-                                << " for cell (" << last_unknown->r << "," << last_unknown->c << ")");
-                    }
-                    return false;
-                }
-                
-                // Check if required value is in the candidate set
-                if (!(candidates[last_unknown] & (1 << required))) {
-                    if (next_on_avoid_path && avoid_sol.count({last_unknown->r, last_unknown->c})) {
-                        int correct_val = avoid_sol.at({last_unknown->r, last_unknown->c});
-                        LOG_ERROR("[SOUNDNESS BUG] Last cell needs " << required 
-                                << " but it's not in candidates (mask=" << candidates[last_unknown] 
-                                << "). Correct value: " << correct_val);
-                    }
-                    return false;
-                }
-                
-                // Optional but recommended: Force the assignment immediately
-                if (popcount9(candidates[last_unknown]) > 1) {
-                    saved_candidates.push_back({last_unknown, candidates[last_unknown]});
-                    candidates[last_unknown] = (1 << required);
-                }
-            }
-            
-            // Check sum feasibility
-            auto check_soundness_on_failure = [&](const std::string& reason) {
-                if (!next_on_avoid_path) return;
-                // Check if the original solution satisfies this sector
-                int sol_sum = 0;
-                bool sol_possible = true;
-                std::string debug_vals = "";
-                for (Cell* n : *sec) {
-                    if (!avoid_sol.count({n->r, n->c})) { sol_possible = false; break; }
-                    int val_in_sol = avoid_sol.at({n->r, n->c});
-                    sol_sum += val_in_sol;
-                    
-                    debug_vals += "(" + std::to_string(n->r) + "," + std::to_string(n->c) + "):";
-                    if (n->value.has_value()) debug_vals += "v=" + std::to_string(*n->value);
-                    else debug_vals += "cmask=" + std::to_string(candidates[n]);
-                    debug_vals += "[sol=" + std::to_string(val_in_sol) + "] ";
-                }
-                if (sol_possible && sol_sum == target) {
-                    LOG_ERROR("[SOUNDNESS BUG] Pruning valid path. Reason: " << reason << " Target: " << target << " Sum: " << current_sum << " Var: (" << var->r << "," << var->c << ")=" << val);
-                    LOG_ERROR("  Sector details: " << debug_vals);
-                }
-            };
-
-            if (current_sum > target) {
-                 check_soundness_on_failure("Sum exceeded target " + std::to_string(target) + " current=" + std::to_string(current_sum));
-                 return false;
-            }
-            // If filled, check exact match
-            if (unknown_count == 0) {
-                if (current_sum != target) {
-                    check_soundness_on_failure("Sector full but sum " + std::to_string(current_sum) + " != target " + std::to_string(target));
-                    return false;
-                }
-                return true;
-            } 
-
-            int actual_min = current_sum;
-            int actual_max = current_sum;
-
-            for (Cell* n : *sec) {
-                if (!n->value.has_value() && n != var) {
-                    uint16_t mask = candidates[n];
-                    
-                    // Find true min/max from current candidates
-                    int cell_min = 10, cell_max = 0;
-                    for(int d=1; d<=9; d++) {
-                        if (mask & (1<<d)) {
-                            if (d < cell_min) cell_min = d;
-                            if (d > cell_max) cell_max = d;
-                        }
-                    }
-                    
-                    if (cell_min == 10) return false; // No valid candidates
-                    
-                    actual_min += cell_min;
-                    actual_max += cell_max;
-                }
+                hybrid_search(state, avoid_sol, candidates,
+                              max_nodes, seed, next_on_avoid_path);
             }
-
-            if (actual_min > target || actual_max < target) {
-                check_soundness_on_failure("Target unreachable with current candidates");
-                return false;
-            }
-            return true;
-        };
-
-        if (!propagate(var->sector_h, true)) conflict = true;
-        if (!conflict && !propagate(var->sector_v, false)) conflict = true;
-        
-        if (!conflict) {
-             hybrid_search(found_solutions, avoid_sol, candidates,
-                         node_count, max_nodes, seed, timed_out, next_on_avoid_path);
-        }
-        
-        // **FIX 6: Restore BOTH candidates and cell values**
-        candidates[var] = var_orig_mask;
-        var->value = var_orig_value;
-        
-        // **IMPORTANT: Restore candidates in REVERSE order to handle multiple updates to same cell**
-        for (int i = (int)saved_candidates.size() - 1; i >= 0; i--) {
-            candidates[saved_candidates[i].first] = saved_candidates[i].second;
-        }
-        
-        for (int i = (int)saved_values.size() - 1; i >= 0; i--) {
-            saved_values[i].first->value = saved_values[i].second;
         }
+
+        // Restore both candidates and cell values
+        undo_to(mark, candidates);
         
-        if (!found_solutions.empty() || timed_out) return;
+        if (state.stop.load(std::memory_order_relaxed)) return;
     }
 }
 
-std::vector<int> HybridUniquenessChecker::mask_to_values(uint16_t mask) const {
-    std::vector<int> result;
+DigitList HybridUniquenessChecker::mask_to_values(uint16_t mask) const {
+    DigitList result;
     for (int d = 1; d <= 9; d++) {
         if (mask & (1 << d)) {
             result.push_back(d);
@@ -1267,8 +1134,8 @@ bool HybridUniquenessChecker::is_valid_with_candidates(
     }
     
     // Check horizontal sector
-    if (cell->sector_h) {
-        for (Cell* n : *(cell->sector_h)) {
+    if (cell->sector_h >= 0) {
+        for (Cell* n : board_->h_sector(cell)) {
             if (n->value.has_value() && *n->value == val) {
                 return false;
             }
@@ -1276,8 +1143,8 @@ bool HybridUniquenessChecker::is_valid_with_candidates(
     }
     
     // Check vertical sector
-    if (cell->sector_v) {
-        for (Cell* n : *(cell->sector_v)) {
+    if (cell->sector_v >= 0) {
+        for (Cell* n : board_->v_sector(cell)) {
             if (n->value.has_value() && *n->value == val) {
                 return false;
             }
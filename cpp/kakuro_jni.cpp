@@ -3,6 +3,8 @@
 
 #include <jni.h>
 #include "kakuro_cpp.h"
+#include <cstring>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -38,4 +40,261 @@ Java_com_kakuro_CSPSolver_nativeCalculateClues(JNIEnv* env, jobject obj, jlong h
 
 } // extern "C"
 
+// ============================================================================
+// BACKGROUND GENERATION
+// ============================================================================
+//
+// com.kakuro.BackgroundGenerator keeps an on-device pool of ready puzzles:
+// a PuzzleStream's native threads generate them into a bounded queue while
+// the app runs, so taking a puzzle is a copy instead of a generation. Puzzles
+// come out in the compact binary layout of encode_puzzle, written into a
+// direct ByteBuffer. A BackgroundGenerator.Listener gets
+//   void onPuzzleReady(String difficulty, int queued)  - on a native thread
+//   void onStopped()                                   - on the stopping thread
+// The listener must not stop or destroy the generator from onPuzzleReady.
+
+namespace {
+
+struct BackgroundGenerator {
+  BackgroundGenerator(JavaVM* vm, int capacity, int threads)
+      : vm(vm), stream({}, capacity, threads) {}
+
+  JavaVM* vm;
+  kakuro::PuzzleStream stream;
+  std::mutex mutex; // targets, held
+  std::vector<kakuro::StreamTarget> targets;
+  // Encoded puzzles a buffer was too small for, handed out first next time
+  std::multimap<std::string, std::vector<uint8_t>> held;
+  // Only replaced while the stream is stopped, so producers read it unlocked
+  jobject listener = nullptr;
+  jmethodID on_ready = nullptr;
+  jmethodID on_stopped = nullptr;
+};
+
+BackgroundGenerator* from_handle(jlong handle) {
+  return reinterpret_cast<BackgroundGenerator*>(handle);
+}
+
+std::string to_string(JNIEnv* env, jstring s) {
+  if (!s)
+    return "";
+  const char* chars = env->GetStringUTFChars(s, nullptr);
+  std::string out = chars ? chars : "";
+  if (chars)
+    env->ReleaseStringUTFChars(s, chars);
+  return out;
+}
+
+// Detaches a producer thread from the VM when the thread exits
+struct AttachedThread {
+  JavaVM* vm = nullptr;
+  ~AttachedThread() {
+    if (vm)
+      vm->DetachCurrentThread();
+  }
+};
+
+JNIEnv* thread_env(JavaVM* vm) {
+  JNIEnv* env = nullptr;
+  if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK)
+    return env;
+  thread_local AttachedThread attached;
+  if (vm->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+    LOG_ERROR("BackgroundGenerator: could not attach a producer thread");
+    return nullptr;
+  }
+  attached.vm = vm;
+  return env;
+}
+
+void clear_exception(JNIEnv* env, const char* where) {
+  if (env->ExceptionCheck()) {
+    env->ExceptionDescribe();
+    env->ExceptionClear();
+    LOG_ERROR("BackgroundGenerator: exception in " << where);
+  }
+}
+
+void notify_ready(BackgroundGenerator* gen, const std::string& difficulty,
+                  size_t queued) {
+  if (!gen->listener)
+    return;
+  JNIEnv* env = thread_env(gen->vm);
+  if (!env)
+    return;
+  jstring jdifficulty = env->NewStringUTF(difficulty.c_str());
+  env->CallVoidMethod(gen->listener, gen->on_ready, jdifficulty, (jint)queued);
+  clear_exception(env, "onPuzzleReady");
+  env->DeleteLocalRef(jdifficulty);
+}
+
+} // namespace
+
+extern "C" {
+
+// Background generation. `threads` = 0 uses every core; pass fewer to leave
+// the UI thread room.
+JNIEXPORT jlong JNICALL
+Java_com_kakuro_BackgroundGenerator_nativeCreate(JNIEnv* env, jobject obj, jint capacity,
+                                                 jint threads) {
+  JavaVM* vm = nullptr;
+  if (env->GetJavaVM(&vm) != JNI_OK)
+    return 0;
+  auto* gen = new BackgroundGenerator(vm, capacity, threads);
+  gen->stream.set_on_ready([gen](const std::string& difficulty, size_t queued) {
+    notify_ready(gen, difficulty, queued);
+  });
+  return reinterpret_cast<jlong>(gen);
+}
+
+JNIEXPORT void JNICALL
+Java_com_kakuro_BackgroundGenerator_nativeDestroy(JNIEnv* env, jobject obj, jlong handle) {
+  BackgroundGenerator* gen = from_handle(handle);
+  if (!gen)
+    return;
+  gen->stream.stop();
+  if (gen->listener)
+    env->DeleteGlobalRef(gen->listener);
+  delete gen;
+}
+
+// Adds or replaces the target for `difficulty`; square boards with sides in
+// [minSize, maxSize]. maxQueued caps this difficulty's share of the pool
+// (0 = only the capacity) and weight 0 pauses it.
+JNIEXPORT void JNICALL
+Java_com_kakuro_BackgroundGenerator_nativeSetTarget(JNIEnv* env, jobject obj, jlong handle,
+                                                    jstring difficulty, jint minSize,
+                                                    jint maxSize, jint maxQueued,
+                                                    jdouble weight) {
+  BackgroundGenerator* gen = from_handle(handle);
+  kakuro::StreamTarget target;
+  target.fill_params.difficulty = to_string(env, difficulty);
+  target.topo_params.difficulty = target.fill_params.difficulty;
+  target.width_range = target.height_range = {minSize, maxSize};
+  target.max_queued = maxQueued;
+  target.weight = weight;
+
+  std::vector<kakuro::StreamTarget> targets;
+  {
+    std::lock_guard<std::mutex> lock(gen->mutex);
+    auto it = std::find_if(gen->targets.begin(), gen->targets.end(),
+                           [&](const kakuro::StreamTarget& t) {
+                             return t.fill_params.difficulty ==
+                                    target.fill_params.difficulty;
+                           });
+    if (it != gen->targets.end())
+      *it = target;
+    else
+      gen->targets.push_back(target);
+    targets = gen->targets;
+  }
+  gen->stream.set_targets(std::move(targets));
+}
+
+// Returns false while running; set the listener (or null) before nativeStart
+JNIEXPORT jboolean JNICALL
+Java_com_kakuro_BackgroundGenerator_nativeSetListener(JNIEnv* env, jobject obj, jlong handle,
+                                                      jobject listener) {
+  BackgroundGenerator* gen = from_handle(handle);
+  if (gen->stream.running()) {
+    LOG_ERROR("BackgroundGenerator: stop before replacing the listener");
+    return JNI_FALSE;
+  }
+  jmethodID on_ready = nullptr;
+  jmethodID on_stopped = nullptr;
+  if (listener) {
+    jclass cls = env->GetObjectClass(listener);
+    on_ready = env->GetMethodID(cls, "onPuzzleReady", "(Ljava/lang/String;I)V");
+    on_stopped = on_ready ? env->GetMethodID(cls, "onStopped", "()V") : nullptr;
+    env->DeleteLocalRef(cls);
+    if (!on_ready || !on_stopped)
+      return JNI_FALSE; // NoSuchMethodError is pending
+  }
+  if (gen->listener)
+    env->DeleteGlobalRef(gen->listener);
+  gen->listener = listener ? env->NewGlobalRef(listener) : nullptr;
+  gen->on_ready = on_ready;
+  gen->on_stopped = on_stopped;
+  return JNI_TRUE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_kakuro_BackgroundGenerator_nativeStart(JNIEnv* env, jobject obj, jlong handle) {
+  from_handle(handle)->stream.start();
+}
+
+// Cancels the puzzles in progress and waits for the producers, then calls
+// onStopped. Ready puzzles stay available.
+JNIEXPORT void JNICALL
+Java_com_kakuro_BackgroundGenerator_nativeStop(JNIEnv* env, jobject obj, jlong handle) {
+  BackgroundGenerator* gen = from_handle(handle);
+  gen->stream.stop();
+  if (gen->listener) {
+    env->CallVoidMethod(gen->listener, gen->on_stopped);
+    clear_exception(env, "onStopped");
+  }
+}
+
+// Ready puzzles of `difficulty` (null = all)
+JNIEXPORT jint JNICALL
+Java_com_kakuro_BackgroundGenerator_nativeReadyCount(JNIEnv* env, jobject obj, jlong handle,
+                                                     jstring difficulty) {
+  BackgroundGenerator* gen = from_handle(handle);
+  std::string d = to_string(env, difficulty);
+  size_t n = d.empty() ? gen->stream.size() : gen->stream.size(d);
+  std::lock_guard<std::mutex> lock(gen->mutex);
+  for (const auto& [held_difficulty, bytes] : gen->held)
+    n += d.empty() || held_difficulty == d;
+  return (jint)n;
+}
+
+// Writes the oldest ready puzzle of `difficulty` (null = any) into the direct
+// `buffer` from position 0 without waiting. Returns the bytes written, 0 if
+// none is ready, or -size if the buffer is too small; that puzzle is then
+// kept for the next call.
+JNIEXPORT jint JNICALL
+Java_com_kakuro_BackgroundGenerator_nativeTakePuzzle(JNIEnv* env, jobject obj, jlong handle,
+                                                     jstring difficulty, jobject buffer) {
+  BackgroundGenerator* gen = from_handle(handle);
+  void* address = buffer ? env->GetDirectBufferAddress(buffer) : nullptr;
+  if (!address) {
+    jclass cls = env->FindClass("java/lang/IllegalArgumentException");
+    if (cls)
+      env->ThrowNew(cls, "nativeTakePuzzle needs a direct ByteBuffer");
+    return 0;
+  }
+  jlong capacity = env->GetDirectBufferCapacity(buffer);
+  std::string d = to_string(env, difficulty);
+
+  std::vector<uint8_t> bytes;
+  std::string taken;
+  {
+    std::lock_guard<std::mutex> lock(gen->mutex);
+    auto it = d.empty() ? gen->held.begin() : gen->held.find(d);
+    if (it != gen->held.end()) {
+      taken = it->first;
+      bytes = std::move(it->second);
+      gen->held.erase(it);
+    }
+  }
+  if (bytes.empty()) {
+    kakuro::StreamedPuzzle item;
+    if (!gen->stream.pop(item, 0, d))
+      return 0;
+    taken = std::move(item.difficulty);
+    bytes = kakuro::encode_puzzle(item.puzzle);
+  }
+
+  if ((jlong)bytes.size() > capacity) {
+    jint needed = (jint)bytes.size();
+    std::lock_guard<std::mutex> lock(gen->mutex);
+    gen->held.emplace(std::move(taken), std::move(bytes));
+    return -needed;
+  }
+  std::memcpy(address, bytes.data(), bytes.size());
+  return (jint)bytes.size();
+}
+
+} // extern "C"
+
 #endif // KAKURO_JNI_H
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "kakuro_cpp.h"
+
+namespace kakuro {
+
+namespace {
+
+const size_t WRITE_BATCH = 256;
+// How long a drained writer waits for more records before flushing, so a
+// busy producer's records share one flush. Idle writers sleep untimed.
+const auto FLUSH_DELAY = std::chrono::milliseconds(1);
+
+size_t round_up_pow2(size_t n) {
+  size_t p = 2;
+  while (p < n)
+    p <<= 1;
+  return p;
+}
+
+} // namespace
+
+AsyncLogWriter &AsyncLogWriter::instance() {
+  static AsyncLogWriter writer;
+  return writer;
+}
+
+AsyncLogWriter::~AsyncLogWriter() {
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  written_cv_.notify_all();
+  if (writer_.joinable())
+    writer_.join();
+}
+
+void AsyncLogWriter::configure(size_t capacity, LogOverflow overflow) {
+  overflow_ = overflow;
+  std::lock_guard<std::mutex> lock(start_mutex_);
+  if (!started_)
+    capacity_ = std::max<size_t>(capacity, 2);
+}
+
+void AsyncLogWriter::ensure_started() {
+  if (started_.load(std::memory_order_acquire))
+    return;
+  std::lock_guard<std::mutex> lock(start_mutex_);
+  if (started_.load(std::memory_order_relaxed))
+    return;
+
+  size_t capacity = round_up_pow2(capacity_);
+  slots_ = std::make_unique<Slot[]>(capacity);
+  for (size_t i = 0; i < capacity; i++)
+    slots_[i].seq.store(i, std::memory_order_relaxed);
+  mask_ = capacity - 1;
+  writer_ = std::thread(&AsyncLogWriter::run, this);
+  started_.store(true, std::memory_order_release);
+}
+
+// Bounded MPMC ring (Vyukov): a slot is free for position p when its
+// sequence equals p and readable when it equals p + 1.
+bool AsyncLogWriter::push(std::shared_ptr<LogSink> sink, std::string line) {
+  ensure_started();
+
+  size_t pos = head_.load(std::memory_order_relaxed);
+  Slot *slot;
+  for (;;) {
+    slot = &slots_[pos & mask_];
+    size_t seq = slot->seq.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      // Full
+      if (overflow_.load(std::memory_order_relaxed) == LogOverflow::DROP) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      // Full: wait for the writer's next batch
+      uint64_t seen = consumed_.load(std::memory_order_acquire);
+      wake_writer();
+      {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        written_cv_.wait(lock, [&] {
+          return consumed_.load(std::memory_order_acquire) != seen ||
+                 stop_.load(std::memory_order_acquire);
+        });
+      }
+      pos = head_.load(std::memory_order_relaxed);
+    } else {
+      pos = head_.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->sink = std::move(sink);
+  slot->line = std::move(line);
+  // seq_cst (as writer_idle_) so wake_writer() cannot miss a sleeping writer
+  slot->seq.store(pos + 1, std::memory_order_seq_cst);
+  wake_writer();
+  return true;
+}
+
+void AsyncLogWriter::wake_writer() {
+  // The record and writer_idle_ are published seq_cst on both sides, so
+  // either the writer sees the record before sleeping or this sees it idle
+  if (!writer_idle_.load(std::memory_order_seq_cst))
+    return;
+  // The writer holds the mutex until it waits, so the notify cannot be lost
+  { std::lock_guard<std::mutex> lock(wake_mutex_); }
+  wake_.notify_one();
+}
+
+bool AsyncLogWriter::has_record() const {
+  return slots_[tail_ & mask_].seq.load(std::memory_order_seq_cst) ==
+         tail_ + 1;
+}
+
+size_t AsyncLogWriter::write_batch() {
+  size_t n = 0;
+  while (n < WRITE_BATCH) {
+    Slot &slot = slots_[tail_ & mask_];
+    if (slot.seq.load(std::memory_order_acquire) != tail_ + 1)
+      break;
+
+    std::shared_ptr<LogSink> sink = std::move(slot.sink);
+    sink->out << slot.line;
+    slot.line.clear();
+    slot.seq.store(tail_ + mask_ + 1, std::memory_order_release);
+    tail_++;
+    n++;
+
+    // Few loggers are active at once, so a linear scan is enough here
+    if (std::find(dirty_.begin(), dirty_.end(), sink) == dirty_.end())
+      dirty_.push_back(std::move(sink));
+  }
+
+  if (n) {
+    consumed_.fetch_add(n, std::memory_order_release);
+    { std::lock_guard<std::mutex> lock(wake_mutex_); }
+    written_cv_.notify_all();
+  }
+  return n;
+}
+
+void AsyncLogWriter::flush_sinks() {
+  // Dropping the last reference closes files whose logger already closed
+  for (auto &sink : dirty_)
+    sink->out.flush();
+  dirty_.clear();
+  written_.store(tail_, std::memory_order_release);
+  { std::lock_guard<std::mutex> lock(wake_mutex_); }
+  written_cv_.notify_all();
+}
+
+void AsyncLogWriter::run() {
+  bool delayed = false;
+  for (;;) {
+    if (write_batch()) {
+      if (flush_waiters_.load(std::memory_order_acquire))
+        flush_sinks();
+      continue;
+    }
+    if (stop_.load(std::memory_order_acquire)) {
+      // Drain anything queued between the last batch and the stop request
+      while (write_batch())
+        ;
+      flush_sinks();
+      return;
+    }
+    if (!dirty_.empty()) {
+      if (!delayed && !flush_waiters_.load(std::memory_order_acquire)) {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait_for(lock, FLUSH_DELAY, [&] {
+          return stop_.load(std::memory_order_acquire) ||
+                 flush_waiters_.load(std::memory_order_acquire);
+        });
+        delayed = true;
+        continue;
+      }
+      flush_sinks();
+    }
+    delayed = false;
+
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    writer_idle_.store(true, std::memory_order_seq_cst);
+    wake_.wait(lock, [&] {
+      return has_record() || stop_.load(std::memory_order_acquire);
+    });
+    writer_idle_.store(false, std::memory_order_relaxed);
+  }
+}
+
+void AsyncLogWriter::flush() {
+  if (!started_.load(std::memory_order_acquire))
+    return;
+  // Every position claimed so far; the writer consumes positions in order
+  uint64_t target = head_.load(std::memory_order_acquire);
+  flush_waiters_.fetch_add(1, std::memory_order_acq_rel);
+  std::unique_lock<std::mutex> lock(wake_mutex_);
+  wake_.notify_one(); // Ends a flush delay early
+  written_cv_.wait(lock, [&] {
+    return written_.load(std::memory_order_acquire) >= target;
+  });
+  flush_waiters_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+namespace {
+
+// Reads cell (r, c) of `board` as the logger stores it; a single digit in
+// `candidates` stands in for the cell's value
+struct BoardCells {
+  const KakuroBoard &board;
+  const CandidateMap *candidates;
+
+  LogCell operator()(size_t r, size_t c) const {
+    const Cell &cell = board.grid[r][c];
+    int value = cell.value.value_or(0);
+    if (candidates && cell.idx >= 0 && cell.idx < candidates->size()) {
+      uint16_t mask = (*candidates)[&cell];
+      if (popcount9(mask) == 1)
+        value = lowest_bit_index(mask);
+    }
+    return LogCell{cell.type, value, cell.clue_h.value_or(0),
+                   cell.clue_v.value_or(0)};
+  }
+};
+
+} // namespace
+
+void GenerationLogger::log_step(const std::string &stage,
+                                const std::string &substage,
+                                const std::string &message,
+                                const KakuroBoard &board,
+                                const CandidateMap *candidates,
+                                const std::string &extra_data) {
+#if KAKURO_ENABLE_LOGGING
+  if (!wants_step(substage))
+    return;
+  std::ostringstream &line = begin_step(stage, substage, message);
+  write_frame(line, board.height, board.width, BoardCells{board, candidates});
+  end_step(line, extra_data);
+#else
+  (void)stage;
+  (void)substage;
+  (void)message;
+  (void)board;
+  (void)candidates;
+  (void)extra_data;
+#endif
+}
+
+void GenerationLogger::log_difficulty(const DifficultyResult &diff,
+                                      const KakuroBoard &board) {
+#if KAKURO_ENABLE_LOGGING
+  if (!enabled_ || !log_sink_)
+    return;
+
+  std::ostringstream &line = begin_record(log_buf_);
+  line << "{\"id\":" << step_id_++
+       << ",\"s\":\"" << STAGE_DIFFICULTY << "\""
+       << ",\"ss\":\"" << SUBSTAGE_COMPLETE << "\""
+       << ",\"m\":\"Difficulty estimation complete: " << escape_json(diff.rating) << "\""
+       << ",\"difficulty\":{"
+       << "\"rating\":\"" << escape_json(diff.rating) << "\""
+       << ",\"score\":" << diff.score
+       << ",\"max_tier\":" << (int)diff.max_tier
+       << ",\"solution_count\":" << diff.solution_count
+       << ",\"uniqueness\":\"" << escape_json(diff.uniqueness) << "\"}";
+
+  // Always a keyframe so the result is readable on its own
+  BoardCells cells{board, nullptr};
+  write_grid(line, board.height, board.width, cells);
+  store_frame(board.height, board.width, cells);
+  line << "}\n";
+  if (!emit(log_sink_, line))
+    last_frame_.clear();
+#else
+  (void)diff;
+  (void)board;
+#endif
+}
+
+} // namespace kakuro
@@ -0,0 +1,543 @@
+// Kernel-level microbenchmarks on a fixed seeded board.
+//
+// Times the hot kernels of topology, fill, difficulty and uniqueness in
+// isolation and reports ns and heap allocations per call, so layout changes
+// can be compared below the puzzles/s of kakuro_bench.
+//
+//   kakuro_microbench [--filter a,b,...] [--min-time SEC] [--seed S]
+//                     [--size N] [--difficulty D] [--out FILE]
+//
+// --filter keeps benchmarks whose name contains one of the substrings. JSON
+// goes to stdout (or FILE); a table goes to stderr.
+
+#include "kakuro_cpp.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// ============================================================================
+// ALLOCATION COUNTING
+// ============================================================================
+
+namespace {
+
+// Only the benchmark thread counts, so the async log writer stays out of it
+thread_local bool count_allocations = false;
+thread_local long long allocation_count = 0;
+thread_local long long allocation_bytes = 0;
+
+void *counted_alloc(std::size_t size) {
+  if (count_allocations) {
+    allocation_count++;
+    allocation_bytes += (long long)size;
+  }
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+} // namespace
+
+void *operator new(std::size_t size) { return counted_alloc(size); }
+void *operator new[](std::size_t size) { return counted_alloc(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return counted_alloc(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return counted_alloc(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+namespace kakuro {
+
+using SolutionMap = std::unordered_map<std::pair<int, int>, int, PairHash>;
+
+// Seeded generated puzzle plus the per-kernel state built from it
+struct BenchBoard {
+  uint32_t seed = 0;
+  std::shared_ptr<KakuroBoard> board;
+  SolutionMap solution;
+  std::vector<int> values; // Solution by Cell::idx
+};
+
+// Calls into the private kernels. Each function runs one sweep and returns
+// the number of kernel calls it made.
+struct KernelBench {
+  // --- CSPSolver ---
+
+  // Mid-fill state: every other cell assigned its solution value
+  static void half_fill(CSPSolver &solver, const BenchBoard &b,
+                        CSPSolver::FillState &state) {
+    solver.board->reset_values();
+    state.init(*solver.board);
+    for (Cell *c : solver.board->white_cells)
+      if (c->idx % 2 == 0)
+        state.assign(c, b.values[c->idx]);
+  }
+
+  static long long is_valid_move(CSPSolver &solver,
+                                 const CSPSolver::FillState &state,
+                                 long long &sink) {
+    long long calls = 0;
+    for (Cell *c : solver.board->white_cells) {
+      for (int v = 1; v <= 9; v++)
+        sink += solver.is_valid_move(c, v, &state);
+      calls += 9;
+    }
+    return calls;
+  }
+
+  static long long get_domain_size(CSPSolver &solver,
+                                   const CSPSolver::FillState &state,
+                                   long long &sink) {
+    for (Cell *c : solver.board->white_cells)
+      sink += solver.get_domain_size(c, &state);
+    return (long long)solver.board->white_cells.size();
+  }
+
+  static long long calculate_partition_score(CSPSolver &solver,
+                                             const CSPSolver::FillState &state,
+                                             const std::string &preference,
+                                             double &sink) {
+    long long calls = 0;
+    for (Cell *c : solver.board->white_cells) {
+      for (int v = 1; v <= 9; v++) {
+        sink += solver.calculate_partition_score(c, v, state, 'h', preference);
+        sink += solver.calculate_partition_score(c, v, state, 'v', preference);
+      }
+      calls += 18;
+    }
+    return calls;
+  }
+
+  // --- KakuroDifficultyEstimator ---
+
+  static long long apply_sector_constraints(KakuroDifficultyEstimator &est,
+                                            CandidateMap &candidates,
+                                            long long &sink) {
+    candidates.assign((int)est.board->white_cells.size(),
+                      KakuroDifficultyEstimator::ALL_CANDIDATES);
+    for (const auto &sec : est.all_sectors)
+      sink += est.apply_sector_constraints(sec, candidates);
+    return (long long)est.all_sectors.size();
+  }
+
+  // The logic loop as the bifurcation runs it on each branch, reset as in
+  // begin_estimate() but without a deadline, so long runs are not cut short
+  static long long run_solve_loop(KakuroDifficultyEstimator &est,
+                                  CandidateMap &candidates, long long &sink) {
+    est.solve_log.clear();
+    est.trail_.clear();
+    est.logged_singles.assign(est.board->white_cells.size(), false);
+    est.nodes_explored = 0;
+    est.search_aborted = false;
+    if (!est.estimate_budget_)
+      est.estimate_budget_ = GenerationBudget::create();
+    candidates.assign((int)est.board->white_cells.size(),
+                      KakuroDifficultyEstimator::ALL_CANDIDATES);
+    est.run_solve_loop(candidates, true);
+    sink += candidates[est.board->white_cells[0]];
+    return 1;
+  }
+
+  // --- HybridUniquenessChecker ---
+
+  // Candidates as check_uniqueness_hybrid starts the root reduction
+  static CandidateMap root_candidates(const KakuroBoard &board) {
+    CandidateMap candidates((int)board.white_cells.size(),
+                            HybridUniquenessChecker::ALL_CANDIDATES);
+    auto restrict = [&](const SectorTable &sectors, bool is_h) {
+      for (SectorSpan s : sectors) {
+        Cell *clue_cell = sectors.clue_cell(s.id());
+        std::optional<int> clue;
+        if (clue_cell)
+          clue = is_h ? clue_cell->clue_h : clue_cell->clue_v;
+        if (!clue)
+          continue;
+        uint16_t mask = partition_union(*clue, (int)s.size());
+        for (Cell *c : s)
+          candidates[c] &= mask;
+      }
+    };
+    restrict(board.sectors_h, true);
+    restrict(board.sectors_v, false);
+    return candidates;
+  }
+
+  static long long apply_logical_reduction(HybridUniquenessChecker &checker,
+                                           const CandidateMap &root,
+                                           CandidateMap &candidates,
+                                           const BenchBoard &b,
+                                           long long &sink) {
+    candidates = root;
+    checker.init_propagation();
+    sink += (int)checker.apply_logical_reduction(candidates, b.solution);
+    // The reduction fixes Cell::value for singles; put the solution back
+    for (Cell *c : checker.board_->white_cells)
+      c->value = b.values[c->idx];
+    return 1;
+  }
+
+  // --- KakuroBoard ---
+
+  // Every line dirty, as after a new topology
+  static long long identify_sectors(KakuroBoard &board, long long &sink) {
+    auto all_lines = [](int n) { return n >= 64 ? ~0ULL : (1ULL << n) - 1; };
+    board.dirty_rows_ = all_lines(board.height);
+    board.dirty_cols_ = all_lines(board.width);
+    board.identify_sectors();
+    sink += board.sectors_h.size();
+    return 1;
+  }
+};
+
+} // namespace kakuro
+
+namespace {
+
+using kakuro::BenchBoard;
+using kakuro::KernelBench;
+
+struct MicroConfig {
+  std::vector<std::string> filters;
+  double min_time = 0.5;
+  uint32_t seed = 1;
+  int size = 12; // Upper end of the medium range
+  std::string difficulty = "medium";
+  std::string out_path;
+};
+
+struct MicroResult {
+  std::string name;
+  long long calls = 0;
+  double ns_per_op = 0;
+  double allocs_per_op = 0;
+  double bytes_per_op = 0;
+};
+
+std::vector<std::string> split(const std::string &s) {
+  std::vector<std::string> parts;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, ','))
+    if (!item.empty())
+      parts.push_back(item);
+  return parts;
+}
+
+bool parse_args(int argc, char **argv, MicroConfig &cfg) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return false;
+    }
+    std::string val = argv[++i];
+    if (arg == "--filter")
+      cfg.filters = split(val);
+    else if (arg == "--min-time")
+      cfg.min_time = std::atof(val.c_str());
+    else if (arg == "--seed")
+      cfg.seed = (uint32_t)std::strtoul(val.c_str(), nullptr, 10);
+    else if (arg == "--size")
+      cfg.size = std::atoi(val.c_str());
+    else if (arg == "--difficulty")
+      cfg.difficulty = val;
+    else if (arg == "--out")
+      cfg.out_path = val;
+    else {
+      std::cerr << "Unknown option " << arg << std::endl;
+      return false;
+    }
+  }
+  return cfg.min_time > 0 && cfg.size >= 3;
+}
+
+// Generates the fixture with the seeds kakuro_bench uses, moving on to the
+// next seed if a generation fails
+bool make_board(const MicroConfig &cfg, BenchBoard &out) {
+  for (uint32_t seed = cfg.seed; seed < cfg.seed + 16; seed++) {
+    auto board =
+        std::make_shared<kakuro::KakuroBoard>(cfg.size, cfg.size, seed);
+    kakuro::CSPSolver solver(board, seed ^ 0x9E3779B9u);
+    if (!solver.generate_puzzle(cfg.difficulty))
+      continue;
+    out.seed = seed;
+    out.board = board;
+    out.values.assign(board->white_cells.size(), 0);
+    for (kakuro::Cell *c : board->white_cells) {
+      out.values[c->idx] = c->value.value_or(0);
+      out.solution[{c->r, c->c}] = c->value.value_or(0);
+    }
+    return true;
+  }
+  return false;
+}
+
+// W/B pattern with many 3x3 white patches for break_large_patches
+std::vector<uint64_t> patchy_rows(int width, int height, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<uint64_t> rows(height, 0);
+  for (int r = 1; r < height; r++)
+    for (int c = 1; c < width; c++)
+      if (rng() % 100 < 85)
+        rows[r] |= 1ULL << c;
+  return rows;
+}
+
+class Runner {
+public:
+  explicit Runner(const MicroConfig &cfg) : cfg_(cfg) {}
+
+  // `sweep` makes some kernel calls and returns how many; batches grow until
+  // one takes at least min_time, and that batch is reported
+  template <typename Sweep> void run(const std::string &name, Sweep sweep) {
+    if (!selected(name))
+      return;
+    sweep(); // Warm-up
+
+    long long batch = 1;
+    MicroResult r;
+    r.name = name;
+    for (;;) {
+      allocation_count = 0;
+      allocation_bytes = 0;
+      long long calls = 0;
+      count_allocations = true;
+      auto start = std::chrono::steady_clock::now();
+      for (long long i = 0; i < batch; i++)
+        calls += sweep();
+      double s = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+      count_allocations = false;
+
+      if (s >= cfg_.min_time || batch >= (1LL << 30)) {
+        double n = (double)std::max(1LL, calls);
+        r.calls = calls;
+        r.ns_per_op = s * 1e9 / n;
+        r.allocs_per_op = allocation_count / n;
+        r.bytes_per_op = allocation_bytes / n;
+        break;
+      }
+      // Aim past min_time from the last batch's rate, growing 2-10x
+      double factor = s > 0 ? cfg_.min_time * 1.2 / s : 10.0;
+      batch = (long long)(batch * std::min(10.0, std::max(2.0, factor)));
+    }
+
+    fprintf(stderr, "%-44s %10.1f ns/op %8.2f allocs/op %9.1f B/op %10lld\n",
+            r.name.c_str(), r.ns_per_op, r.allocs_per_op, r.bytes_per_op,
+            r.calls);
+    results_.push_back(r);
+  }
+
+  const std::vector<MicroResult> &results() const { return results_; }
+
+private:
+  bool selected(const std::string &name) const {
+    if (cfg_.filters.empty())
+      return true;
+    for (const auto &f : cfg_.filters)
+      if (name.find(f) != std::string::npos)
+        return true;
+    return false;
+  }
+
+  const MicroConfig &cfg_;
+  std::vector<MicroResult> results_;
+};
+
+// Accumulated kernel results, kept so the calls are not optimized out
+volatile long long g_sink = 0;
+volatile double g_sink_f = 0;
+
+void run_solver(Runner &bench, const BenchBoard &b) {
+  auto board = b.board->clone();
+  kakuro::CSPSolver solver(board, b.seed);
+  kakuro::CSPSolver::FillState state;
+  KernelBench::half_fill(solver, b, state);
+
+  long long sink = 0;
+  double sink_f = 0;
+  bench.run("CSPSolver::is_valid_move",
+      [&] { return KernelBench::is_valid_move(solver, state, sink); });
+  bench.run("CSPSolver::get_domain_size",
+      [&] { return KernelBench::get_domain_size(solver, state, sink); });
+  for (const char *preference : {"unique", "few"}) {
+    std::string pref = preference;
+    bench.run("CSPSolver::calculate_partition_score/" + pref, [&] {
+      return KernelBench::calculate_partition_score(solver, state, pref,
+                                                    sink_f);
+    });
+  }
+  g_sink = g_sink + sink;
+  g_sink_f = g_sink_f + sink_f;
+}
+
+void run_estimator(Runner &bench, const BenchBoard &b) {
+  auto board = b.board->clone();
+  kakuro::KakuroDifficultyEstimator est(board);
+  kakuro::CandidateMap candidates;
+
+  long long sink = 0;
+  bench.run("Estimator::apply_sector_constraints", [&] {
+    return KernelBench::apply_sector_constraints(est, candidates, sink);
+  });
+  bench.run("Estimator::run_solve_loop",
+      [&] { return KernelBench::run_solve_loop(est, candidates, sink); });
+  g_sink = g_sink + sink;
+}
+
+void run_uniqueness(Runner &bench, const BenchBoard &b) {
+  auto board = b.board->clone();
+  kakuro::HybridUniquenessChecker checker(board);
+  kakuro::CandidateMap root = KernelBench::root_candidates(*board);
+  kakuro::CandidateMap candidates;
+
+  long long sink = 0;
+  bench.run("Uniqueness::apply_logical_reduction", [&] {
+    return KernelBench::apply_logical_reduction(checker, root, candidates, b,
+                                                sink);
+  });
+  g_sink = g_sink + sink;
+}
+
+void run_board(Runner &bench, const BenchBoard &b, const MicroConfig &cfg) {
+  auto board = b.board->clone();
+  long long sink = 0;
+  bench.run("KakuroBoard::identify_sectors/full",
+      [&] { return KernelBench::identify_sectors(*board, sink); });
+  bench.run("KakuroBoard::find_components", [&] {
+    sink += board->find_components().size();
+    return 1LL;
+  });
+
+  // break_large_patches edits the board, so each call starts from a reload;
+  // subtract load_white_rows for the kernel alone
+  kakuro::KakuroBoard patchy(cfg.size, cfg.size, b.seed);
+  std::vector<uint64_t> rows = patchy_rows(cfg.size, cfg.size, b.seed);
+  bench.run("KakuroBoard::load_white_rows", [&] {
+    patchy.load_white_rows(rows.data());
+    return 1LL;
+  });
+  bench.run("KakuroBoard::break_large_patches+reload", [&] {
+    patchy.load_white_rows(rows.data());
+    patchy.rng.seed(b.seed);
+    sink += patchy.break_large_patches(3);
+    return 1LL;
+  });
+  g_sink = g_sink + sink;
+}
+
+void run_logger(Runner &bench, const BenchBoard &b) {
+#if KAKURO_ENABLE_LOGGING
+  std::error_code ec;
+  auto dir = std::filesystem::temp_directory_path(ec) / "kakuro_microbench";
+  if (ec) {
+    LOG_ERROR("kakuro_microbench: no temp directory, skipping the logger");
+    return;
+  }
+  kakuro::LogLevel level = kakuro::GenerationLogger::level();
+  kakuro::Cell *cell = b.board->white_cells[0];
+  std::optional<int> saved = cell->value;
+
+  for (bool async : {false, true}) {
+    kakuro::GenerationLogger::configure(kakuro::LogLevel::FULL, async);
+    kakuro::GenerationLogger logger;
+    logger.start_new_kakuro(dir.string());
+    if (!logger.is_enabled()) {
+      LOG_ERROR("kakuro_microbench: cannot open logs in " << dir.string());
+      break;
+    }
+    // One changed cell per step, as in a fill
+    int step = 0;
+    std::string name = async ? "GenerationLogger::log_step/async"
+                             : "GenerationLogger::log_step";
+    bench.run(name, [&] {
+      cell->value = 1 + step++ % 9;
+      logger.log_step(kakuro::GenerationLogger::STAGE_FILLING,
+                      kakuro::GenerationLogger::SUBSTAGE_NUMBER_PLACEMENT,
+                      "Placed value", *b.board);
+      return 1LL;
+    });
+    logger.close();
+    kakuro::GenerationLogger::flush_all();
+  }
+  cell->value = saved;
+  kakuro::GenerationLogger::configure(level, false);
+  std::filesystem::remove_all(dir, ec);
+#else
+  (void)bench;
+  (void)b;
+#endif
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  MicroConfig cfg;
+  if (!parse_args(argc, argv, cfg)) {
+    std::cerr << "usage: kakuro_microbench [--filter a,b] [--min-time SEC] "
+                 "[--seed S] [--size N] [--difficulty D] [--out FILE]"
+              << std::endl;
+    return 2;
+  }
+
+  // Generation logs stay off; only the logger benchmark opens them
+  kakuro::GenerationLogger::configure(kakuro::LogLevel::OFF);
+  BenchBoard b;
+  if (!make_board(cfg, b)) {
+    std::cerr << "Could not generate a " << cfg.difficulty << " " << cfg.size
+              << "x" << cfg.size << " board" << std::endl;
+    return 1;
+  }
+  fprintf(stderr, "%s %dx%d, seed %u, %zu white cells\n",
+          cfg.difficulty.c_str(), cfg.size, cfg.size, b.seed,
+          b.board->white_cells.size());
+
+  Runner bench(cfg);
+  run_solver(bench, b);
+  run_estimator(bench, b);
+  run_uniqueness(bench, b);
+  run_board(bench, b, cfg);
+  run_logger(bench, b);
+
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(3);
+  os << "{\"config\":{\"seed\":" << b.seed << ",\"size\":" << cfg.size
+     << ",\"difficulty\":\"" << cfg.difficulty << "\""
+     << ",\"white_cells\":" << b.board->white_cells.size()
+     << ",\"min_time_s\":" << cfg.min_time << "},\"results\":[";
+  const auto &results = bench.results();
+  for (size_t i = 0; i < results.size(); i++) {
+    const MicroResult &r = results[i];
+    os << (i ? "," : "") << "{\"name\":\"" << r.name << "\","
+       << "\"calls\":" << r.calls << ",\"ns_per_op\":" << r.ns_per_op
+       << ",\"allocs_per_op\":" << r.allocs_per_op
+       << ",\"bytes_per_op\":" << r.bytes_per_op << "}";
+  }
+  os << "]}\n";
+
+  if (cfg.out_path.empty()) {
+    std::cout << os.str();
+  } else {
+    std::ofstream out(cfg.out_path);
+    if (!out) {
+      std::cerr << "Cannot write " << cfg.out_path << std::endl;
+      return 1;
+    }
+    out << os.str();
+  }
+  return 0;
+}
@@ -0,0 +1,402 @@
+#include "kakuro_cpp.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kakuro {
+
+namespace {
+
+const uint8_t PUZZLE_MAGIC[3] = {'K', 'K', 'P'};
+const uint8_t POOL_MAGIC[4] = {'K', 'K', 'P', 'L'};
+const uint32_t POOL_VERSION = 1;
+const size_t POOL_HEADER_SIZE = 16;
+// Fixed fields before the strings: magic, version, w, h, tier, count, steps,
+// score
+const size_t PUZZLE_FIXED_SIZE = 14;
+
+void put_u8(std::vector<uint8_t> &out, uint8_t v) { out.push_back(v); }
+
+void put_u16(std::vector<uint8_t> &out, uint16_t v) {
+  out.push_back((uint8_t)(v & 0xFF));
+  out.push_back((uint8_t)(v >> 8));
+}
+
+void put_u32(std::vector<uint8_t> &out, uint32_t v) {
+  for (int i = 0; i < 4; i++)
+    out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+void put_string(std::vector<uint8_t> &out, const std::string &s) {
+  size_t len = std::min<size_t>(s.size(), 255);
+  out.push_back((uint8_t)len);
+  out.insert(out.end(), s.begin(), s.begin() + len);
+}
+
+uint32_t read_u32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+// Bounds-checked cursor; any read past the end clears `ok`
+struct Reader {
+  const uint8_t *data;
+  size_t size;
+  size_t pos = 0;
+  bool ok = true;
+
+  bool has(size_t n) {
+    if (pos + n > size)
+      ok = false;
+    return ok;
+  }
+  uint8_t u8() { return has(1) ? data[pos++] : 0; }
+  uint16_t u16() {
+    if (!has(2))
+      return 0;
+    uint16_t v = (uint16_t)(data[pos] | (data[pos + 1] << 8));
+    pos += 2;
+    return v;
+  }
+  uint32_t u32() {
+    if (!has(4))
+      return 0;
+    uint32_t v = read_u32(data + pos);
+    pos += 4;
+    return v;
+  }
+  std::string str() {
+    size_t len = u8();
+    if (!has(len))
+      return "";
+    std::string s((const char *)data + pos, len);
+    pos += len;
+    return s;
+  }
+};
+
+bool valid_pool_header(const uint8_t *p) {
+  return std::memcmp(p, POOL_MAGIC, 4) == 0 && read_u32(p + 4) == POOL_VERSION;
+}
+
+} // namespace
+
+std::vector<uint8_t> encode_puzzle(const GeneratedPuzzle &puzzle) {
+  const DifficultyResult &d = puzzle.difficulty;
+  int cells = puzzle.width * puzzle.height;
+
+  std::vector<uint8_t> out;
+  out.reserve(PUZZLE_FIXED_SIZE + 2 + d.rating.size() + d.uniqueness.size() +
+              cells / 8 + cells * 2 + 2);
+  for (uint8_t b : PUZZLE_MAGIC)
+    put_u8(out, b);
+  put_u8(out, PUZZLE_FORMAT_VERSION);
+  put_u8(out, (uint8_t)puzzle.width);
+  put_u8(out, (uint8_t)puzzle.height);
+  put_u8(out, (uint8_t)d.max_tier);
+  put_u8(out, (uint8_t)std::min(d.solution_count, 255));
+  put_u16(out, (uint16_t)std::min(d.total_steps, 65535));
+  uint32_t score_bits;
+  std::memcpy(&score_bits, &d.score, sizeof(score_bits));
+  put_u32(out, score_bits);
+  put_string(out, d.rating);
+  put_string(out, d.uniqueness);
+
+  size_t bitmap = out.size();
+  out.resize(bitmap + (cells + 7) / 8, 0);
+  for (int r = 0; r < puzzle.height; r++) {
+    for (int c = 0; c < puzzle.width; c++) {
+      int i = r * puzzle.width + c;
+      if (puzzle.grid[r][c].type == CellType::WHITE)
+        out[bitmap + i / 8] |= (uint8_t)(1 << (i % 8));
+    }
+  }
+
+  std::vector<uint8_t> nibbles;
+  for (const auto &row : puzzle.grid) {
+    for (const PuzzleCell &cell : row) {
+      if (cell.type == CellType::BLOCK) {
+        put_u8(out, (uint8_t)cell.clue_h.value_or(0));
+        put_u8(out, (uint8_t)cell.clue_v.value_or(0));
+      } else {
+        nibbles.push_back((uint8_t)cell.solution.value_or(0));
+      }
+    }
+  }
+  for (size_t i = 0; i < nibbles.size(); i += 2) {
+    uint8_t hi = i + 1 < nibbles.size() ? nibbles[i + 1] : 0;
+    put_u8(out, (uint8_t)(nibbles[i] | (hi << 4)));
+  }
+  return out;
+}
+
+bool decode_puzzle(const uint8_t *data, size_t size, GeneratedPuzzle &out) {
+  if (size < PUZZLE_FIXED_SIZE || std::memcmp(data, PUZZLE_MAGIC, 3) != 0 ||
+      data[3] != PUZZLE_FORMAT_VERSION)
+    return false;
+
+  Reader in{data, size, 4};
+  GeneratedPuzzle puzzle;
+  puzzle.width = in.u8();
+  puzzle.height = in.u8();
+  DifficultyResult &d = puzzle.difficulty;
+  d.max_tier = (TechniqueTier)in.u8();
+  d.solution_count = in.u8();
+  d.total_steps = in.u16();
+  uint32_t score_bits = in.u32();
+  std::memcpy(&d.score, &score_bits, sizeof(score_bits));
+  d.rating = in.str();
+  d.uniqueness = in.str();
+
+  int cells = puzzle.width * puzzle.height;
+  size_t bitmap = in.pos;
+  if (!in.has((cells + 7) / 8))
+    return false;
+  in.pos += (cells + 7) / 8;
+
+  puzzle.grid.assign(puzzle.height, std::vector<PuzzleCell>(puzzle.width));
+  std::vector<PuzzleCell *> whites;
+  for (int r = 0; r < puzzle.height; r++) {
+    for (int c = 0; c < puzzle.width; c++) {
+      int i = r * puzzle.width + c;
+      PuzzleCell &cell = puzzle.grid[r][c];
+      if (data[bitmap + i / 8] & (1 << (i % 8))) {
+        cell.type = CellType::WHITE;
+        whites.push_back(&cell);
+      } else {
+        cell.type = CellType::BLOCK;
+        uint8_t h = in.u8(), v = in.u8();
+        if (h)
+          cell.clue_h = h;
+        if (v)
+          cell.clue_v = v;
+      }
+    }
+  }
+  for (size_t i = 0; i < whites.size(); i += 2) {
+    uint8_t packed = in.u8();
+    if (packed & 0x0F)
+      whites[i]->solution = packed & 0x0F;
+    if (i + 1 < whites.size() && (packed >> 4))
+      whites[i + 1]->solution = packed >> 4;
+  }
+  if (!in.ok)
+    return false;
+
+  out = std::move(puzzle);
+  return true;
+}
+
+// ============================================================================
+// POOL WRITER
+// ============================================================================
+
+bool PuzzlePoolWriter::open(const std::string &path) {
+  close();
+  bool exists = false;
+  {
+    std::ifstream in(path, std::ios::binary);
+    uint8_t header[POOL_HEADER_SIZE];
+    if (in && in.read((char *)header, POOL_HEADER_SIZE)) {
+      if (!valid_pool_header(header)) {
+        LOG_ERROR("Not a version " << POOL_VERSION << " puzzle pool: " << path);
+        return false;
+      }
+      exists = true;
+    }
+  }
+
+  out_.open(path, std::ios::binary | std::ios::app);
+  if (!out_) {
+    LOG_ERROR("Cannot open puzzle pool for writing: " << path);
+    return false;
+  }
+  if (!exists) {
+    std::vector<uint8_t> header(POOL_MAGIC, POOL_MAGIC + 4);
+    put_u32(header, POOL_VERSION);
+    header.resize(POOL_HEADER_SIZE, 0);
+    out_.write((const char *)header.data(), header.size());
+    out_.flush();
+  }
+  return (bool)out_;
+}
+
+bool PuzzlePoolWriter::append(const GeneratedPuzzle &puzzle,
+                              const std::string &difficulty) {
+  if (!out_.is_open())
+    return false;
+  std::vector<uint8_t> payload = encode_puzzle(puzzle);
+  std::vector<uint8_t> record;
+  record.reserve(5 + difficulty.size() + payload.size());
+  put_u32(record, (uint32_t)payload.size());
+  put_string(record, difficulty);
+  record.insert(record.end(), payload.begin(), payload.end());
+
+  out_.write((const char *)record.data(), record.size());
+  out_.flush();
+  return (bool)out_;
+}
+
+void PuzzlePoolWriter::close() {
+  if (out_.is_open())
+    out_.close();
+}
+
+// ============================================================================
+// POOL READER
+// ============================================================================
+
+PuzzlePool::PuzzlePool() : rng_(std::random_device{}()) {}
+
+PuzzlePool::~PuzzlePool() { close(); }
+
+bool PuzzlePool::open(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  unmap_file();
+  index_.clear();
+  num_records_ = 0;
+  path_ = path;
+  indexed_end_ = POOL_HEADER_SIZE;
+  if (!map_file())
+    return false;
+  if (!valid_pool_header(data_)) {
+    LOG_ERROR("Not a version " << POOL_VERSION << " puzzle pool: " << path);
+    unmap_file();
+    return false;
+  }
+  index_from(indexed_end_);
+  return true;
+}
+
+bool PuzzlePool::refresh() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!data_)
+    return false;
+#ifndef _WIN32
+  struct stat st;
+  if (::stat(path_.c_str(), &st) != 0)
+    return false;
+  if ((size_t)st.st_size == mapped_size_)
+    return true;
+#endif
+  // Offsets stay valid: the file only ever grows
+  if (!map_file())
+    return false;
+  index_from(indexed_end_);
+  return true;
+}
+
+void PuzzlePool::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  unmap_file();
+  index_.clear();
+  num_records_ = 0;
+}
+
+size_t PuzzlePool::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_records_;
+}
+
+size_t PuzzlePool::count(const std::string &difficulty, int width,
+                         int height) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(Key(difficulty, width, height));
+  return it == index_.end() ? 0 : it->second.size();
+}
+
+bool PuzzlePool::random_puzzle(const std::string &difficulty, int width,
+                               int height, GeneratedPuzzle &out) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(Key(difficulty, width, height));
+  if (it == index_.end() || it->second.empty())
+    return false;
+  const auto &records = it->second;
+  const Record &rec = records[std::uniform_int_distribution<size_t>(
+      0, records.size() - 1)(rng_)];
+  return decode_puzzle(data_ + rec.offset, rec.size, out);
+}
+
+bool PuzzlePool::map_file() {
+  unmap_file();
+#ifdef _WIN32
+  std::ifstream in(path_, std::ios::binary | std::ios::ate);
+  if (!in)
+    return false;
+  buffer_.resize((size_t)in.tellg());
+  in.seekg(0);
+  if (!in.read((char *)buffer_.data(), buffer_.size()) ||
+      buffer_.size() < POOL_HEADER_SIZE) {
+    buffer_.clear();
+    return false;
+  }
+  data_ = buffer_.data();
+  mapped_size_ = buffer_.size();
+#else
+  int fd = ::open(path_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG_ERROR("Cannot open puzzle pool: " << path_);
+    return false;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || (size_t)st.st_size < POOL_HEADER_SIZE) {
+    ::close(fd);
+    return false;
+  }
+  void *p = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) {
+    LOG_ERROR("Cannot map puzzle pool: " << path_);
+    return false;
+  }
+  data_ = (const uint8_t *)p;
+  mapped_size_ = (size_t)st.st_size;
+#endif
+  return true;
+}
+
+void PuzzlePool::unmap_file() {
+#ifdef _WIN32
+  buffer_.clear();
+#else
+  if (data_)
+    ::munmap((void *)data_, mapped_size_);
+#endif
+  data_ = nullptr;
+  mapped_size_ = 0;
+}
+
+void PuzzlePool::index_from(size_t offset) {
+  // Only record headers and the payload's size bytes are read here
+  while (offset + 5 <= mapped_size_) {
+    uint32_t payload_size = read_u32(data_ + offset);
+    size_t label_len = data_[offset + 4];
+    size_t payload = offset + 5 + label_len;
+    size_t end = payload + payload_size;
+    if (end > mapped_size_)
+      break; // Partial record still being written
+    if (payload_size < PUZZLE_FIXED_SIZE ||
+        std::memcmp(data_ + payload, PUZZLE_MAGIC, 3) != 0) {
+      LOG_ERROR("Corrupt puzzle pool record at offset " << offset << " in "
+                                                        << path_);
+      break;
+    }
+
+    std::string label((const char *)data_ + offset + 5, label_len);
+    int width = data_[payload + 4];
+    int height = data_[payload + 5];
+    Record rec{payload, payload_size};
+    index_[Key(label, width, height)].push_back(rec);
+    index_[Key(label, 0, 0)].push_back(rec);
+    num_records_++;
+    offset = end;
+  }
+  indexed_end_ = offset;
+}
+
+} // namespace kakuro
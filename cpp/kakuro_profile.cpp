@@ -0,0 +1,174 @@
+#include "kakuro_cpp.h"
+#include <cstring>
+
+namespace kakuro {
+
+namespace {
+
+inline int highest_bit_index(uint64_t bits) {
+#ifdef _MSC_VER
+  unsigned long idx;
+  _BitScanReverse64(&idx, bits);
+  return (int)idx;
+#else
+  return 63 - __builtin_clzll(bits);
+#endif
+}
+
+// Per-thread counters. Only the owning thread adds to them; summary() and
+// reset() read and clear them from other threads, hence the atomics.
+struct ScopeSlot {
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> total_ns{0};
+  std::atomic<uint64_t> min_ns{UINT64_MAX};
+  std::atomic<uint64_t> max_ns{0};
+  std::array<std::atomic<uint64_t>, PROFILE_BUCKETS> buckets{};
+
+  void clear() {
+    count.store(0, std::memory_order_relaxed);
+    total_ns.store(0, std::memory_order_relaxed);
+    min_ns.store(UINT64_MAX, std::memory_order_relaxed);
+    max_ns.store(0, std::memory_order_relaxed);
+    for (auto &b : buckets)
+      b.store(0, std::memory_order_relaxed);
+  }
+};
+
+struct ThreadProfile {
+  std::array<ScopeSlot, PROFILE_MAX_SCOPES> slots;
+};
+
+// Plain totals used while merging
+struct ScopeTotals {
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  uint64_t min_ns = UINT64_MAX;
+  uint64_t max_ns = 0;
+  std::array<uint64_t, PROFILE_BUCKETS> buckets{};
+
+  void add(const ScopeSlot &s) {
+    count += s.count.load(std::memory_order_relaxed);
+    total_ns += s.total_ns.load(std::memory_order_relaxed);
+    min_ns = std::min(min_ns, s.min_ns.load(std::memory_order_relaxed));
+    max_ns = std::max(max_ns, s.max_ns.load(std::memory_order_relaxed));
+    for (int b = 0; b < PROFILE_BUCKETS; b++)
+      buckets[b] += s.buckets[b].load(std::memory_order_relaxed);
+  }
+};
+
+struct RegistryState {
+  std::mutex mutex;
+  std::array<std::atomic<const char *>, PROFILE_MAX_SCOPES> names{};
+  int num_scopes = 0;
+  std::vector<ThreadProfile *> live;
+  std::array<ScopeTotals, PROFILE_MAX_SCOPES> retired; // Exited threads
+};
+
+// Never destroyed, so threads exiting during shutdown can still retire
+RegistryState &state() {
+  static RegistryState *s = new RegistryState();
+  return *s;
+}
+
+struct ThreadProfileHolder {
+  ThreadProfile *profile = nullptr;
+
+  ~ThreadProfileHolder() {
+    if (!profile)
+      return;
+    RegistryState &st = state();
+    std::lock_guard<std::mutex> lock(st.mutex);
+    for (int id = 0; id < st.num_scopes; id++)
+      st.retired[id].add(profile->slots[id]);
+    st.live.erase(std::find(st.live.begin(), st.live.end(), profile));
+    delete profile;
+  }
+};
+
+thread_local ThreadProfileHolder tls_profile;
+
+ThreadProfile &local_profile() {
+  if (!tls_profile.profile) {
+    auto *profile = new ThreadProfile();
+    RegistryState &st = state();
+    std::lock_guard<std::mutex> lock(st.mutex);
+    st.live.push_back(profile);
+    tls_profile.profile = profile;
+  }
+  return *tls_profile.profile;
+}
+
+} // namespace
+
+int ProfileRegistry::register_scope(const char *name) {
+  RegistryState &st = state();
+  std::lock_guard<std::mutex> lock(st.mutex);
+  // Sites sharing a name share a scope
+  for (int id = 0; id < st.num_scopes; id++) {
+    if (std::strcmp(st.names[id].load(std::memory_order_relaxed), name) == 0)
+      return id;
+  }
+  if (st.num_scopes >= PROFILE_MAX_SCOPES) {
+    LOG_ERROR("Profile scope limit reached, not timing " << name);
+    return -1;
+  }
+  st.names[st.num_scopes].store(name, std::memory_order_release);
+  return st.num_scopes++;
+}
+
+const char *ProfileRegistry::scope_name(int id) {
+  if (id < 0 || id >= PROFILE_MAX_SCOPES)
+    return "";
+  const char *name = state().names[id].load(std::memory_order_acquire);
+  return name ? name : "";
+}
+
+void ProfileRegistry::record(int id, uint64_t ns) {
+  if (id < 0)
+    return;
+  ScopeSlot &s = local_profile().slots[id];
+  s.count.fetch_add(1, std::memory_order_relaxed);
+  s.total_ns.fetch_add(ns, std::memory_order_relaxed);
+  if (ns < s.min_ns.load(std::memory_order_relaxed))
+    s.min_ns.store(ns, std::memory_order_relaxed);
+  if (ns > s.max_ns.load(std::memory_order_relaxed))
+    s.max_ns.store(ns, std::memory_order_relaxed);
+  int bucket = ns ? std::min(highest_bit_index(ns), PROFILE_BUCKETS - 1) : 0;
+  s.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<ProfileScopeStats> ProfileRegistry::summary() {
+  RegistryState &st = state();
+  std::lock_guard<std::mutex> lock(st.mutex);
+
+  std::vector<ProfileScopeStats> result;
+  for (int id = 0; id < st.num_scopes; id++) {
+    ScopeTotals totals = st.retired[id];
+    for (ThreadProfile *profile : st.live)
+      totals.add(profile->slots[id]);
+    if (totals.count == 0)
+      continue;
+
+    ProfileScopeStats stats;
+    stats.name = st.names[id].load(std::memory_order_relaxed);
+    stats.count = totals.count;
+    stats.total_ms = totals.total_ns / 1e6;
+    stats.min_ms = totals.min_ns / 1e6;
+    stats.max_ms = totals.max_ns / 1e6;
+    stats.histogram = totals.buckets;
+    result.push_back(std::move(stats));
+  }
+  return result;
+}
+
+void ProfileRegistry::reset() {
+  RegistryState &st = state();
+  std::lock_guard<std::mutex> lock(st.mutex);
+  for (int id = 0; id < st.num_scopes; id++) {
+    st.retired[id] = ScopeTotals();
+    for (ThreadProfile *profile : st.live)
+      profile->slots[id].clear();
+  }
+}
+
+} // namespace kakuro
@@ -0,0 +1,320 @@
+#include "kakuro_cpp.h"
+
+// Set to 0 from the build to always use the scalar loops
+#ifndef KAKURO_ENABLE_SIMD
+#define KAKURO_ENABLE_SIMD 1
+#endif
+
+// Android x86 images get the scalar loops; arm64 always has NEON
+#if KAKURO_ENABLE_SIMD && !defined(__ANDROID__) &&                            \
+    (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||            \
+     defined(_M_IX86))
+#define KAKURO_SECTOR_AVX2 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define KAKURO_TARGET_AVX2
+#else
+#define KAKURO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#if KAKURO_ENABLE_SIMD && defined(__aarch64__)
+#define KAKURO_SECTOR_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace kakuro {
+
+namespace {
+
+// ----------------------------------------------------------------------------
+// Scalar
+// ----------------------------------------------------------------------------
+
+int lowest_digit(uint16_t mask) { return mask ? lowest_bit_index(mask) : 10; }
+
+int highest_digit(uint16_t mask) {
+  int d = 9;
+  while (d > 0 && !(mask & (1 << d)))
+    d--;
+  return d;
+}
+
+// Digits lo..hi, clamped to 1..9
+uint16_t digit_range(int lo, int hi) {
+  lo = std::max(lo, 1);
+  hi = std::min(hi, 9);
+  if (lo > hi)
+    return 0;
+  return (uint16_t)(((1 << (hi + 1)) - 1) & ~((1 << lo) - 1));
+}
+
+SectorSummary summarize_scalar(const SectorMasks &masks) {
+  SectorSummary summary;
+  for (int i = 0; i < masks.size; i++) {
+    uint16_t mask = masks.mask[i];
+    if (mask && !(mask & (mask - 1))) {
+      summary.singles |= mask;
+      summary.single_count++;
+    }
+    summary.min_sum += lowest_digit(mask);
+    summary.max_sum += highest_digit(mask);
+  }
+  return summary;
+}
+
+void bound_to_sum_scalar(SectorMasks &masks, int target,
+                         const SectorSummary &summary) {
+  for (int i = 0; i < masks.size; i++) {
+    uint16_t mask = masks.mask[i];
+    masks.mask[i] &=
+        digit_range(target - (summary.max_sum - highest_digit(mask)),
+                    target - (summary.min_sum - lowest_digit(mask)));
+  }
+}
+
+void remove_from_open_scalar(SectorMasks &masks, uint16_t digits) {
+  for (int i = 0; i < masks.size; i++) {
+    uint16_t mask = masks.mask[i];
+    if (mask & (mask - 1))
+      masks.mask[i] = mask & ~digits;
+  }
+}
+
+const SectorKernel SCALAR_KERNEL = {"scalar", summarize_scalar,
+                                    bound_to_sum_scalar,
+                                    remove_from_open_scalar};
+
+// ----------------------------------------------------------------------------
+// AVX2: all 16 lanes in one register
+// ----------------------------------------------------------------------------
+#ifdef KAKURO_SECTOR_AVX2
+
+KAKURO_TARGET_AVX2 __m256i load_avx2(const SectorMasks &masks) {
+  return _mm256_load_si256((const __m256i *)masks.mask.data());
+}
+
+KAKURO_TARGET_AVX2 __m256i popcount_avx2(__m256i x) {
+  const __m256i nibble_bits =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1,
+                       2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+  __m256i bytes = _mm256_add_epi8(
+      _mm256_shuffle_epi8(nibble_bits, _mm256_and_si256(x, low_nibble)),
+      _mm256_shuffle_epi8(nibble_bits,
+                          _mm256_and_si256(_mm256_srli_epi16(x, 4), low_nibble)));
+  return _mm256_add_epi16(_mm256_and_si256(bytes, _mm256_set1_epi16(0xFF)),
+                          _mm256_srli_epi16(bytes, 8));
+}
+
+// Lane i is all ones where (x & (x - 1)) == 0, i.e. at most one candidate
+KAKURO_TARGET_AVX2 __m256i at_most_one_avx2(__m256i x) {
+  return _mm256_cmpeq_epi16(
+      _mm256_and_si256(x, _mm256_sub_epi16(x, _mm256_set1_epi16(1))),
+      _mm256_setzero_si256());
+}
+
+KAKURO_TARGET_AVX2 __m256i lowest_digit_avx2(__m256i x) {
+  __m256i low = _mm256_and_si256(x, _mm256_sub_epi16(_mm256_setzero_si256(), x));
+  __m256i index = popcount_avx2(_mm256_sub_epi16(low, _mm256_set1_epi16(1)));
+  __m256i empty = _mm256_cmpeq_epi16(x, _mm256_setzero_si256());
+  return _mm256_blendv_epi8(index, _mm256_set1_epi16(10), empty);
+}
+
+KAKURO_TARGET_AVX2 __m256i highest_digit_avx2(__m256i x) {
+  x = _mm256_or_si256(x, _mm256_srli_epi16(x, 1));
+  x = _mm256_or_si256(x, _mm256_srli_epi16(x, 2));
+  x = _mm256_or_si256(x, _mm256_srli_epi16(x, 4));
+  x = _mm256_or_si256(x, _mm256_srli_epi16(x, 8));
+  __m256i index = _mm256_sub_epi16(popcount_avx2(x), _mm256_set1_epi16(1));
+  return _mm256_max_epi16(index, _mm256_setzero_si256());
+}
+
+KAKURO_TARGET_AVX2 int sum_lanes_avx2(__m256i x) {
+  __m256i pairs = _mm256_madd_epi16(x, _mm256_set1_epi16(1));
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(pairs),
+                              _mm256_extracti128_si256(pairs, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+  return _mm_cvtsi128_si32(sum);
+}
+
+KAKURO_TARGET_AVX2 uint16_t or_lanes_avx2(__m256i x) {
+  __m128i acc = _mm_or_si128(_mm256_castsi256_si128(x),
+                             _mm256_extracti128_si256(x, 1));
+  acc = _mm_or_si128(acc, _mm_srli_si128(acc, 8));
+  acc = _mm_or_si128(acc, _mm_srli_si128(acc, 4));
+  acc = _mm_or_si128(acc, _mm_srli_si128(acc, 2));
+  return (uint16_t)_mm_cvtsi128_si32(acc);
+}
+
+KAKURO_TARGET_AVX2 SectorSummary summarize_avx2(const SectorMasks &masks) {
+  __m256i x = load_avx2(masks);
+  __m256i lanes = _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+                                    13, 14, 15);
+  __m256i in_sector = _mm256_cmpgt_epi16(_mm256_set1_epi16((short)masks.size),
+                                         lanes);
+  __m256i single = _mm256_andnot_si256(
+      _mm256_cmpeq_epi16(x, _mm256_setzero_si256()), at_most_one_avx2(x));
+
+  SectorSummary summary;
+  summary.singles = or_lanes_avx2(_mm256_and_si256(x, single));
+  summary.single_count = popcount64((uint32_t)_mm256_movemask_epi8(single)) / 2;
+  summary.min_sum =
+      sum_lanes_avx2(_mm256_and_si256(lowest_digit_avx2(x), in_sector));
+  summary.max_sum = sum_lanes_avx2(highest_digit_avx2(x));
+  return summary;
+}
+
+KAKURO_TARGET_AVX2 void bound_to_sum_avx2(SectorMasks &masks, int target,
+                                          const SectorSummary &summary) {
+  __m256i x = load_avx2(masks);
+  __m256i first = _mm256_add_epi16(
+      _mm256_set1_epi16((short)(target - summary.max_sum)), highest_digit_avx2(x));
+  __m256i last = _mm256_add_epi16(
+      _mm256_set1_epi16((short)(target - summary.min_sum)), lowest_digit_avx2(x));
+  __m256i allowed = _mm256_setzero_si256();
+  for (int d = 1; d <= 9; d++) {
+    __m256i digit = _mm256_set1_epi16((short)d);
+    __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi16(first, digit),
+                                      _mm256_cmpgt_epi16(digit, last));
+    allowed = _mm256_or_si256(
+        allowed, _mm256_andnot_si256(outside, _mm256_set1_epi16((short)(1 << d))));
+  }
+  _mm256_store_si256((__m256i *)masks.mask.data(), _mm256_and_si256(x, allowed));
+}
+
+KAKURO_TARGET_AVX2 void remove_from_open_avx2(SectorMasks &masks,
+                                              uint16_t digits) {
+  __m256i x = load_avx2(masks);
+  __m256i drop = _mm256_andnot_si256(at_most_one_avx2(x),
+                                     _mm256_set1_epi16((short)digits));
+  _mm256_store_si256((__m256i *)masks.mask.data(), _mm256_andnot_si256(drop, x));
+}
+
+const SectorKernel AVX2_KERNEL = {"avx2", summarize_avx2, bound_to_sum_avx2,
+                                  remove_from_open_avx2};
+
+bool cpu_has_avx2() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+                      (_xgetbv(0) & 0x6) == 0x6;
+  __cpuidex(info, 7, 0);
+  return os_saves_ymm && (info[1] & (1 << 5));
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // KAKURO_SECTOR_AVX2
+
+// ----------------------------------------------------------------------------
+// NEON: 16 lanes as two 8-lane halves
+// ----------------------------------------------------------------------------
+#ifdef KAKURO_SECTOR_NEON
+
+uint16x8_t popcount_neon(uint16x8_t x) {
+  return vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u16(x)));
+}
+
+uint16x8_t at_most_one_neon(uint16x8_t x) {
+  return vceqq_u16(vandq_u16(x, vsubq_u16(x, vdupq_n_u16(1))), vdupq_n_u16(0));
+}
+
+uint16x8_t lowest_digit_neon(uint16x8_t x) {
+  uint16x8_t low = vandq_u16(x, vsubq_u16(vdupq_n_u16(0), x));
+  uint16x8_t index = popcount_neon(vsubq_u16(low, vdupq_n_u16(1)));
+  return vbslq_u16(vceqq_u16(x, vdupq_n_u16(0)), vdupq_n_u16(10), index);
+}
+
+// 15 - clz saturates to 0 for an empty mask
+uint16x8_t highest_digit_neon(uint16x8_t x) {
+  return vqsubq_u16(vdupq_n_u16(15), vclzq_u16(x));
+}
+
+uint16x8_t in_sector_neon(int size, int first_lane) {
+  static const uint16_t LANE_INDEX[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+  return vcltq_u16(vaddq_u16(vld1q_u16(LANE_INDEX), vdupq_n_u16(first_lane)),
+                   vdupq_n_u16((uint16_t)size));
+}
+
+SectorSummary summarize_neon(const SectorMasks &masks) {
+  SectorSummary summary;
+  uint16x8_t singles = vdupq_n_u16(0);
+  uint16x8_t count = vdupq_n_u16(0), min_sum = vdupq_n_u16(0),
+             max_sum = vdupq_n_u16(0);
+  for (int half = 0; half < 2; half++) {
+    uint16x8_t x = vld1q_u16(masks.mask.data() + half * 8);
+    uint16x8_t single = vbicq_u16(at_most_one_neon(x), vceqq_u16(x, vdupq_n_u16(0)));
+    singles = vorrq_u16(singles, vandq_u16(x, single));
+    count = vaddq_u16(count, vandq_u16(single, vdupq_n_u16(1)));
+    min_sum = vaddq_u16(min_sum, vandq_u16(lowest_digit_neon(x),
+                                           in_sector_neon(masks.size, half * 8)));
+    max_sum = vaddq_u16(max_sum, highest_digit_neon(x));
+  }
+  singles = vorrq_u16(singles, vextq_u16(singles, singles, 4));
+  singles = vorrq_u16(singles, vextq_u16(singles, singles, 2));
+  singles = vorrq_u16(singles, vextq_u16(singles, singles, 1));
+  summary.singles = vgetq_lane_u16(singles, 0);
+  summary.single_count = vaddvq_u16(count);
+  summary.min_sum = vaddvq_u16(min_sum);
+  summary.max_sum = vaddvq_u16(max_sum);
+  return summary;
+}
+
+void bound_to_sum_neon(SectorMasks &masks, int target,
+                       const SectorSummary &summary) {
+  int16x8_t first_base = vdupq_n_s16((int16_t)(target - summary.max_sum));
+  int16x8_t last_base = vdupq_n_s16((int16_t)(target - summary.min_sum));
+  for (int half = 0; half < 2; half++) {
+    uint16x8_t x = vld1q_u16(masks.mask.data() + half * 8);
+    int16x8_t first =
+        vaddq_s16(first_base, vreinterpretq_s16_u16(highest_digit_neon(x)));
+    int16x8_t last =
+        vaddq_s16(last_base, vreinterpretq_s16_u16(lowest_digit_neon(x)));
+    uint16x8_t allowed = vdupq_n_u16(0);
+    for (int d = 1; d <= 9; d++) {
+      int16x8_t digit = vdupq_n_s16((int16_t)d);
+      uint16x8_t inside = vandq_u16(vcleq_s16(first, digit), vcleq_s16(digit, last));
+      allowed = vorrq_u16(allowed, vandq_u16(inside, vdupq_n_u16((uint16_t)(1 << d))));
+    }
+    vst1q_u16(masks.mask.data() + half * 8, vandq_u16(x, allowed));
+  }
+}
+
+void remove_from_open_neon(SectorMasks &masks, uint16_t digits) {
+  for (int half = 0; half < 2; half++) {
+    uint16x8_t x = vld1q_u16(masks.mask.data() + half * 8);
+    uint16x8_t drop = vbicq_u16(vdupq_n_u16(digits), at_most_one_neon(x));
+    vst1q_u16(masks.mask.data() + half * 8, vbicq_u16(x, drop));
+  }
+}
+
+const SectorKernel NEON_KERNEL = {"neon", summarize_neon, bound_to_sum_neon,
+                                  remove_from_open_neon};
+
+#endif // KAKURO_SECTOR_NEON
+
+const SectorKernel &pick_sector_kernel() {
+#if defined(KAKURO_SECTOR_AVX2)
+  if (cpu_has_avx2())
+    return AVX2_KERNEL;
+#elif defined(KAKURO_SECTOR_NEON)
+  return NEON_KERNEL;
+#endif
+  return SCALAR_KERNEL;
+}
+
+} // namespace
+
+const SectorKernel &sector_kernel() {
+  static const SectorKernel &kernel = pick_sector_kernel();
+  return kernel;
+}
+
+} // namespace kakuro
@@ -3,31 +3,62 @@
 #include <iostream>
 #include <map>
 #include <numeric>
+#include <mutex>
 #include <queue>
+#include <thread>
 
 namespace kakuro {
 
+namespace {
+
+// Tier a fill difficulty aims for, or 0 for names without one
+int target_tier(const std::string &difficulty) {
+  if (difficulty == "very_easy")
+    return (int)TechniqueTier::VERY_EASY;
+  if (difficulty == "easy")
+    return (int)TechniqueTier::EASY;
+  if (difficulty == "medium")
+    return (int)TechniqueTier::MEDIUM;
+  if (difficulty == "hard")
+    return (int)TechniqueTier::HARD;
+  if (difficulty == "extreme")
+    return (int)TechniqueTier::EXTREME;
+  return 0;
+}
+
+} // namespace
+
 CSPSolver::CSPSolver(std::shared_ptr<KakuroBoard> b)
-    : board(b), rng(std::random_device{}()) {}
+    : CSPSolver(b, std::random_device{}()) {}
+
+CSPSolver::CSPSolver(std::shared_ptr<KakuroBoard> b, uint32_t seed)
+    : board(b), rng(seed) {}
 
 bool CSPSolver::check_timeout() {
-  auto now = std::chrono::steady_clock::now();
-  std::chrono::duration<double> elapsed = now - start_time_;
-  if (elapsed.count() > time_limit_sec_) {
-    LOG_ERROR("=== TIMEOUT: Generation exceeded "
-              << time_limit_sec_ << " seconds. Terminating. ===");
+  // Outside generate_puzzle (e.g. a direct solve_fill) only the caller's
+  // budget applies
+  const auto &budget = budget_ ? budget_ : user_budget_;
+  if (!budget || !budget->expired())
+    return false;
+
+  std::string reason;
+  if (budget->is_cancelled()) {
+    LOG_DEBUG("Generation cancelled");
+    reason = "Generation cancelled";
+  } else {
+    LOG_ERROR("=== TIMEOUT: Generation exceeded its time budget (limit "
+              << time_limit_sec_ << " seconds). Terminating. ===");
+    reason = "Timeout exceeded " + std::to_string(time_limit_sec_) + "s";
+  }
 #if KAKURO_ENABLE_LOGGING
-    if (board->logger->is_enabled()) {
-      board->logger->log_step(
-          GenerationLogger::STAGE_FILLING, GenerationLogger::SUBSTAGE_FAILED,
-          "Timeout exceeded " + std::to_string(time_limit_sec_) + "s",
-          board->get_grid_state());
-      board->logger->close();
-    }
-#endif
-    return true;
+  if (board->logger->is_enabled()) {
+    board->logger->log_step(GenerationLogger::STAGE_FILLING,
+                            GenerationLogger::SUBSTAGE_FAILED, reason,
+                            *board);
+    board->logger->close();
   }
-  return false;
+#endif
+  return true;
 }
 
 void CSPSolver::apply_fill_defaults(FillParams &params) {
@@ -79,9 +110,9 @@ bool CSPSolver::generate_puzzle(const std::string &difficulty) {
   fill_params.difficulty = difficulty;
   apply_fill_defaults(fill_params);
 
+  // Defaults are resolved there, after the topology pool has keyed them
   TopologyParams topo_params;
   topo_params.difficulty = difficulty;
-  board->apply_topology_defaults(topo_params);
 
   return generate_puzzle(fill_params, topo_params);
 }
@@ -94,8 +125,13 @@ bool CSPSolver::generate_puzzle(const FillParams &params_f,
 
   apply_fill_defaults(params);
   board->apply_topology_defaults(topo_params);
-  // Reset Timer at start of generation
-  start_time_ = std::chrono::steady_clock::now();
+  // The time limit starts now and never outlasts the caller's budget
+  budget_ = user_budget_ ? user_budget_->child(time_limit_sec_)
+                         : GenerationBudget::create(time_limit_sec_);
+  board->budget = budget_;
+  stats_ = GenerationStats();
+  difficulty_ = DifficultyResult();
+  StageTimer total_timer(stats_.total_ms);
 
 #if KAKURO_ENABLE_LOGGING
   if (board->logger) {
@@ -113,14 +149,33 @@ bool CSPSolver::generate_puzzle(const FillParams &params_f,
        topo_attempt++) {
     if (check_timeout())
       return false;
-    if (!prepare_new_topology(topo_params))
+    stats_.topology_attempts++;
+    // Pooled topologies are keyed by the caller's params, before defaults
+    bool pooled = false;
+    uint64_t topology_hash = 0;
+    bool topology_ok;
+    {
+      StageTimer timer(stats_.topology_ms);
+      pooled = topology_pool_ &&
+               topology_pool_->acquire(*board, topo_params_t, topology_hash);
+      topology_ok = pooled || prepare_new_topology(topo_params);
+    }
+    if (pooled)
+      stats_.pooled_topologies++;
+    if (!topology_ok)
       continue;
 
-    if (attempt_fill_and_validate(params)) {
+    bool filled = fill_portfolio_ > 1 ? attempt_fill_portfolio(params)
+                                      : attempt_fill_and_validate(params);
+    // A search cut short by the budget says nothing about the topology
+    if (!filled && pooled && !budget_->expired())
+      topology_pool_->evict(board->width, board->height, topo_params_t,
+                            topology_hash);
+    if (filled) {
 #if KAKURO_ENABLE_LOGGING
       board->logger->log_step(
           GenerationLogger::STAGE_FILLING, GenerationLogger::SUBSTAGE_COMPLETE,
-          "Puzzle generation successful", board->get_grid_state());
+          "Puzzle generation successful", *board);
       board->logger->close();
 #endif
       return true;
@@ -133,7 +188,7 @@ bool CSPSolver::generate_puzzle(const FillParams &params_f,
 #if KAKURO_ENABLE_LOGGING
   board->logger->log_step(
       GenerationLogger::STAGE_FILLING, GenerationLogger::SUBSTAGE_FAILED,
-      "Puzzle generation failed after max retries", board->get_grid_state());
+      "Puzzle generation failed after max retries", *board);
   board->logger->close();
 #endif
   return false;
@@ -149,7 +204,7 @@ GeneratedPuzzle CSPSolver::generate_random_puzzle() {
 
   int w = dist_w(rng);
   int h = dist_h(rng);
-  board = std::make_shared<KakuroBoard>(w, h);
+  board = std::make_shared<KakuroBoard>(w, h, rng());
   int area = (w - 2) * (h - 2);
 
   TopologyParams topo;
@@ -182,33 +237,187 @@ GeneratedPuzzle CSPSolver::generate_random_puzzle() {
   else
     fill.partition_preference = "unique";
 
+  // generate_puzzle() resets stats_ per call; sum them over the retries
+  GenerationStats total;
   for (int retry = 0; retry < 5; retry++) {
-    if (generate_puzzle(fill, topo)) {
-      KakuroDifficultyEstimator estimator(board);
-      GeneratedPuzzle res;
-      res.difficulty = estimator.estimate_difficulty_detailed();
-      res.width = board->width;
-      res.height = board->height;
-
-      res.grid.resize(h, std::vector<PuzzleCell>(w));
-      for (int r = 0; r < h; r++) {
-        for (int c = 0; c < w; c++) {
-          auto &src = board->grid[r][c];
-          auto &dst = res.grid[r][c];
-          dst.type = src.type;
-          dst.clue_h = src.clue_h;
-          dst.clue_v = src.clue_v;
-          dst.solution = src.value;
-        }
-      }
+    bool ok = generate_puzzle(fill, topo);
+    total.merge(stats_);
+    total.total_ms += stats_.total_ms;
+    if (ok) {
+      stats_ = total;
+      GeneratedPuzzle res = make_generated_puzzle(*board, difficulty_);
+      res.stats = total;
       return res;
     }
+    if (user_budget_ && user_budget_->expired())
+      break;
     // retry with more density
     topo.density = std::min(0.75, *topo.density + 0.05);
     topo.num_stamps = (int)(*topo.num_stamps * 1.2);
   }
 
-  return GeneratedPuzzle();
+  stats_ = total;
+  GeneratedPuzzle res;
+  res.stats = total;
+  return res;
+}
+
+GeneratedPuzzle make_generated_puzzle(const KakuroBoard &board,
+                                      DifficultyResult difficulty) {
+  GeneratedPuzzle res;
+  res.difficulty = std::move(difficulty);
+  res.width = board.width;
+  res.height = board.height;
+
+  res.grid.resize(board.height, std::vector<PuzzleCell>(board.width));
+  for (int r = 0; r < board.height; r++) {
+    for (int c = 0; c < board.width; c++) {
+      auto &src = board.grid[r][c];
+      auto &dst = res.grid[r][c];
+      dst.type = src.type;
+      dst.clue_h = src.clue_h;
+      dst.clue_v = src.clue_v;
+      dst.solution = src.value;
+    }
+  }
+  return res;
+}
+
+namespace {
+
+// transform_puzzle without the estimator: `out` carries the difficulty over.
+// Returns the variant's board, or null if the transform is invalid.
+std::shared_ptr<KakuroBoard> build_variant(const GeneratedPuzzle &puzzle,
+                                           const PuzzleTransform &transform,
+                                           GeneratedPuzzle &out) {
+  int width = transform.transpose ? puzzle.height : puzzle.width;
+  int height = transform.transpose ? puzzle.width : puzzle.height;
+  // Source row and column of cell (r, c) of the variant
+  auto source = [&](int r, int c) {
+    int sr = transform.mirror_rows ? height - 1 - r : r;
+    int sc = transform.mirror_cols ? width - 1 - c : c;
+    return transform.transpose ? std::make_pair(sc, sr)
+                               : std::make_pair(sr, sc);
+  };
+  auto board = std::make_shared<KakuroBoard>(width, height, 0);
+  for (int r = 0; r < height; r++) {
+    for (int c = 0; c < width; c++) {
+      auto [sr, sc] = source(r, c);
+      const PuzzleCell &src = puzzle.grid[sr][sc];
+      Cell &dst = board->grid[r][c];
+      dst.type = src.type;
+      if (src.type != CellType::WHITE)
+        continue;
+      if (!src.solution)
+        return nullptr;
+      dst.value = transform.complement ? 10 - *src.solution : *src.solution;
+    }
+  }
+  board->collect_white_cells();
+  // calculate_clues writes each clue left of / above its run
+  if (!board->validate_clue_headers())
+    return nullptr;
+  CSPSolver solver(board, 0);
+  solver.calculate_clues();
+
+  // Carried over solutions are grids of the original puzzle
+  DifficultyResult difficulty = puzzle.difficulty;
+  for (auto &grid : difficulty.solutions) {
+    std::vector<std::vector<std::optional<int>>> mapped(
+        height, std::vector<std::optional<int>>(width));
+    for (int r = 0; r < height; r++) {
+      for (int c = 0; c < width; c++) {
+        auto [sr, sc] = source(r, c);
+        std::optional<int> v = grid[sr][sc];
+        if (v && transform.complement)
+          v = 10 - *v;
+        mapped[r][c] = v;
+      }
+    }
+    grid = std::move(mapped);
+  }
+  // The variant cost nothing to generate, so its stats only hold the
+  // estimator run if there is one
+  out = make_generated_puzzle(*board, std::move(difficulty));
+  return board;
+}
+
+void reestimate_variant(const std::shared_ptr<KakuroBoard> &board,
+                        GeneratedPuzzle &variant) {
+  variant.stats = GenerationStats();
+  StageTimer timer(variant.stats.difficulty_ms);
+  StageTimer total_timer(variant.stats.total_ms);
+  KakuroDifficultyEstimator estimator(board);
+  variant.difficulty = estimator.estimate_difficulty_detailed();
+  variant.stats.estimator_nodes += estimator.get_nodes_explored();
+}
+
+} // namespace
+
+bool transform_puzzle(const GeneratedPuzzle &puzzle,
+                      const PuzzleTransform &transform, GeneratedPuzzle &out,
+                      bool reestimate) {
+  auto board = build_variant(puzzle, transform, out);
+  if (!board)
+    return false;
+  if (reestimate)
+    reestimate_variant(board, out);
+  return true;
+}
+
+std::vector<GeneratedPuzzle> puzzle_variants(const GeneratedPuzzle &puzzle,
+                                             int max_variants,
+                                             bool reestimate) {
+  // {transpose, mirror_cols, mirror_rows, complement}
+  static const PuzzleTransform ORDER[] = {
+      {false, false, false, true}, // Complement
+      {true, false, false, false}, // Transpose
+      {true, false, false, true},
+      {false, true, true, false}, // Rotate 180
+      {false, true, true, true},
+      {true, true, true, false}, // Anti-transpose
+      {true, true, true, true},
+      {false, true, false, false}, // Mirror
+      {false, true, false, true},
+      {false, false, true, false},
+      {false, false, true, true},
+      {true, true, false, false}, // Rotate 90
+      {true, true, false, true},
+      {true, false, true, false},
+      {true, false, true, true},
+  };
+  // Clues follow from the types and solutions
+  auto same_grid = [](const GeneratedPuzzle &a, const GeneratedPuzzle &b) {
+    if (a.width != b.width || a.height != b.height)
+      return false;
+    for (int r = 0; r < a.height; r++) {
+      for (int c = 0; c < a.width; c++) {
+        if (a.grid[r][c].type != b.grid[r][c].type ||
+            a.grid[r][c].solution != b.grid[r][c].solution)
+          return false;
+      }
+    }
+    return true;
+  };
+
+  std::vector<GeneratedPuzzle> variants;
+  for (const PuzzleTransform &transform : ORDER) {
+    if ((int)variants.size() >= max_variants)
+      break;
+    GeneratedPuzzle variant;
+    auto board = build_variant(puzzle, transform, variant);
+    if (!board)
+      continue;
+    // Symmetric grids map onto themselves or an earlier variant
+    if (same_grid(variant, puzzle) ||
+        std::any_of(variants.begin(), variants.end(),
+                    [&](const GeneratedPuzzle &v) { return same_grid(v, variant); }))
+      continue;
+    if (reestimate)
+      reestimate_variant(board, variant);
+    variants.push_back(std::move(variant));
+  }
+  return variants;
 }
 
 bool CSPSolver::prepare_new_topology(const TopologyParams &topo_params) {
@@ -227,51 +436,108 @@ bool CSPSolver::attempt_fill_and_validate(const FillParams &params) {
   int consecutive_repair_failures = 0;
   int fills_for_this_topology = 0;
 
-  std::vector<ValueConstraint> cumulative_constraints;
+  // What earlier fills of this topology taught us, see NogoodStore
+  NogoodStore nogoods;
+  nogoods.reset((int)board->white_cells.size());
 
   for (int fill_attempt = 0;
        fill_attempt < MAX_FILL_ATTEMPTS * MAX_REPAIR_ATTEMPTS; fill_attempt++) {
 
     // Check timeout inside fill loop
-    if (check_timeout())
+    if (check_timeout() || is_cancelled())
       return false;
 
     board->reset_values();
-
-    // 1. Fill the board with values
-    // NEW: Pass the cumulative_constraints to the solver
-    if (!solve_fill(params, {}, cumulative_constraints, true)) {
-      // If filling failed completely with these constraints, we might have
-      // over-constrained it. Clear constraints to allow a fresh start on this
-      // topology.
-      if (!cumulative_constraints.empty()) {
+    stats_.fill_attempts++;
+
+    // 1. Fill the board with values, avoiding the learned nogoods
+    bool fill_ok;
+    {
+      StageTimer timer(stats_.fill_ms);
+      fill_ok = solve_fill(params, {}, nogoods, true);
+      if (fill_ok)
+        calculate_clues(); // 2. Sync clues to the filled values
+    }
+    if (!fill_ok) {
+      stats_.failed_fills++;
+      // If filling failed under the heuristic forbids, we might have
+      // over-constrained it. Drop them (and what was derived from them) but
+      // keep the nogoods that hold for any fill of this topology.
+      if (nogoods.has_soft()) {
         LOG_DEBUG(
             "  Fill failed with constraints. Clearing learned constraints.");
-        cumulative_constraints.clear();
+        nogoods.clear_soft();
         continue;
       }
       // If it failed without constraints, this topology might be bad.
       continue;
     }
 
-    // 2. Sync clues to the filled values
-    calculate_clues();
-
-    if (has_high_global_ambiguity()) {
+    bool ambiguous;
+    {
+      StageTimer timer(stats_.fill_ms);
+      ambiguous = has_high_global_ambiguity();
+    }
+    if (ambiguous) {
+      stats_.rejected_ambiguity++;
       LOG_DEBUG("  Rejecting fill: high global ambiguity detected");
       continue;
     }
 
-    // 3. Robust Uniqueness Check (The "Multi-Check")
-    auto [result, alt_sol_opt] = perform_robust_uniqueness_check();
+    // 3. Prefilter: the techniques alone give the rating the estimator will
+    // report, and a short search finds the second solution of most ambiguous
+    // fills. The estimator keeps its logic phase for the final estimate.
+    KakuroDifficultyEstimator estimator(board);
+    estimator.set_budget(budget_);
+    int tier_gap = 0;
+    {
+      StageTimer timer(stats_.prefilter_ms);
+      KakuroDifficultyEstimator::LogicProbe probe = estimator.probe_logic();
+      int target = target_tier(params.difficulty);
+      if (target)
+        tier_gap = std::abs((int)probe.max_tier - target);
+    }
+    if (tier_gap >= PREFILTER_TIER_GAP) {
+      stats_.rejected_tier++;
+      LOG_DEBUG("  Rejecting fill: logic rating is " << tier_gap
+                                                    << " tiers from "
+                                                    << params.difficulty);
+      continue;
+    }
+
+    UniquenessResult result;
+    std::optional<std::unordered_map<std::pair<int, int>, int, PairHash>>
+        alt_sol_opt;
+    std::unordered_map<std::pair<int, int>, int, PairHash> alternative;
+    bool refuted;
+    {
+      StageTimer timer(stats_.prefilter_ms);
+      refuted = estimator.find_alternative(PREFILTER_NODES, alternative);
+      stats_.prefilter_nodes += estimator.get_alternative_nodes();
+    }
+    if (refuted) {
+      LOG_DEBUG("  Prefilter found a second solution");
+      result = UniquenessResult::MULTIPLE;
+      alt_sol_opt = std::move(alternative);
+    } else {
+      // 4. Robust Uniqueness Check (The "Multi-Check") on the survivors
+      StageTimer timer(stats_.uniqueness_ms);
+      std::tie(result, alt_sol_opt) = perform_robust_uniqueness_check();
+    }
 
     if (result == UniquenessResult::UNIQUE) {
       // Final check with Estimator to ensure it meets difficulty targets
-      KakuroDifficultyEstimator estimator(board);
-      DifficultyResult diff = estimator.estimate_difficulty_detailed();
+      DifficultyResult diff;
+      {
+        StageTimer timer(stats_.difficulty_ms);
+        diff = estimator.estimate_difficulty_detailed();
+        stats_.estimator_nodes += estimator.get_nodes_explored();
+      }
 
       if (diff.solution_count == 1) {
         LOG_DEBUG("=== SUCCESS! Unique " << diff.rating << " puzzle ===");
+        // Kept for the caller instead of estimating the same board again
+        difficulty_ = std::move(diff);
         return true;
       }
       
@@ -318,32 +584,40 @@ bool CSPSolver::attempt_fill_and_validate(const FillParams &params) {
                   board->logger->log_step(
                       GenerationLogger::STAGE_FILLING, "uniqueness_conflict",
                       "Estimator rejected uniqueness (found " + std::to_string(diff.solution_count) + " solutions)",
-                      board->get_grid_state());
+                      *board);
               }
           } else {
               board->logger->log_step(
                   GenerationLogger::STAGE_FILLING, "uniqueness_conflict",
                   "Estimator rejected uniqueness (found " + std::to_string(diff.solution_count) + " solutions)",
-                  board->get_grid_state());
+                  *board);
           }
       }
 #endif
+      stats_.rejected_estimator++;
       result = UniquenessResult::MULTIPLE;
+    } else if (refuted) {
+      stats_.rejected_refuted++;
+    } else if (result == UniquenessResult::MULTIPLE) {
+      stats_.rejected_multiple++;
+    } else {
+      stats_.rejected_inconclusive++;
     }
 
     // Check timeout after uniqueness check (expensive operation)
     if (check_timeout())
       return false;
 
-    // 4. Handle Repairs
+    // 5. Handle Repairs
     if (result == UniquenessResult::MULTIPLE) {
       fills_for_this_topology++;
 
-      // --- NEW: LEARN FROM FAILURE ---
+      // --- LEARN FROM FAILURE ---
       // If we have an alternative solution, we know that the current fill
-      // (Solution A) allowed an ambiguity (Solution B). To avoid generating
-      // Solution A again, we pick a cell where they differ and forbid Solution
-      // A's value there in the next pass.
+      // (Solution A) allowed an ambiguity (Solution B). Any fill that agrees
+      // with A on the differing cells and the rest of their sectors allows
+      // the same swap, so that partial fill is a nogood. It rarely recurs in
+      // full, so we also forbid A's value at one differing cell next pass.
       if (alt_sol_opt) {
         std::vector<Cell *> diff_cells;
         for (Cell *c : board->white_cells) {
@@ -367,7 +641,18 @@ bool CSPSolver::attempt_fill_and_validate(const FillParams &params) {
           // now."
           Cell *target = diff_cells[0];
           int bad_val = *target->value;
-          cumulative_constraints.push_back({target, {bad_val}});
+          nogoods.forbid(target->idx, bad_val, true);
+
+          std::vector<int> values(board->white_cells.size(), 0);
+          std::vector<int> swap_cells;
+          for (Cell *c : board->white_cells)
+            values[c->idx] = c->value.value_or(0);
+          for (Cell *d : diff_cells) {
+            for (SectorSpan sector : {board->h_sector(d), board->v_sector(d)})
+              for (Cell *c : sector)
+                swap_cells.push_back(c->idx);
+          }
+          nogoods.add(swap_cells, values, false);
 
           LOG_DEBUG("  Learning: Forbidding val "
                     << bad_val << " at (" << target->r << "," << target->c
@@ -412,12 +697,19 @@ bool CSPSolver::attempt_fill_and_validate(const FillParams &params) {
       }
 #endif
 
-      if (alt_sol_opt && repair_topology_robust(*alt_sol_opt)) {
+      bool repaired = false;
+      if (alt_sol_opt) {
+        stats_.repairs++;
+        StageTimer timer(stats_.repair_ms);
+        repaired = repair_topology_robust(*alt_sol_opt);
+      }
+      if (repaired) {
         // SUCCESS: The board has changed and is still valid.
         LOG_DEBUG(
             "  Repair successful. Restarting fill loop on modified topology.");
         fills_for_this_topology = 0;
-        cumulative_constraints.clear();
+        // Cell indices and sectors changed with the topology
+        nogoods.reset((int)board->white_cells.size());
         // Reset loop to start fresh on this modified board
         continue;
       } else {
@@ -436,6 +728,63 @@ bool CSPSolver::attempt_fill_and_validate(const FillParams &params) {
   return false;
 }
 
+bool CSPSolver::attempt_fill_portfolio(const FillParams &params) {
+  PROFILE_FUNCTION(board->logger);
+  const int members = fill_portfolio_;
+  // Shared by all members; the winner cancels it to stop the others
+  auto race_budget = budget_->child();
+  std::mutex winner_mutex;
+  int winner = -1;
+
+  // Every member gets its own board copy (repairs may change the topology),
+  // its own seeds and its own learned constraints. Cores left over go to
+  // each member's uniqueness search.
+  std::vector<std::unique_ptr<CSPSolver>> portfolio;
+  for (int i = 0; i < members; i++) {
+    auto copy = board->clone();
+    copy->rng.seed(rng());
+    auto member = std::make_unique<CSPSolver>(copy);
+    member->rng.seed(rng());
+    member->time_limit_sec_ = time_limit_sec_;
+    member->uniqueness_threads_ = std::max(1, uniqueness_threads_ / members);
+    member->budget_ = race_budget;
+    copy->budget = race_budget;
+    portfolio.push_back(std::move(member));
+  }
+
+  auto run_member = [&](int i) {
+    if (!portfolio[i]->attempt_fill_and_validate(params))
+      return;
+    std::lock_guard<std::mutex> lock(winner_mutex);
+    if (winner < 0) {
+      winner = i;
+      race_budget->cancel();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < members; i++)
+    threads.emplace_back(run_member, i);
+  run_member(0);
+  // Member 0 may have failed early; the others still count
+  for (auto &t : threads)
+    t.join();
+
+  // Stats add up the work of every member, not just the winner's
+  for (auto &member : portfolio)
+    stats_.merge(member->stats_);
+
+  if (winner < 0)
+    return false;
+
+  // Commit the winning fill (and any repaired topology) back to `board`
+  board->copy_cells_from(*portfolio[winner]->board);
+  difficulty_ = std::move(portfolio[winner]->difficulty_);
+  LOG_DEBUG("  Portfolio member " << winner << "/" << members
+                                  << " produced the accepted fill");
+  return true;
+}
+
 std::pair<UniquenessResult,
           std::optional<std::unordered_map<std::pair<int, int>, int, PairHash>>>
 CSPSolver::perform_robust_uniqueness_check() {
@@ -457,6 +806,219 @@ CSPSolver::perform_robust_uniqueness_check() {
   return {UniquenessResult::UNIQUE, std::nullopt};
 }
 
+void CSPSolver::FillState::init(const KakuroBoard &board) {
+  int n = (int)board.white_cells.size();
+  values.assign(n, 0);
+  base_values.assign(n, 0);
+  cell_h.assign(n, -1);
+  cell_v.assign(n, -1);
+
+  // Board sector ids, with vertical ids after the horizontal table
+  int h_capacity = board.sectors_h.capacity();
+  int num_sectors = h_capacity + board.sectors_v.capacity();
+  sector_sum.assign(num_sectors, 0);
+  sector_used.assign(num_sectors, 0);
+  sector_filled.assign(num_sectors, 0);
+  sector_len.assign(num_sectors, 0);
+
+  for (int id = 0; id < h_capacity; id++)
+    sector_len[id] = board.sectors_h.length(id);
+  for (int id = 0; id < board.sectors_v.capacity(); id++)
+    sector_len[h_capacity + id] = board.sectors_v.length(id);
+  for (Cell *c : board.white_cells) {
+    if (c->sector_h >= 0)
+      cell_h[c->idx] = c->sector_h;
+    if (c->sector_v >= 0)
+      cell_v[c->idx] = h_capacity + c->sector_v;
+  }
+
+  unassigned.assign((n + 63) / 64, 0);
+  for (int i = 0; i < n; i++)
+    unassigned[i >> 6] |= 1ULL << (i & 63);
+  num_unassigned = n;
+
+  // Values already on the board constrain their sectors until overwritten
+  for (Cell *c : board.white_cells) {
+    if (c->value.has_value()) {
+      base_values[c->idx] = *c->value;
+      place(c->idx, *c->value);
+    }
+  }
+}
+
+void CSPSolver::FillState::place(int idx, int value) {
+  values[idx] = value;
+  for (int sid : {cell_h[idx], cell_v[idx]}) {
+    if (sid < 0)
+      continue;
+    sector_sum[sid] += value;
+    sector_used[sid] |= (1 << value);
+    sector_filled[sid]++;
+  }
+}
+
+void CSPSolver::FillState::remove(int idx) {
+  int value = values[idx];
+  if (value == 0)
+    return;
+  for (int sid : {cell_h[idx], cell_v[idx]}) {
+    if (sid < 0)
+      continue;
+    sector_sum[sid] -= value;
+    sector_used[sid] &= ~(1 << value);
+    sector_filled[sid]--;
+  }
+  values[idx] = 0;
+}
+
+void CSPSolver::FillState::assign(const Cell *cell, int value) {
+  int idx = cell->idx;
+  remove(idx);
+  place(idx, value);
+  uint64_t bit = 1ULL << (idx & 63);
+  if (unassigned[idx >> 6] & bit) {
+    unassigned[idx >> 6] &= ~bit;
+    num_unassigned--;
+  }
+}
+
+void CSPSolver::FillState::unassign(const Cell *cell) {
+  int idx = cell->idx;
+  remove(idx);
+  if (base_values[idx])
+    place(idx, base_values[idx]);
+  uint64_t bit = 1ULL << (idx & 63);
+  if (!(unassigned[idx >> 6] & bit)) {
+    unassigned[idx >> 6] |= bit;
+    num_unassigned++;
+  }
+}
+
+CSPSolver::FillState::SectorView
+CSPSolver::FillState::view(int sector, const Cell *cell) const {
+  SectorView v{sector_sum[sector], sector_used[sector], sector_filled[sector],
+               sector_len[sector]};
+  int own = values[cell->idx];
+  if (own && (cell_h[cell->idx] == sector || cell_v[cell->idx] == sector)) {
+    v.sum -= own;
+    v.used &= ~(1 << own);
+    v.filled--;
+  }
+  return v;
+}
+
+void CSPSolver::NogoodStore::reset(int cell_count) {
+  hard_units_.assign(cell_count, 0);
+  soft_units_.assign(cell_count, 0);
+  nogoods_.clear();
+  watches_.assign((size_t)cell_count * 10, {});
+  assigned_.assign(cell_count, 0);
+  hashes_.clear();
+  soft_count_ = 0;
+}
+
+void CSPSolver::NogoodStore::forbid(int idx, int value, bool soft) {
+  uint16_t bit = (uint16_t)(1 << value);
+  if ((hard_units_[idx] | soft_units_[idx]) & bit)
+    return;
+  if (soft) {
+    soft_units_[idx] |= bit;
+    soft_count_++;
+  } else {
+    hard_units_[idx] |= bit;
+  }
+}
+
+bool CSPSolver::NogoodStore::add(const std::vector<int> &cells,
+                                 const std::vector<int> &values, bool soft) {
+  Nogood nogood;
+  nogood.soft = soft;
+  for (int idx : cells)
+    nogood.literals.push_back(idx * 10 + values[idx]);
+  std::sort(nogood.literals.begin(), nogood.literals.end());
+  nogood.literals.erase(
+      std::unique(nogood.literals.begin(), nogood.literals.end()),
+      nogood.literals.end());
+
+  if (nogood.literals.empty())
+    return false;
+  if (nogood.literals.size() == 1) {
+    forbid(literal_cell(nogood.literals[0]), nogood.literals[0] % 10, soft);
+    return true;
+  }
+  if ((int)nogood.literals.size() > MAX_LITERALS ||
+      (int)nogoods_.size() >= MAX_NOGOODS)
+    return false;
+
+  if (!hashes_.insert(hash(nogood.literals)).second)
+    return false;
+
+  nogoods_.push_back(std::move(nogood));
+  if (soft)
+    soft_count_++;
+  index((int)nogoods_.size() - 1);
+  return true;
+}
+
+uint64_t CSPSolver::NogoodStore::hash(const std::vector<int> &literals) {
+  uint64_t h = 1469598103934665603ULL; // FNV-1a
+  for (int lit : literals)
+    h = (h ^ (uint64_t)lit) * 1099511628211ULL;
+  return h;
+}
+
+void CSPSolver::NogoodStore::index(int id) {
+  Nogood &nogood = nogoods_[id];
+  nogood.true_count = 0;
+  for (int lit : nogood.literals) {
+    watches_[lit].push_back(id);
+    if (assigned_[literal_cell(lit)] == lit % 10)
+      nogood.true_count++;
+  }
+}
+
+void CSPSolver::NogoodStore::clear_soft() {
+  std::fill(soft_units_.begin(), soft_units_.end(), 0);
+  nogoods_.erase(std::remove_if(nogoods_.begin(), nogoods_.end(),
+                                [](const Nogood &n) { return n.soft; }),
+                 nogoods_.end());
+  for (auto &watch : watches_)
+    watch.clear();
+  hashes_.clear();
+  for (int id = 0; id < (int)nogoods_.size(); id++) {
+    hashes_.insert(hash(nogoods_[id].literals));
+    index(id);
+  }
+  soft_count_ = 0;
+}
+
+int CSPSolver::NogoodStore::violated_by(int idx, int value) const {
+  for (int id : watches_[idx * 10 + value]) {
+    const Nogood &nogood = nogoods_[id];
+    if (nogood.true_count == (int)nogood.literals.size() - 1)
+      return id;
+  }
+  return -1;
+}
+
+void CSPSolver::NogoodStore::on_assign(int idx, int value) {
+  assigned_[idx] = value;
+  for (int id : watches_[idx * 10 + value])
+    nogoods_[id].true_count++;
+}
+
+void CSPSolver::NogoodStore::on_unassign(int idx, int value) {
+  assigned_[idx] = 0;
+  for (int id : watches_[idx * 10 + value])
+    nogoods_[id].true_count--;
+}
+
+void CSPSolver::NogoodStore::clear_assignment() {
+  std::fill(assigned_.begin(), assigned_.end(), 0);
+  for (Nogood &nogood : nogoods_)
+    nogood.true_count = 0;
+}
+
 bool CSPSolver::solve_fill(
     const std::string &difficulty, int max_nodes,
     const std::unordered_map<Cell *, int> &forced_assignments,
@@ -474,40 +1036,65 @@ bool CSPSolver::solve_fill(
     const std::unordered_map<Cell *, int> &forced_assignments,
     const std::vector<ValueConstraint> &forbidden_constraints,
     bool ignore_clues) {
+  NogoodStore nogoods;
+  nogoods.reset((int)board->white_cells.size());
+  for (const auto &f : forbidden_constraints) {
+    if (f.cell->type != CellType::WHITE)
+      continue;
+    for (int f_val : f.values) {
+      if (f_val >= 1 && f_val <= 9)
+        nogoods.forbid(f.cell->idx, f_val, false);
+    }
+  }
+  return solve_fill(params, forced_assignments, nogoods, ignore_clues);
+}
+
+bool CSPSolver::solve_fill(
+    const FillParams &params,
+    const std::unordered_map<Cell *, int> &forced_assignments,
+    NogoodStore &nogoods, bool ignore_clues) {
   PROFILE_FUNCTION(board->logger);
   int max_nodes = params.max_nodes.value_or(30000);
   LOG_DEBUG("      solve_fill: difficulty="
             << params.difficulty << ", max_nodes=" << max_nodes
-            << ", ignore_clues=" << ignore_clues);
-  std::unordered_map<Cell *, int> assignment;
+            << ", ignore_clues=" << ignore_clues
+            << ", nogoods=" << nogoods.size());
+  FillState state;
+  state.init(*board);
   int node_count = 0;
 
+  int n = (int)board->white_cells.size();
+  if (nogoods.cell_count() != n) {
+    LOG_ERROR("      solve_fill: nogood store is for another topology");
+    nogoods.reset(n);
+  }
+  nogoods.clear_assignment();
+
 #if KAKURO_ENABLE_LOGGING
   if (!ignore_clues) { // Only log the main filling pass, not the helper ones
                        // usually
     board->logger->log_step(
         GenerationLogger::STAGE_FILLING, GenerationLogger::SUBSTAGE_START,
         "Starting fill solve. Max nodes: " + std::to_string(max_nodes),
-        board->get_grid_state());
+        *board);
   }
 #endif
 
   // Apply constraints
   for (auto &[cell, val] : forced_assignments) {
     if (cell->type == CellType::WHITE) {
-      for (const auto &f : forbidden_constraints) {
-        if (f.cell == cell) {
-          for (int f_val : f.values) {
-            if (val == f_val)
-              return false; // Impossible constraints
-          }
-        }
+      if (nogoods.unit_forbidden(cell->idx, val) ||
+          nogoods.violated_by(cell->idx, val) >= 0) {
+        nogoods.clear_assignment();
+        return false; // Impossible constraints
       }
 
-      if (is_consistent_number(cell, val, assignment, ignore_clues)) {
-        assignment[cell] = val;
+      if (is_consistent_number(cell, val, state, ignore_clues)) {
+        state.assign(cell, val);
+        nogoods.on_assign(cell->idx, val);
       } else {
         LOG_DEBUG("      solve_fill: Inconsistent number");
+        nogoods.clear_assignment();
         return false;
       }
     }
@@ -515,75 +1102,150 @@ bool CSPSolver::solve_fill(
   std::vector<int> weights = params.weights.value();
   std::string partition_preference = params.partition_preference.value();
 
+  FillSearch search;
+  search.nogoods = &nogoods;
+  search.words = state.unassigned.size();
+  search.conflicts.assign((n + 1) * search.words, 0);
+
   bool result =
-      backtrack_fill(assignment, node_count, max_nodes, weights, ignore_clues,
-                     partition_preference, forbidden_constraints);
+      backtrack_fill(state, search, 0, node_count, max_nodes, weights,
+                     ignore_clues, partition_preference);
+  nogoods.clear_assignment();
   LOG_DEBUG("      solve_fill result: " << (result ? "SUCCESS" : "FAIL")
-                                        << ", nodes explored: " << node_count);
+                                        << ", nodes explored: " << node_count
+                                        << ", nogoods: " << nogoods.size());
+  stats_.fill_nodes += node_count;
   return result;
 }
 
-bool CSPSolver::backtrack_fill(
-    std::unordered_map<Cell *, int> &assignment, int &node_count, int max_nodes,
-    const std::vector<int> &weights, bool ignore_clues,
-    const std::string &partition_preference,
-    const std::vector<ValueConstraint> &forbidden_constraints) {
+void CSPSolver::blame_value(Cell *var, int value, const FillState &state,
+                            const FillSearch &search, bool ignore_clues,
+                            uint64_t *conflict) {
+  auto blame = [&](const Cell *c) {
+    conflict[c->idx >> 6] |= 1ULL << (c->idx & 63);
+  };
+  if (search.nogoods->unit_forbidden(var->idx, value))
+    return; // Holds whatever else is assigned
+
+  // A duplicate is the fault of the one cell holding the digit
+  for (SectorSpan sector : {board->h_sector(var), board->v_sector(var)}) {
+    for (Cell *c : sector) {
+      if (c != var && state.is_assigned(c) && state.values[c->idx] == value) {
+        blame(c);
+        return;
+      }
+    }
+  }
+
+  int nogood = search.nogoods->violated_by(var->idx, value);
+  if (nogood >= 0) {
+    for (int lit : search.nogoods->literals(nogood)) {
+      int idx = NogoodStore::literal_cell(lit);
+      if (idx != var->idx)
+        conflict[idx >> 6] |= 1ULL << (idx & 63);
+    }
+    return;
+  }
+
+  // Sum limits depend on everything already in both sectors
+  if (!ignore_clues) {
+    for (SectorSpan sector : {board->h_sector(var), board->v_sector(var)}) {
+      for (Cell *c : sector) {
+        if (c != var && state.is_assigned(c))
+          blame(c);
+      }
+    }
+  }
+}
+
+// Conflict-directed backjumping: each failed level reports the assigned
+// cells that caused it in search.conflict(depth). A parent the child does
+// not blame returns at once, so the search unwinds straight to the latest
+// culprit in a shared sector instead of retrying every level in between.
+bool CSPSolver::backtrack_fill(FillState &state, FillSearch &search,
+                               int depth, int &node_count, int max_nodes,
+                               const std::vector<int> &weights,
+                               bool ignore_clues,
+                               const std::string &partition_preference) {
   PROFILE_SCOPE("Filling_BacktrackFillStep", board->logger);
+  uint64_t *conflict = search.conflict(depth);
+
+  // Aborts and rejected complete fills blame every assigned cell, which is
+  // plain chronological backtracking
+  auto blame_all = [&] {
+    size_t n = board->white_cells.size();
+    for (size_t w = 0; w < search.words; w++)
+      conflict[w] = ~state.unassigned[w];
+    if (n & 63)
+      conflict[search.words - 1] &= (1ULL << (n & 63)) - 1;
+  };
+
   if (node_count > max_nodes) {
     LOG_DEBUG("        Max nodes exceeded (" << node_count << " > " << max_nodes
                                              << ")");
+    search.aborted = true;
+    blame_all();
     return false;
   }
   node_count++;
 
   if (node_count % 1000 == 0) {
     // Check timeout after uniqueness check (expensive operation)
-    if (check_timeout())
+    if (check_timeout()) {
+      search.aborted = true;
+      blame_all();
       return false;
+    }
 
     LOG_DEBUG("        Backtrack progress: "
-              << node_count << " nodes, " << assignment.size() << "/"
+              << node_count << " nodes, "
+              << board->white_cells.size() - state.num_unassigned << "/"
               << board->white_cells.size() << " assigned");
   }
 
-  std::vector<Cell *> unassigned;
-  for (Cell *c : board->white_cells) {
-    if (assignment.find(c) == assignment.end()) {
-      unassigned.push_back(c);
-    }
-  }
-
-  if (unassigned.empty()) {
+  if (state.num_unassigned == 0) {
     LOG_DEBUG("        All cells assigned!");
 
     // FINAL VALIDATION for easy puzzles
     if (!partition_preference.empty() && !ignore_clues) {
       LOG_DEBUG("        Validating partition difficulty for: "
                 << partition_preference);
-      if (!validate_partition_difficulty(assignment, partition_preference)) {
+      if (!validate_partition_difficulty(state, partition_preference)) {
         LOG_DEBUG("        Partition difficulty validation FAILED");
+        blame_all();
         return false; // Reject this solution, backtrack
       }
       LOG_DEBUG("        Partition difficulty validation PASSED");
     }
 
-    for (auto &[cell, val] : assignment) {
-      cell->value = val;
+    for (Cell *cell : board->white_cells) {
+      if (state.is_assigned(cell))
+        cell->value = state.values[cell->idx];
     }
     return true;
   }
 
+  std::fill(conflict, conflict + search.words, 0);
+
   // MRV
   Cell *var = nullptr;
   int min_domain = 10;
 
-  for (Cell *c : board->white_cells) {
-    if (assignment.find(c) == assignment.end()) {
-      // Use the assignment map for filling phase
-      int d_size = get_domain_size(c, &assignment, ignore_clues);
+  // Walk the unassigned set in white_cells order so ties resolve the same way
+  for (size_t w = 0; w < state.unassigned.size() && min_domain > 1; w++) {
+    uint64_t bits = state.unassigned[w];
+    while (bits) {
+      Cell *c = board->white_cells[w * 64 + lowest_bit_index(bits)];
+      bits &= bits - 1;
 
-      if (d_size == 0)
-        return false; // Dead end
+      int d_size = get_domain_size(c, &state, ignore_clues);
+
+      if (d_size == 0) {
+        // Dead end, caused by whatever rules out each digit
+        for (int v = 1; v <= 9; v++)
+          blame_value(c, v, state, search, ignore_clues, conflict);
+        return false;
+      }
 
       if (d_size < min_domain) {
         min_domain = d_size;
@@ -597,10 +1259,10 @@ bool CSPSolver::backtrack_fill(
   if (!var)
     return true;
 
-  std::vector<int> domain;
+  DigitList domain;
 
   if (!partition_preference.empty()) {
-    domain = get_partition_aware_domain(var, assignment, partition_preference,
+    domain = get_partition_aware_domain(var, state, partition_preference,
                                         weights);
     if (node_count % 500 == 0) {
       LOG_DEBUG("        Partition-aware domain for ("
@@ -611,19 +1273,19 @@ bool CSPSolver::backtrack_fill(
     last_scored_cell = var;
     last_candidate_scores.clear();
 
-    std::vector<std::pair<int, double>> weighted_domain;
+    std::array<std::pair<int, double>, 9> weighted_domain;
     std::uniform_real_distribution<> dist(0.01, 1.0);
     for (int i = 0; i < 9; i++) {
       int val = i + 1;
       double score = (double)weights[i] * dist(rng);
-      weighted_domain.push_back({val, score});
+      weighted_domain[i] = {val, score};
 
       // Shadow calculations for visual logging (even if not used for sorting)
       double h_score =
-          calculate_partition_score(var, val, assignment, 'h', "few");
+          calculate_partition_score(var, val, state, 'h', "few");
       double v_score =
-          calculate_partition_score(var, val, assignment, 'v', "few");
-      double entropy = estimate_intersection_entropy(var, val, assignment);
+          calculate_partition_score(var, val, state, 'v', "few");
+      double entropy = estimate_intersection_entropy(var, val, state);
 
       last_candidate_scores.push_back(
           {val, h_score, v_score, entropy, (double)weights[i], score});
@@ -636,42 +1298,68 @@ bool CSPSolver::backtrack_fill(
     }
   }
 
+  const uint64_t var_bit = 1ULL << (var->idx & 63);
+  uint16_t tried = 0;
   for (int val : domain) {
-    // Check forbidden values from constraints
-    bool forbidden = false;
-    for (const auto &cons : forbidden_constraints) {
-      if (cons.cell == var) {
-        for (int f_val : cons.values) {
-          if (val == f_val) {
-            forbidden = true;
-            break;
-          }
-        }
-      }
-      if (forbidden)
-        break;
-    }
-    if (forbidden)
+    tried |= 1 << val;
+    if (search.nogoods->unit_forbidden(var->idx, val) ||
+        search.nogoods->violated_by(var->idx, val) >= 0 ||
+        !is_consistent_number(var, val, state, ignore_clues)) {
+      blame_value(var, val, state, search, ignore_clues, conflict);
       continue;
+    }
 
-    if (is_consistent_number(var, val, assignment, ignore_clues)) {
-      assignment[var] = val;
+    state.assign(var, val);
+    search.nogoods->on_assign(var->idx, val);
+    bool filled = backtrack_fill(state, search, depth + 1, node_count,
+                                 max_nodes, weights, ignore_clues,
+                                 partition_preference);
+    if (filled)
+      return true;
+    search.nogoods->on_unassign(var->idx, val);
+    state.unassign(var);
 
-      if (backtrack_fill(assignment, node_count, max_nodes, weights,
-                         ignore_clues, partition_preference,
-                         forbidden_constraints)) {
-        return true;
+    const uint64_t *child = search.conflict(depth + 1);
+    if (!(child[var->idx >> 6] & var_bit)) {
+      // The failure below does not involve var, so no other value can help
+      std::copy(child, child + search.words, conflict);
+      return false;
+    }
+    for (size_t w = 0; w < search.words; w++)
+      conflict[w] |= child[w];
+    conflict[var->idx >> 6] &= ~var_bit;
+  }
+  // Digits the domain left out (already used in a sector)
+  for (int v = 1; v <= 9; v++) {
+    if (!(tried & (1 << v)))
+      blame_value(var, v, state, search, ignore_clues, conflict);
+  }
+
+  // Every value of var failed under the blamed cells, so their current
+  // values are a nogood for the rest of this topology's fills. Nogoods
+  // derived under heuristic ones go when those do.
+  if (!search.aborted) {
+    std::vector<int> &culprits = search.culprits;
+    culprits.clear();
+    for (size_t w = 0; w < search.words; w++) {
+      if (popcount64(conflict[w]) + culprits.size() >
+          (size_t)NogoodStore::MAX_LITERALS) {
+        culprits.clear();
+        break;
       }
-      assignment.erase(var);
+      for (uint64_t bits = conflict[w]; bits; bits &= bits - 1)
+        culprits.push_back((int)(w * 64 + lowest_bit_index(bits)));
     }
+    if (!culprits.empty())
+      search.nogoods->add(culprits, state.values, search.nogoods->has_soft());
   }
   return false;
 }
 
-double CSPSolver::estimate_intersection_entropy(
-    Cell *cell, int value, const std::unordered_map<Cell *, int> &assignment) {
-  int h = estimate_future_domain_size(cell, value, 'h', assignment);
-  int v = estimate_future_domain_size(cell, value, 'v', assignment);
+double CSPSolver::estimate_intersection_entropy(Cell *cell, int value,
+                                                const FillState &state) {
+  int h = estimate_future_domain_size(cell, value, 'h', state);
+  int v = estimate_future_domain_size(cell, value, 'v', state);
 
   if (h == 0 || v == 0)
     return 100.0; // dead move
@@ -682,34 +1370,27 @@ double CSPSolver::estimate_intersection_entropy(
   return std::log2(1.0 + intersection);
 }
 
-int CSPSolver::estimate_future_domain_size(
-    Cell *cell, int value, char direction,
-    const std::unordered_map<Cell *, int> &assignment) {
-  auto sector = (direction == 'h') ? cell->sector_h : cell->sector_v;
-  if (!sector || sector->empty())
+int CSPSolver::estimate_future_domain_size(Cell *cell, int value,
+                                           char direction,
+                                           const FillState &state) {
+  SectorSpan sector =
+      (direction == 'h') ? board->h_sector(cell) : board->v_sector(cell);
+  if (sector.empty())
     return 0;
 
-  int current_sum = value;
-  uint16_t used_mask = (1 << value);
-  int filled = 1;
-
-  for (Cell *c : *sector) {
-    if (c == cell)
-      continue;
-    if (assignment.count(c)) {
-      int v = assignment.at(c);
-      current_sum += v;
-      used_mask |= (1 << v);
-      filled++;
-    }
-  }
+  auto view = state.view(
+      (direction == 'h') ? state.cell_h[cell->idx] : state.cell_v[cell->idx],
+      cell);
+  int current_sum = value + view.sum;
+  uint16_t used_mask = view.used | (1 << value);
+  int filled = 1 + view.filled;
 
-  int remaining = (int)sector->size() - filled;
+  int remaining = view.length - filled;
   if (remaining <= 0)
     return 1; // forced completion
 
   // Determine clue
-  Cell *first = (*sector)[0];
+  Cell *first = sector[0];
   int clue_r = (direction == 'h') ? first->r : first->r - 1;
   int clue_c = (direction == 'h') ? first->c - 1 : first->c;
 
@@ -762,9 +1443,11 @@ int CSPSolver::estimate_future_domain_size(
 bool CSPSolver::has_high_global_ambiguity() {
   PROFILE_SCOPE("Uniqueness_GlobalAmbiguity", board->logger);
   int bad_cells = 0;
+  // Domain sizes seen so far, by Cell::idx, so the log does not redo them
+  std::vector<int> domains(board->white_cells.size(), -1);
 
   for (Cell *c : board->white_cells) {
-    int domain = get_domain_size(c, nullptr, false);
+    int domain = domains[c->idx] = get_domain_size(c, nullptr, false);
     if (domain >= 4) {
       bad_cells++;
       LOG_DEBUG("    Ambiguity check: cell(" << c->r << "," << c->c
@@ -780,7 +1463,8 @@ bool CSPSolver::has_high_global_ambiguity() {
         extra << "{\"bc\": [";
         int b_count = 0;
         for (Cell *bc : board->white_cells) {
-          int d = get_domain_size(bc, nullptr, false);
+          int d = domains[bc->idx] >= 0 ? domains[bc->idx]
+                                        : get_domain_size(bc, nullptr, false);
           if (d >= 4) {
             highlights.push_back({bc->r, bc->c});
             if (b_count > 0)
@@ -813,47 +1497,34 @@ bool CSPSolver::has_high_global_ambiguity() {
   return false;
 }
 
-std::vector<int> CSPSolver::get_partition_aware_domain(
-    Cell *cell, const std::unordered_map<Cell *, int> &assignment,
-    const std::string &preference, const std::vector<int> &weights) {
+DigitList CSPSolver::get_partition_aware_domain(
+    Cell *cell, const FillState &state, const std::string &preference,
+    const std::vector<int> &weights) {
 
   last_scored_cell = cell;
   last_candidate_scores.clear();
-  std::vector<std::pair<int, double>> candidates;
+  std::array<std::pair<int, double>, 9> candidates;
+  int num_candidates = 0;
+
+  // Digits already used in either sector of this cell
+  uint16_t used_mask = 0;
+  if (state.cell_h[cell->idx] >= 0)
+    used_mask |= state.view(state.cell_h[cell->idx], cell).used;
+  if (state.cell_v[cell->idx] >= 0)
+    used_mask |= state.view(state.cell_v[cell->idx], cell).used;
 
   for (int val = 1; val <= 9; val++) {
     // Quick duplicate check
-    bool duplicate = false;
-
-    if (cell->sector_h && !cell->sector_h->empty()) {
-      for (Cell *c : *(cell->sector_h)) {
-        if (assignment.count(c) && assignment.at(c) == val) {
-          duplicate = true;
-          break;
-        }
-      }
-    }
-
-    if (!duplicate && cell->sector_v && !cell->sector_v->empty()) {
-      for (Cell *c : *(cell->sector_v)) {
-        if (assignment.count(c) && assignment.at(c) == val) {
-          duplicate = true;
-          break;
-        }
-      }
-    }
-
-    if (duplicate)
+    if (used_mask & (1 << val))
       continue;
 
     // Calculate partition scores for both directions
     double h_score =
-        calculate_partition_score(cell, val, assignment, 'h', preference);
+        calculate_partition_score(cell, val, state, 'h', preference);
     double v_score =
-        calculate_partition_score(cell, val, assignment, 'v', preference);
+        calculate_partition_score(cell, val, state, 'v', preference);
 
-    double entropy_penalty =
-        estimate_intersection_entropy(cell, val, assignment);
+    double entropy_penalty = estimate_intersection_entropy(cell, val, state);
 
     // Combined score: lower is better (fewer partitions = easier)
     double difficulty_weight = (double)weights[val - 1];
@@ -864,14 +1535,14 @@ std::vector<int> CSPSolver::get_partition_aware_domain(
     last_candidate_scores.push_back({val, h_score, v_score, entropy_penalty,
                                      difficulty_weight, combined_score});
 
-    candidates.push_back({val, combined_score});
+    candidates[num_candidates++] = {val, combined_score};
   }
 
-  if (candidates.empty()) {
+  DigitList result;
+  if (num_candidates == 0) {
     LOG_DEBUG("          WARNING: No valid candidates for cell("
               << cell->r << "," << cell->c << ")");
     // Fallback: return all values 1-9 if no valid candidates found
-    std::vector<int> result;
     for (int i = 1; i <= 9; i++)
       result.push_back(i);
     return result;
@@ -879,46 +1550,40 @@ std::vector<int> CSPSolver::get_partition_aware_domain(
 
   // Sort by score (lower = better), with some randomness
   std::uniform_real_distribution<> dist(0.0, 2.0);
-  for (auto &cand : candidates) {
-    cand.second += dist(rng);
+  for (int i = 0; i < num_candidates; i++) {
+    candidates[i].second += dist(rng);
   }
 
   // 2. Sort based on the now-static scores (Strict Weak Ordering satisfied)
-  std::sort(candidates.begin(), candidates.end(),
+  std::sort(candidates.begin(), candidates.begin() + num_candidates,
             [](const auto &a, const auto &b) { return a.second < b.second; });
 
-  std::vector<int> result;
-  for (auto &[val, score] : candidates) {
-    result.push_back(val);
+  for (int i = 0; i < num_candidates; i++) {
+    result.push_back(candidates[i].first);
   }
   return result;
 }
 
-double CSPSolver::calculate_partition_score(
-    Cell *cell, int value, const std::unordered_map<Cell *, int> &assignment,
-    char direction, const std::string &preference) {
+double CSPSolver::calculate_partition_score(Cell *cell, int value,
+                                            const FillState &state,
+                                            char direction,
+                                            const std::string &preference) {
   PROFILE_SCOPE("Uniqueness_PartitionScore", board->logger);
-  auto sector = (direction == 'h') ? cell->sector_h : cell->sector_v;
+  SectorSpan sector =
+      (direction == 'h') ? board->h_sector(cell) : board->v_sector(cell);
 
   // Safety check
-  if (!sector || sector->empty())
+  if (sector.empty())
     return 0.0;
 
   // Calculate current state of this sector
-  int current_sum = value;
-  int filled_count = 1;
-  std::vector<Cell *> remaining_cells;
+  auto view = state.view(
+      (direction == 'h') ? state.cell_h[cell->idx] : state.cell_v[cell->idx],
+      cell);
+  int current_sum = value + view.sum;
+  int filled_count = 1 + view.filled;
 
-  for (Cell *c : *sector) {
-    if (assignment.count(c)) {
-      current_sum += assignment.at(c);
-      filled_count++;
-    } else if (c != cell) {
-      remaining_cells.push_back(c);
-    }
-  }
-
-  int sector_length = (int)sector->size();
+  int sector_length = view.length;
 
   // If this completes the sector, count actual partitions
   if (filled_count == sector_length) {
@@ -945,61 +1610,44 @@ double CSPSolver::calculate_partition_score(
     }
   } else {
     // Sector not complete yet - estimate difficulty
-    int remaining_count = (int)remaining_cells.size();
-
-    // Get used digits
-    std::unordered_set<int> used_digits;
-    for (Cell *c : *sector) {
-      if (assignment.count(c)) {
-        used_digits.insert(assignment.at(c));
-      }
-    }
-    used_digits.insert(value);
+    int remaining_count = sector_length - filled_count;
 
     // Available digits
-    std::vector<int> available;
-    for (int d = 1; d <= 9; d++) {
-      if (used_digits.find(d) == used_digits.end()) {
-        available.push_back(d);
-      }
-    }
-
-    if ((int)available.size() < remaining_count)
+    uint16_t used_digits = view.used | (1 << value);
+    if (9 - popcount9(used_digits) < remaining_count)
       return 100.0;
 
     int min_remaining = 0;
-    for (int i = 0; i < remaining_count; i++) {
-      min_remaining += available[i];
+    for (int d = 1, taken = 0; d <= 9 && taken < remaining_count; d++) {
+      if (!(used_digits & (1 << d))) {
+        min_remaining += d;
+        taken++;
+      }
     }
 
     int max_remaining = 0;
-    int start_idx = (int)available.size() - remaining_count;
-    for (int i = start_idx; i < (int)available.size(); i++) {
-      max_remaining += available[i];
+    for (int d = 9, taken = 0; d >= 1 && taken < remaining_count; d--) {
+      if (!(used_digits & (1 << d))) {
+        max_remaining += d;
+        taken++;
+      }
     }
 
     int min_final_sum = current_sum + min_remaining;
     int max_final_sum = current_sum + max_remaining;
 
     // Sample a few sums in the range
-    std::vector<int> sample_sums;
-    if (min_final_sum == max_final_sum) {
-      sample_sums.push_back(min_final_sum);
-    } else {
-      int step = std::max(1, (max_final_sum - min_final_sum) / 3);
-      for (int s = min_final_sum; s <= max_final_sum; s += step) {
-        sample_sums.push_back(s);
-      }
-    }
-
-    if (sample_sums.empty())
-      return 5.0; // Safety fallback
-
+    int step = std::max(1, (max_final_sum - min_final_sum) / 3);
+    int num_samples = 0;
     double avg_partitions = 0;
-    for (int s : sample_sums) {
+    for (int s = min_final_sum; s <= max_final_sum; s += step) {
       avg_partitions += count_partitions(s, sector_length);
+      num_samples++;
     }
-    avg_partitions /= sample_sums.size();
+
+    if (num_samples == 0)
+      return 5.0; // Safety fallback
+    avg_partitions /= num_samples;
 
     if (preference == "unique") {
       if (avg_partitions <= 2)
@@ -1022,20 +1670,11 @@ double CSPSolver::calculate_partition_score(
 }
 
 int CSPSolver::count_partitions(int target_sum, int length) {
-  PROFILE_SCOPE("Uniqueness_PartitionCount", board->logger);
-  // Add bounds check
   if (length <= 0 || length > 9 || target_sum <= 0 || target_sum > 45) {
     return 0;
   }
 
-  std::pair<int, int> key = {target_sum, length};
-  if (partition_cache.count(key)) {
-    return partition_cache[key];
-  }
-
-  std::unordered_set<int> used;
-  int result = count_partitions_recursive(target_sum, length, 1, used);
-  partition_cache[key] = result;
+  int result = partition_count(target_sum, length);
 
   if (result == 0 || result > 20) {
     LOG_DEBUG("          Partition count: sum=" << target_sum
@@ -1046,117 +1685,23 @@ int CSPSolver::count_partitions(int target_sum, int length) {
   return result;
 }
 
-int CSPSolver::count_partitions_recursive(int remaining_sum,
-                                          int remaining_length, int min_digit,
-                                          std::unordered_set<int> &used) {
-
-  if (remaining_length == 0) {
-    return (remaining_sum == 0) ? 1 : 0;
-  }
-
-  if (remaining_sum <= 0 || min_digit > 9)
-    return 0;
-
-  // Get available digits
-  std::vector<int> available;
-  for (int d = min_digit; d <= 9; d++) {
-    if (used.find(d) == used.end()) {
-      available.push_back(d);
-    }
-  }
-
-  if ((int)available.size() < remaining_length)
-    return 0;
-
-  // Feasibility check
-  int min_possible = 0;
-  for (int i = 0; i < remaining_length && i < (int)available.size(); i++) {
-    min_possible += available[i];
-  }
-
-  int max_possible = 0;
-  int start = (int)available.size() - remaining_length;
-  if (start < 0)
-    start = 0;
-  for (int i = start; i < (int)available.size(); i++) {
-    max_possible += available[i];
-  }
-
-  if (remaining_sum < min_possible || remaining_sum > max_possible)
-    return 0;
-
-  int count = 0;
-  for (int digit : available) {
-    used.insert(digit);
-    count += count_partitions_recursive(remaining_sum - digit,
-                                        remaining_length - 1, digit + 1, used);
-    used.erase(digit);
-  }
-
-  return count;
-}
-
-bool CSPSolver::validate_partition_difficulty(
-    const std::unordered_map<Cell *, int> &assignment,
-    const std::string &preference) {
+bool CSPSolver::validate_partition_difficulty(const FillState &state,
+                                              const std::string &preference) {
 
   LOG_DEBUG("          Validating partition difficulty...");
   PROFILE_SCOPE("Uniqueness_PartitionDifficulty", board->logger);
   int easy_clue_count = 0;
   int total_clue_count = 0;
 
-  // Check horizontal sectors
-  for (const auto &sector : board->sectors_h) {
-    if (sector->empty())
-      continue;
-
-    bool all_assigned = true;
-    for (Cell *c : *(sector)) {
-      if (assignment.find(c) == assignment.end()) {
-        all_assigned = false;
-        break;
-      }
-    }
-    if (!all_assigned)
+  // Horizontal and vertical sectors share one id space in the fill state
+  for (size_t sid = 0; sid < state.sector_len.size(); sid++) {
+    if (state.sector_len[sid] == 0 ||
+        state.sector_filled[sid] != state.sector_len[sid])
       continue;
 
     total_clue_count++;
-    int clue_sum = 0;
-    for (Cell *c : *(sector)) {
-      clue_sum += assignment.at(c);
-    }
-
-    int num_partitions = count_partitions(clue_sum, (int)sector->size());
-
-    if (preference == "unique" && num_partitions <= 2) {
-      easy_clue_count++;
-    } else if (preference == "few" && num_partitions <= 4) {
-      easy_clue_count++;
-    }
-  }
-
-  // Check vertical sectors
-  for (const auto &sector : board->sectors_v) {
-    if (sector->empty())
-      continue;
-
-    bool all_assigned = true;
-    for (Cell *c : *(sector)) {
-      if (assignment.find(c) == assignment.end()) {
-        all_assigned = false;
-        break;
-      }
-    }
-    if (!all_assigned)
-      continue;
-
-    total_clue_count++;
-    int clue_sum = 0;
-    for (Cell *c : *(sector)) {
-      clue_sum += assignment.at(c);
-    }
-
-    int num_partitions = count_partitions(clue_sum, (int)sector->size());
+    int num_partitions =
+        count_partitions(state.sector_sum[sid], state.sector_len[sid]);
 
     if (preference == "unique" && num_partitions <= 2) {
       easy_clue_count++;
@@ -1187,52 +1732,29 @@ bool CSPSolver::validate_partition_difficulty(
   return true;
 }
 
-int CSPSolver::count_neighbors_filled(
-    Cell *cell, const std::unordered_map<Cell *, int> &assignment) {
+int CSPSolver::count_neighbors_filled(Cell *cell, const FillState &state) {
   int count = 0;
-
-  if (cell->sector_h && !cell->sector_h->empty()) {
-    for (Cell *n : *(cell->sector_h)) {
-      if (assignment.find(n) != assignment.end()) {
-        count++;
-      }
-    }
-  }
-
-  if (cell->sector_v && !cell->sector_v->empty()) {
-    for (Cell *n : *(cell->sector_v)) {
-      if (assignment.find(n) != assignment.end()) {
-        count++;
-      }
-    }
-  }
-
+  if (state.cell_h[cell->idx] >= 0)
+    count += state.sector_filled[state.cell_h[cell->idx]];
+  if (state.cell_v[cell->idx] >= 0)
+    count += state.sector_filled[state.cell_v[cell->idx]];
   return count;
 }
 
-bool CSPSolver::is_consistent_number(
-    Cell *var, int value, const std::unordered_map<Cell *, int> &assignment,
-    bool ignore_clues) {
+bool CSPSolver::is_consistent_number(Cell *var, int value,
+                                     const FillState &state,
+                                     bool ignore_clues) {
   if (ignore_clues) {
     // Simple duplicate check for the filling phase
-    auto has_dupe = [&](std::shared_ptr<std::vector<Cell *>> sector) {
-      if (!sector)
-        return false;
-      for (Cell *p : *sector) {
-        if (p == var)
-          continue;
-        if (assignment.count(p) && assignment.at(p) == value)
-          return true;
-        if (p->value.has_value() && *p->value == value)
-          return true;
-      }
-      return false;
+    auto has_dupe = [&](int sector) {
+      return sector >= 0 && (state.view(sector, var).used & (1 << value));
     };
-    return !has_dupe(var->sector_h) && !has_dupe(var->sector_v);
+    return !has_dupe(state.cell_h[var->idx]) &&
+           !has_dupe(state.cell_v[var->idx]);
   }
 
   // Comprehensive check for the uniqueness phase
-  return is_valid_move(var, value, &assignment, ignore_clues);
+  return is_valid_move(var, value, &state, ignore_clues);
 }
 
 void CSPSolver::calculate_clues() {
@@ -1248,18 +1770,18 @@ void CSPSolver::calculate_clues() {
   board->identify_sectors();
 
   // 3. Assign Clues
-  for (auto &sector : board->sectors_h) {
+  for (SectorSpan sector : board->sectors_h) {
     int sum = 0;
-    for (Cell *c : *sector)
+    for (Cell *c : sector)
       sum += c->value.value_or(0);
-    Cell *first = (*sector)[0];
+    Cell *first = sector[0];
     board->grid[first->r][first->c - 1].clue_h = sum;
   }
-  for (auto &sector : board->sectors_v) {
+  for (SectorSpan sector : board->sectors_v) {
     int sum = 0;
-    for (Cell *c : *sector)
+    for (Cell *c : sector)
       sum += c->value.value_or(0);
-    Cell *first = (*sector)[0];
+    Cell *first = sector[0];
     board->grid[first->r - 1][first->c].clue_v = sum;
   }
 }
@@ -1271,7 +1793,12 @@ CSPSolver::check_uniqueness(int max_nodes, int seed_offset) {
   LOG_DEBUG("  Checking uniqueness using Logical Estimator...");
 
   HybridUniquenessChecker checker(board);
-  return checker.check_uniqueness_hybrid(max_nodes, seed_offset);
+  checker.set_num_threads(uniqueness_threads_);
+  if (budget_)
+    checker.set_budget(budget_->child_fraction(UNIQUENESS_BUDGET_FRACTION));
+  auto result = checker.check_uniqueness_hybrid(max_nodes, seed_offset);
+  stats_.uniqueness_nodes += checker.last_node_count();
+  return result;
 
   // // 1. Back up current solution
   // std::unordered_map<Cell *, int> original_sol;
@@ -1434,42 +1961,42 @@ void CSPSolver::solve_for_uniqueness(
   }
 }
 
-int CSPSolver::get_domain_size(
-    Cell *cell, const std::unordered_map<Cell *, int> *assignment,
-    bool ignore_clues) {
+int CSPSolver::get_domain_size(Cell *cell, const FillState *state,
+                               bool ignore_clues) {
   // PROFILE_SCOPE("Uniqueness_DomainSize", board->logger);
   int count = 0;
   for (int v = 1; v <= 9; v++) {
-    if (is_valid_move(cell, v, assignment, ignore_clues)) {
+    if (is_valid_move(cell, v, state, ignore_clues)) {
       count++;
     }
   }
   return count;
 }
 
-bool CSPSolver::is_valid_move(Cell *cell, int val,
-                              const std::unordered_map<Cell *, int> *assignment,
+bool CSPSolver::is_valid_move(Cell *cell, int val, const FillState *state,
                               bool ignore_clues) {
   // PROFILE_SCOPE("Uniqueness_MoveValidation", board->logger);
-  auto check_sector = [&](std::shared_ptr<std::vector<Cell *>> sector,
-                          bool is_horz) {
-    if (!sector || sector->empty())
+  auto check_sector = [&](SectorSpan sector, bool is_horz) {
+    if (sector.empty())
       return true;
 
     int sum = val;
     int filled_count = 1;
     uint16_t used_mask = (1 << val);
 
-    for (Cell *p : *sector) {
-      if (p == cell)
-        continue;
-      int v = 0;
-      if (assignment && assignment->count(p))
-        v = assignment->at(p);
-      else if (p->value.has_value())
-        v = *p->value;
-
-      if (v > 0) {
+    if (state) {
+      auto view = state->view(
+          is_horz ? state->cell_h[cell->idx] : state->cell_v[cell->idx], cell);
+      if (view.used & (1 << val))
+        return false;
+      sum += view.sum;
+      used_mask |= view.used;
+      filled_count += view.filled;
+    } else {
+      for (Cell *p : sector) {
+        if (p == cell || !p->value.has_value())
+          continue;
+        int v = *p->value;
         if (v == val)
           return false;
         sum += v;
@@ -1484,7 +2011,7 @@ bool CSPSolver::is_valid_move(Cell *cell, int val,
       return true;
 
     // FIND THE CLUE (Robust Indexing)
-    Cell *first = (*sector)[0];
+    Cell *first = sector[0];
     int clue_r = is_horz ? first->r : first->r - 1;
     int clue_c = is_horz ? first->c - 1 : first->c;
 
@@ -1500,7 +2027,7 @@ bool CSPSolver::is_valid_move(Cell *cell, int val,
       return false;
 
     int target = *clue_opt;
-    int remaining_cells = (int)sector->size() - filled_count;
+    int remaining_cells = (int)sector.size() - filled_count;
 
     if (sum > target)
       return false;
@@ -1526,8 +2053,8 @@ bool CSPSolver::is_valid_move(Cell *cell, int val,
     return true;
   };
 
-  return check_sector(cell->sector_h, true) &&
-         check_sector(cell->sector_v, false);
+  return check_sector(board->h_sector(cell), true) &&
+         check_sector(board->v_sector(cell), false);
 }
 
 bool CSPSolver::repair_topology_robust(
@@ -1575,6 +2102,7 @@ bool CSPSolver::repair_topology_robust(
         board->grid[r][c].type = backup.types[r][c];
       }
     }
+    board->sync_white_bits();
 
     // Try the smart removal
     if (board->try_remove_and_reconnect(target->r, target->c)) {
@@ -1603,7 +2131,7 @@ bool CSPSolver::repair_topology_robust(
       board->logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                               GenerationLogger::SUBSTAGE_REPAIR_ATTEMPT,
                               "Topology repair did not change the board",
-                              board->get_grid_state());
+                              *board);
 #endif
       continue;
     }
@@ -1614,7 +2142,7 @@ bool CSPSolver::repair_topology_robust(
       board->logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                               GenerationLogger::SUBSTAGE_REPAIR_ATTEMPT,
                               "Topology repair failed to create a valid board",
-                              board->get_grid_state());
+                              *board);
 #endif
       continue;
     }
@@ -1625,7 +2153,7 @@ bool CSPSolver::repair_topology_robust(
           GenerationLogger::STAGE_TOPOLOGY,
           GenerationLogger::SUBSTAGE_REPAIR_ATTEMPT,
           "Topology repair failed to create a valid board (too small)",
-          board->get_grid_state());
+          *board);
 #endif
       continue;
     }
@@ -1635,7 +2163,7 @@ bool CSPSolver::repair_topology_robust(
     board->logger->log_step(GenerationLogger::STAGE_TOPOLOGY,
                             GenerationLogger::SUBSTAGE_REPAIR_ATTEMPT,
                             "Topology repaired successfully",
-                            board->get_grid_state());
+                            *board);
 #endif
     return true;
   }
@@ -1690,31 +2218,14 @@ bool CSPSolver::is_connected(
   if (coords.empty())
     return false;
 
-  auto start = *coords.begin();
-  std::queue<std::pair<int, int>> q;
-  q.push(start);
-
-  std::unordered_set<std::pair<int, int>, PairHash> visited;
-  visited.insert(start);
-
-  int count = 0;
-  std::vector<std::pair<int, int>> dirs = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
-
-  while (!q.empty()) {
-    auto [r, c] = q.front();
-    q.pop();
-    count++;
-
-    for (auto [dr, dc] : dirs) {
-      std::pair<int, int> next = {r + dr, c + dc};
-      if (coords.count(next) && !visited.count(next)) {
-        visited.insert(next);
-        q.push(next);
-      }
-    }
+  GridConnectivity conn;
+  conn.reset(board->width, board->height);
+  for (auto [r, c] : coords) {
+    if (r < 0 || r >= board->height || c < 0 || c >= board->width)
+      return false;
+    conn.add_white(r, c);
   }
-
-  return count == (int)coords.size();
+  return conn.num_components() == 1;
 }
 
 } // namespace kakuro
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "kakuro_cpp.h"
+
+namespace kakuro {
+
+namespace {
+
+// FNV-1a over the raw bytes of each field
+struct Fnv1a {
+  uint64_t hash = 1469598103934665603ULL;
+
+  void bytes(const void *data, size_t size) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < size; i++) {
+      hash ^= p[i];
+      hash *= 1099511628211ULL;
+    }
+  }
+  template <typename T> void value(const T &v) { bytes(&v, sizeof(v)); }
+  template <typename T> void optional(const std::optional<T> &v) {
+    value(v.has_value());
+    if (v)
+      value(*v);
+  }
+};
+
+} // namespace
+
+TopologyPool::TopologyPool(int per_key)
+    : per_key_(std::max(1, per_key)), rng_(std::random_device{}()) {}
+
+TopologyPool::~TopologyPool() { stop(); }
+
+void TopologyPool::start() {
+  if (producer_.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = false;
+    producer_budget_ = GenerationBudget::create();
+  }
+  producer_ = std::thread(&TopologyPool::produce, this);
+}
+
+void TopologyPool::stop() {
+  if (!producer_.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    producer_budget_->cancel(); // Ends a topology build in progress
+  }
+  wake_.notify_all();
+  producer_.join();
+}
+
+bool TopologyPool::acquire(KakuroBoard &board, const TopologyParams &params,
+                           uint64_t &hash) {
+  uint64_t params_key = params_hash(params);
+  Topology topology;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot *slot = find_slot(board.width, board.height, params_key);
+    if (!slot) {
+      if ((int)slots_.size() >= MAX_KEYS) {
+        slots_.erase(std::min_element(
+            slots_.begin(), slots_.end(), [](const Slot &a, const Slot &b) {
+              return a.last_request < b.last_request;
+            }));
+      }
+      slots_.emplace_back(board.width, board.height, params_key, params);
+      slot = &slots_.back();
+    }
+    slot->last_request = ++request_clock_;
+    slot->failures = 0;
+    if (!slot->ready.empty()) {
+      topology = std::move(slot->ready.front());
+      slot->ready.pop_front();
+    }
+  }
+  // Either way the key is now short of per_key_
+  wake_.notify_one();
+  if (topology.white_rows.empty())
+    return false;
+
+  board.load_white_rows(topology.white_rows.data());
+  hash = topology.hash;
+  return true;
+}
+
+void TopologyPool::evict(int width, int height, const TopologyParams &params,
+                         uint64_t hash) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Slot *slot = find_slot(width, height, params_hash(params));
+  if (!slot)
+    return;
+  if (slot->evicted.size() >= MAX_EVICTED)
+    slot->evicted.clear();
+  slot->evicted.insert(hash);
+}
+
+size_t TopologyPool::ready(int width, int height,
+                           const TopologyParams &params) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t params_key = params_hash(params);
+  for (const Slot &slot : slots_) {
+    if (slot.width == width && slot.height == height &&
+        slot.params_key == params_key)
+      return slot.ready.size();
+  }
+  return 0;
+}
+
+uint64_t TopologyPool::params_hash(const TopologyParams &params) {
+  Fnv1a fnv;
+  fnv.value(params.difficulty.size());
+  fnv.bytes(params.difficulty.data(), params.difficulty.size());
+  fnv.optional(params.density);
+  fnv.optional(params.max_sector_length);
+  fnv.optional(params.num_stamps);
+  fnv.optional(params.min_cells);
+  fnv.optional(params.max_run_len);
+  fnv.optional(params.max_run_len_soft);
+  fnv.optional(params.max_run_len_soft_prob);
+  fnv.optional(params.max_patch_size);
+  fnv.optional(params.island_mode);
+  fnv.value(params.stamps.has_value());
+  if (params.stamps) {
+    fnv.value(params.stamps->size());
+    for (const auto &[h, w] : *params.stamps) {
+      fnv.value(h);
+      fnv.value(w);
+    }
+  }
+  return fnv.hash;
+}
+
+uint64_t TopologyPool::white_map_hash(const KakuroBoard &board) {
+  Fnv1a fnv;
+  fnv.value(board.width);
+  fnv.value(board.height);
+  fnv.bytes(board.white_rows.data(), board.white_rows.size() * sizeof(uint64_t));
+  return fnv.hash;
+}
+
+TopologyPool::Slot *TopologyPool::find_slot(int width, int height,
+                                            uint64_t params_key) {
+  for (Slot &slot : slots_) {
+    if (slot.width == width && slot.height == height &&
+        slot.params_key == params_key)
+      return &slot;
+  }
+  return nullptr;
+}
+
+// The most recently requested key that is short and not failing
+TopologyPool::Slot *TopologyPool::next_slot_to_fill() {
+  Slot *best = nullptr;
+  for (Slot &slot : slots_) {
+    if ((int)slot.ready.size() >= per_key_ ||
+        slot.failures >= MAX_PRODUCER_FAILURES)
+      continue;
+    if (!best || slot.last_request > best->last_request)
+      best = &slot;
+  }
+  return best;
+}
+
+void TopologyPool::produce() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    Slot *slot = next_slot_to_fill();
+    if (!slot) {
+      wake_.wait(lock);
+      continue;
+    }
+    int width = slot->width;
+    int height = slot->height;
+    uint64_t params_key = slot->params_key;
+    TopologyParams params = slot->params;
+    uint32_t seed = rng_();
+    lock.unlock();
+
+    // Built like CSPSolver::generate_puzzle builds one: defaults resolved on
+    // the board, then the full topology passes including validation
+    KakuroBoard board(width, height, seed);
+    board.budget = producer_budget_;
+    board.apply_topology_defaults(params);
+    bool ok = board.generate_topology(params);
+    uint64_t hash = ok ? white_map_hash(board) : 0;
+
+    lock.lock();
+    // The key may have been dropped while the lock was released
+    slot = find_slot(width, height, params_key);
+    if (!slot)
+      continue;
+    bool duplicate =
+        ok && (slot->evicted.count(hash) ||
+               std::any_of(slot->ready.begin(), slot->ready.end(),
+                           [&](const Topology &t) { return t.hash == hash; }));
+    if (!ok || duplicate) {
+      slot->failures++;
+      continue;
+    }
+    slot->failures = 0;
+    slot->ready.push_back({board.white_rows, hash});
+  }
+}
+
+} // namespace kakuro
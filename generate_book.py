@@ -208,7 +208,7 @@ def generate_pdf(num_puzzles=4, width=10, height=12):
     for i in range(num_puzzles):
        
         board_obj = kakuro.generate_kakuro(width, height, difficulty=DIFFICULTY.lower(), use_cpp=True)
-        difficulty_score = kakuro.KakuroDifficultyEstimator(board_obj).estimate_difficulty_detailed()
+        difficulty_score = board_obj.difficulty or kakuro.KakuroDifficultyEstimator(board_obj).estimate_difficulty_detailed()
         print(f"Puzzle {i+1}: Difficulty: {difficulty_score} Techniques: {difficulty_score.solve_path}")
         board_data = kakuro.export_to_json(board_obj)
         puzzles.append((board_data, difficulty_score))
@@ -12,6 +12,7 @@ import webbrowser
 import threading
 import time
 from kakuro import KakuroBoard, CSPSolver
+from kakuro.kakuro_wrapper import configure_logging, flush_logs, open_puzzle_pool, new_topology_pool, CPP_AVAILABLE
 import uvicorn
 import uuid
 import datetime
@@ -261,8 +262,21 @@ def startup_event():
         conn.commit()
     logger.info("Database initialized")
     
+    # Generation logs are written off the request threads
+    configure_logging(config.GENERATION_LOG_LEVEL, async_write=True)
+
     # Start background generator
     generator_service.start(DIFFICULTY_SIZE_RANGES)
+
+    # /generate serves from the binary pool the generator appends to
+    global puzzle_pool
+    if config.PUZZLE_POOL_FILE:
+        puzzle_pool = open_puzzle_pool(config.PUZZLE_POOL_FILE)
+
+    # /generate draws topologies built ahead of time
+    global topology_pool
+    if CPP_AVAILABLE and config.TOPOLOGY_POOL_SIZE > 0:
+        topology_pool = new_topology_pool(config.TOPOLOGY_POOL_SIZE)
     
     # Start system monitor
     threading.Thread(target=system_monitor_task, daemon=True).start()
@@ -271,6 +285,9 @@ def startup_event():
 def shutdown_event():
     """Stop background services."""
     generator_service.stop()
+    if topology_pool is not None:
+        topology_pool.stop()
+    flush_logs()
 
 def get_base_path():
     if getattr(sys, 'frozen', False):
@@ -330,6 +347,11 @@ DIFFICULTY_SIZE_RANGES = {
 
 MAX_RETRIES = 20  # More retries for reliability
 
+# Memory-mapped kakuro_cpp.PuzzlePool, opened at startup when configured
+puzzle_pool = None
+# kakuro_cpp.TopologyPool feeding /generate, started at startup when enabled
+topology_pool = None
+
 def validate_board(board, min_white_cells: int) -> bool:
     """Check if the board has enough white cells."""
     return len(board.white_cells) >= min_white_cells
@@ -357,6 +379,31 @@ def generate_puzzle(width: Optional[int] = None, height: Optional[int] = None, d
             height = random.randint(min_s, max_s)
 
 
+    # Pool hit: decode a stored puzzle instead of generating one
+    if puzzle_pool is not None and puzzle_pool.refresh():
+        pooled = puzzle_pool.random_puzzle(difficulty, width, height)
+        if pooled is not None:
+            grid_data = [
+                [
+                    {
+                        "r": r, "c": c,
+                        "type": cell.type.name,
+                        "value": cell.solution, "clue_h": cell.clue_h, "clue_v": cell.clue_v,
+                    }
+                    for c, cell in enumerate(row)
+                ]
+                for r, row in enumerate(pooled.grid)
+            ]
+            return {
+                "id": str(uuid.uuid4()),
+                "width": width,
+                "height": height,
+                "difficulty": difficulty,
+                "grid": grid_data,
+                "status": "started",
+                "timestamp": datetime.datetime.now().isoformat()
+            }
+
     # Adjust minimum white cells relative to area
     min_ratio = MIN_CELLS_MAP.get(difficulty, 0.15)
     area = (width - 2) * (height - 2)
@@ -370,6 +417,10 @@ def generate_puzzle(width: Optional[int] = None, height: Optional[int] = None, d
     for attempt in range(max_outer_retries):
         board = KakuroBoard(width, height)
         solver = CSPSolver(board)
+        solver.set_uniqueness_threads(os.cpu_count() or 1)
+        solver.set_fill_portfolio(min(4, os.cpu_count() or 1))
+        if topology_pool is not None:
+            solver.set_topology_pool(topology_pool)
         
         # This function now handles Topology -> Fill -> Verify -> Repair -> Repeat
         success = solver.generate_puzzle(difficulty=difficulty)
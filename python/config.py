@@ -40,6 +40,23 @@ APPLE_PRIVATE_KEY: Optional[str] = os.getenv("APPLE_PRIVATE_KEY")  # Contents of
 # Application settings
 APP_HOST = os.getenv("APP_HOST", "https://kakuro.servegame.com") # http://localhost:8008
 
+# C++ generation logs: "off", "stage" or "full"
+GENERATION_LOG_LEVEL = os.getenv("GENERATION_LOG_LEVEL", "full").lower()
+
+# Binary pool file the generator appends to and /generate serves from.
+# Empty disables it.
+PUZZLE_POOL_FILE = os.getenv("PUZZLE_POOL_FILE", "")
+
+# Ready topologies kept per size and difficulty for /generate. 0 disables.
+TOPOLOGY_POOL_SIZE = int(os.getenv("TOPOLOGY_POOL_SIZE", "4"))
+
+# Transposed/mirrored/complemented copies saved per generated puzzle. 0 disables.
+PUZZLE_VARIANTS = int(os.getenv("PUZZLE_VARIANTS", "3"))
+
+# Finished puzzles the generator service's native stream holds before its
+# producers pause for the database to catch up. 0 generates in polled batches.
+PUZZLE_STREAM_CAPACITY = int(os.getenv("PUZZLE_STREAM_CAPACITY", "16"))
+
 # OAuth redirect URIs (constructed from APP_HOST)
 GOOGLE_REDIRECT_URI = f"{APP_HOST}/auth/google/callback"
 FACEBOOK_REDIRECT_URI = f"{APP_HOST}/auth/facebook/callback"
@@ -1,3 +1,5 @@
+import os
+import json
 import threading
 import time
 import logging
@@ -7,7 +9,8 @@ from sqlalchemy.orm import Session
 from sqlalchemy import func
 from .database import SessionLocal
 from .models import PuzzleTemplate, DifficultyStat
-from .kakuro_wrapper import KakuroBoard, CSPSolver, KakuroDifficultyEstimator, generate_kakuro
+from . import config
+from .kakuro_wrapper import KakuroBoard, CSPSolver, KakuroDifficultyEstimator, generate_kakuro, generate_batch, new_budget, difficulty_to_dict, open_puzzle_pool_writer, puzzle_variants, new_puzzle_stream, stream_targets, CPP_AVAILABLE
 
 logger = logging.getLogger("kakuro_generator")
 
@@ -24,6 +27,11 @@ class GeneratorService:
         self._thread = None
         self.running = False
         self._current_counts = {diff: 0 for diff in DIFFICULTY_LEVELS}
+        self._generation_stats = {}  # difficulty -> summed C++ GenerationStats of the last batch
+        self._active_budgets = set()  # GenerationBudgets of running native batches
+        self._budget_lock = threading.Lock()
+        self._pool_writer = None  # Binary pool file mirror of new templates (config.PUZZLE_POOL_FILE)
+        self._stream = None  # Native PuzzleStream while the loop streams
         self.difficulty_size_ranges = {}
 
     @property
@@ -31,6 +39,11 @@ class GeneratorService:
         """Returns current pool counts for the Admin Dashboard."""
         return self._current_counts
 
+    @property
+    def generation_stats(self) -> dict:
+        """Returns the summed C++ generation stats of the last batch per difficulty."""
+        return self._generation_stats
+
     @property
     def settings(self) -> dict:
         """Returns config for the Admin Dashboard."""
@@ -47,6 +60,10 @@ class GeneratorService:
             return
         
         logger.info("Starting Generator Service...")
+        if config.PUZZLE_POOL_FILE and self._pool_writer is None:
+            self._pool_writer = open_puzzle_pool_writer(config.PUZZLE_POOL_FILE)
+            if self._pool_writer is None:
+                logger.warning(f"Puzzle pool file {config.PUZZLE_POOL_FILE} unavailable, not mirroring templates")
         self._stop_event.clear()
         self.running = True
         self._thread = threading.Thread(target=self._run_loop, daemon=True)
@@ -56,9 +73,19 @@ class GeneratorService:
         """Stop the background generation thread."""
         logger.info("Stopping Generator Service...")
         self._stop_event.set()
+        # Native batches release the GIL and would otherwise finish first
+        with self._budget_lock:
+            for budget in self._active_budgets:
+                budget.cancel()
+        stream = self._stream
+        if stream is not None:
+            stream.stop()
         if self._thread:
             self._thread.join(timeout=2)
         self.running = False
+        if self._pool_writer is not None:
+            self._pool_writer.close()
+            self._pool_writer = None
 
     def generate_single_puzzle(self, db: Session, target_diff: str, means: dict = None, height: int | None = None, width: int | None = None) -> PuzzleTemplate:
         """
@@ -71,26 +98,22 @@ class GeneratorService:
         # 1. Call C++ Generator
         if height is None or width is None:
             width, height = self._get_grid_size(target_diff)
-        board = generate_kakuro(width=width, height=height, difficulty=target_diff, use_cpp=True)
-        difficulty_estimator = KakuroDifficultyEstimator(board)
-        diff = difficulty_estimator.estimate_difficulty_detailed()
+        # On-demand path: a caller is waiting, so race fills and let the uniqueness search use all cores
+        cores = os.cpu_count() or 1
+        board = generate_kakuro(width=width, height=height, difficulty=target_diff, use_cpp=True,
+                                uniqueness_threads=cores, fill_portfolio=min(4, cores))
+        if board is None:
+            return None
+        # Set from the generator's own validation unless every attempt failed
+        diff = board.difficulty
+        if diff is None:
+            diff = KakuroDifficultyEstimator(board).estimate_difficulty_detailed()
         
         if not board or not diff:
             return None
 
         # 2. Package detailed information
-        difficulty_info = {
-            "rating": diff.rating,
-            "score": round(diff.score, 2),
-            "max_tier": int(diff.max_tier),
-            "total_steps": diff.total_steps,
-            "uniqueness": diff.uniqueness,
-            "solution_count": diff.solution_count,
-            "solve_path": [
-                {"technique": s.technique, "weight": s.difficulty_weight, "cells": s.cells_affected} 
-                for s in diff.solve_path
-            ]
-        }
+        difficulty_info = difficulty_to_dict(diff)
 
         # 3. Difficulty Pushing Logic
         final_diff = target_diff
@@ -133,6 +156,9 @@ class GeneratorService:
     def _run_loop(self):
         """Main loop that checks pool sizes and triggers generation."""
         logger.info("Generator Service Loop Started")
+        if CPP_AVAILABLE and config.PUZZLE_STREAM_CAPACITY > 0:
+            self._run_stream_loop()
+            return
         
         while not self._stop_event.is_set():
             try:
@@ -146,6 +172,64 @@ class GeneratorService:
                     break
                 time.sleep(0.5)
 
+    def _run_stream_loop(self):
+        """
+        Saves puzzles from a native PuzzleStream as they finish, so generation
+        overlaps the database writes. Every CHECK_INTERVAL_SECONDS the mix is
+        re-weighted by how far each pool is below POOL_TARGET_SIZE; full pools
+        get no new puzzles and a full queue pauses the producers.
+        """
+        stream = new_puzzle_stream({}, self.difficulty_size_ranges,
+                                   capacity=config.PUZZLE_STREAM_CAPACITY)
+        self._stream = stream
+        totals = {}  # difficulty -> summed GenerationStats since the last check
+        next_check = 0.0
+        try:
+            while not self._stop_event.is_set():
+                try:
+                    if time.monotonic() >= next_check:
+                        self._refresh_stream(stream, totals)
+                        totals = {}
+                        next_check = time.monotonic() + CHECK_INTERVAL_SECONDS
+
+                    item = stream.pop(500)
+                    if item is None:
+                        continue
+                    difficulty, puzzle = item
+                    stats = totals.setdefault(difficulty, {"puzzles": 0})
+                    for key, value in puzzle.stats.to_dict().items():
+                        stats[key] = stats.get(key, 0) + value
+                    stats["puzzles"] += 1
+
+                    with SessionLocal() as db:
+                        means = self._get_all_means(db)
+                        self._save_candidates(db, difficulty, self._puzzle_candidates(puzzle), means)
+                except Exception as e:
+                    logger.error(f"Error in Generator Service stream: {e}", exc_info=True)
+                    self._stop_event.wait(1)
+        finally:
+            self._stream = None
+            stream.stop()
+
+    def _refresh_stream(self, stream, totals: dict):
+        """Recounts the pools, logs the stats since the last check and re-weights the mix."""
+        with SessionLocal() as db:
+            weights = {}
+            for difficulty in DIFFICULTY_LEVELS:
+                fresh_count = self._fresh_count(db, difficulty)
+                self._current_counts[difficulty] = fresh_count
+                if difficulty in self.difficulty_size_ranges:
+                    weights[difficulty] = max(0, POOL_TARGET_SIZE - fresh_count)
+
+            for difficulty, stats in totals.items():
+                self._generation_stats[difficulty] = stats
+                try:
+                    from .performance import log_generation_stats
+                    log_generation_stats(db, difficulty, stats)
+                except ImportError:
+                    pass
+        stream.set_targets(stream_targets(weights, self.difficulty_size_ranges))
+
     def _get_all_means(self, db: Session):
         """Retrieves a dict of difficulty -> mean_score."""
         stats = db.query(DifficultyStat).all()
@@ -221,6 +305,14 @@ class GeneratorService:
         return random.randint(min_size, max_size), random.randint(min_size, max_size)
     
 
+    def _fresh_count(self, db: Session, difficulty: str) -> int:
+        """Templates of a difficulty still below the dynamic freshness threshold."""
+        threshold = self._get_freshness_threshold(db, difficulty)
+        return db.query(PuzzleTemplate).filter(
+            PuzzleTemplate.difficulty == difficulty,
+            PuzzleTemplate.times_used < threshold
+        ).count()
+
     def _check_and_refill_pools(self):
         """Check database for fresh puzzle counts and generate if needed."""
         with SessionLocal() as db:
@@ -230,15 +322,7 @@ class GeneratorService:
                 if self._stop_event.is_set():
                     return
 
-                # Get dynamic freshness threshold
-                threshold = self._get_freshness_threshold(db, difficulty)
-                
-                # Count 'fresh' templates (times_used below threshold)
-                fresh_count = db.query(PuzzleTemplate).filter(
-                    PuzzleTemplate.difficulty == difficulty,
-                    PuzzleTemplate.times_used < threshold
-                ).count()
-
+                fresh_count = self._fresh_count(db, difficulty)
                 self._current_counts[difficulty] = fresh_count
                 if fresh_count < POOL_TARGET_SIZE:
                     logger.info(f"{difficulty} pool is low. Starting targeted generation batch...")
@@ -247,75 +331,119 @@ class GeneratorService:
                     duration_ms = (time.perf_counter() - start_t) * 1000
                 
                     try:
-                        from .performance import record_metric
+                        from .performance import record_metric, log_generation_stats
                         record_metric(db, f"gen_{difficulty}_batch_time_ms", duration_ms, "ms")
+                        if difficulty in self._generation_stats:
+                            log_generation_stats(db, difficulty, self._generation_stats[difficulty])
                     except ImportError:
                         pass
             
                     
     def _generate_targeted_batch(self, db: Session, target_diff: str, count: int, means: dict, height: int | None = None, width: int | None = None):
         """Generates puzzles and adjusts their difficulty based on global means."""
+        self._save_candidates(db, target_diff, self._generate_candidates(target_diff, count, height, width), means)
+
+    def _save_candidates(self, db: Session, target_diff: str, candidates, means: dict):
+        """Saves the candidates as templates, pushing each to the difficulty its score fits."""
         # Pre-fetch stats to avoid "flush-on-query" issues or duplicate "add" in batch
         stats_map = {s.difficulty: s for s in db.query(DifficultyStat).all()}
 
         generated = 0
+        for width, height, raw_score, difficulty_data, grid, puzzle in candidates:
+            # Apply the requested logic: Compare against means
+            final_diff = self._determine_difficulty(raw_score, target_diff, means)
+
+            pool_writer = self._pool_writer
+            if puzzle is not None and pool_writer is not None:
+                pool_writer.append(puzzle, final_diff)
+
+            tmpl = PuzzleTemplate(
+                width=width,
+                height=height,
+                difficulty=final_diff,
+                difficulty_score=raw_score,
+                difficulty_data=difficulty_data,
+                grid=grid,
+                times_used=0
+            )
+            db.add(tmpl)
+
+            # Update the running average for the FINAL difficulty
+            if final_diff not in stats_map:
+                new_stat = DifficultyStat(difficulty=final_diff, sum_scores=0.0, count=0)
+                db.add(new_stat)
+                stats_map[final_diff] = new_stat
+
+            stat = stats_map[final_diff]
+            stat.sum_scores += raw_score
+            stat.count += 1
+
+            generated += 1
+
+        if generated > 0:
+            db.commit()
+            logger.info(f"Saved {generated} puzzles initially targeted as {target_diff}")
+
+    def _generate_candidates(self, target_diff: str, count: int, height: int | None, width: int | None):
+        """
+        Yields (width, height, score, difficulty_data, grid, puzzle) for freshly
+        generated puzzles; puzzle is the C++ GeneratedPuzzle or None.
+        """
+        if CPP_AVAILABLE:
+            # Native worker pool: all cores, GIL released for the whole batch
+            if height is None or width is None:
+                width_range = height_range = self.difficulty_size_ranges[target_diff]
+            else:
+                width_range, height_range = (width, width), (height, height)
+            budget = new_budget()
+            with self._budget_lock:
+                self._active_budgets.add(budget)
+            try:
+                puzzles = generate_batch(count, target_diff, width_range, height_range,
+                                         budget=budget)
+            finally:
+                with self._budget_lock:
+                    self._active_budgets.discard(budget)
+            totals = {}
+            for puzzle in puzzles:
+                for key, value in puzzle.stats.to_dict().items():
+                    totals[key] = totals.get(key, 0) + value
+            totals["puzzles"] = len(puzzles)
+            self._generation_stats[target_diff] = totals
+
+            for puzzle in puzzles:
+                yield from self._puzzle_candidates(puzzle)
+            return
+
         for _ in range(count):
             if self._stop_event.is_set(): break
 
             if height is None or width is None:
                 width, height = self._get_grid_size(target_diff)
             board = generate_kakuro(width=width, height=height, difficulty=target_diff, use_cpp=True)
-            difficulty_estimator = KakuroDifficultyEstimator(board)
-            diff = difficulty_estimator.estimate_difficulty_detailed()
+            if board is None:
+                continue
+            diff = board.difficulty
+            if diff is None:
+                diff = KakuroDifficultyEstimator(board).estimate_difficulty_detailed()
 
             if board and diff:
-                raw_score = diff.score # Assuming C++ returns a float
-              
-                # Convert the C++ difficulty object to a dictionary
-                difficulty_data = {
-                    "rating": diff.rating,
-                    "score": round(diff.score, 2),
-                    "max_tier": int(diff.max_tier),
-                    "total_steps": diff.total_steps,
-                    "uniqueness": diff.uniqueness,
-                    "solution_count": diff.solution_count,
-                    "solve_path": [
-                        {
-                            "technique": step.technique,
-                            "weight": step.difficulty_weight,
-                            "cells": step.cells_affected
-                        } for step in diff.solve_path
-                    ]
-                }
-                # Apply the requested logic: Compare against means
-                final_diff = self._determine_difficulty(raw_score, target_diff, means)
-                
-                tmpl = PuzzleTemplate(
-                    width=board.width,
-                    height=board.height,
-                    difficulty=final_diff,
-                    difficulty_score=raw_score,
-                    difficulty_data=difficulty_data,
-                    grid=board.to_dict(),
-                    times_used=0
-                )
-                db.add(tmpl)
-                
-                # Update the running average for the FINAL difficulty
-                if final_diff not in stats_map:
-                    new_stat = DifficultyStat(difficulty=final_diff, sum_scores=0.0, count=0)
-                    db.add(new_stat)
-                    stats_map[final_diff] = new_stat
-                
-                stat = stats_map[final_diff]
-                stat.sum_scores += raw_score
-                stat.count += 1
-                
-                generated += 1
-        
-        if generated > 0:
-            db.commit()
-            logger.info(f"Saved {generated} puzzles initially targeted as {target_diff}")
+                yield board.width, board.height, diff.score, difficulty_to_dict(diff), board.to_dict(), None
+
+    def _puzzle_candidates(self, puzzle):
+        """Candidates for a unique C++ GeneratedPuzzle and its variants."""
+        if puzzle.difficulty.uniqueness != "Unique":
+            return
+        variants = []
+        if config.PUZZLE_VARIANTS > 0:
+            # Re-estimated, since the score depends on technique order
+            variants = puzzle_variants(puzzle, config.PUZZLE_VARIANTS)
+        for p in [puzzle] + variants:
+            if p.difficulty.uniqueness != "Unique":
+                continue
+            # One native JSON string per puzzle instead of walking the cells
+            data = json.loads(p.to_json())
+            yield p.width, p.height, p.difficulty.score, data["difficulty"], data["grid"], p
 
 
 # Singleton instance
@@ -48,8 +48,11 @@ async def generate_puzzle_endpoint(req: GenerateRequest):
             topo_params=req.topology_params
         )
 
-        difficulty_estimator = KakuroDifficultyEstimator(board)
-        diff  = difficulty_estimator.estimate_difficulty_detailed()
+        # A successful generation already carries its estimate
+        diff = success
+        if not diff:
+            difficulty_estimator = KakuroDifficultyEstimator(board)
+            diff = difficulty_estimator.estimate_difficulty_detailed()
 
         # Convert the C++ difficulty object to a dictionary
         # (Assuming your wrapper exposes these fields)
@@ -243,6 +246,38 @@ def load_log_robust(filepath: str) -> List[Dict]:
         print(f"Error loading log {filepath}: {e}")
         return []
 
+def expand_delta_frames(steps: List[Dict]) -> List[Dict]:
+    """
+    Replays delta-encoded grids into full "wh"/"g"/"b" frames in place.
+    Keyframes carry "wh", "g" and "b"; delta steps carry only the changed
+    cells in "dg" (WHITE with value) and "db" (BLOCK with clues).
+    """
+    width = height = 0
+    cells = {}  # (r, c) -> [r, c, value] for WHITE or [r, c, h, v] for BLOCK
+    for step in steps:
+        if "dg" in step or "db" in step:
+            if not width:
+                continue  # Delta without keyframe (e.g. truncated log)
+            for entry in step.pop("dg", []):
+                cells[(entry[0], entry[1])] = entry
+            for entry in step.pop("db", []):
+                cells[(entry[0], entry[1])] = entry
+        elif step.get("wh") and "g" in step:
+            width, height = step["wh"]
+            cells = {(e[0], e[1]): e for e in step["g"]}
+            for e in step.get("b", []):
+                cells[(e[0], e[1])] = e
+            continue
+        else:
+            continue
+
+        keys = sorted(cells)
+        step["wh"] = [width, height]
+        step["g"] = [cells[k] for k in keys if len(cells[k]) == 3]
+        step["b"] = [cells[k] for k in keys
+                     if len(cells[k]) == 4 and (cells[k][2] > 0 or cells[k][3] > 0)]
+    return steps
+
 def save_log_jsonl(filepath: str, data: list):
     """
     Saves a list of dicts as a JSONL file.
@@ -270,7 +305,7 @@ async def get_log(filename: str, prof: int = 0):
     
     try:
         # 1. Read main file (logic steps)
-        data = load_log_robust(filepath)
+        data = expand_delta_frames(load_log_robust(filepath))
         
         # 2. Optionally read profiling file
         if prof:
@@ -6,6 +6,7 @@ This version integrates with the existing FastAPI backend.
 
 import sys
 import os
+import json
 import logging
 
 logger = logging.getLogger(__name__)
@@ -39,13 +40,17 @@ except ImportError as e:
 class KakuroBoard:
     """Python wrapper for KakuroBoard that provides a familiar interface."""
     
-    def __init__(self, width: int, height: int, use_cpp: bool = True):
+    def __init__(self, width: int, height: int, use_cpp: bool = True, seed: int | None = None):
         self.width = width
         self.height = height
         self.use_cpp = use_cpp and CPP_AVAILABLE
+        self.difficulty = None  # DifficultyResult set by generate_kakuro (C++ only)
         
         if self.use_cpp:
-            self._board = _KakuroBoard(width, height)
+            if seed is not None:
+                self._board = _KakuroBoard(width, height, seed)
+            else:
+                self._board = _KakuroBoard(width, height)
         else:
             # Fallback to pure Python implementation
             try:
@@ -90,7 +95,8 @@ class KakuroBoard:
     def to_dict(self):
         """Export board to dictionary format."""
         if self.use_cpp:
-            return self._board.to_dict()
+            # Native JSON parses faster than converting per-cell string maps
+            return json.loads(self._board.to_json())
         else:
             # Convert Python board to dict
             result = []
@@ -124,11 +130,14 @@ class KakuroBoard:
 class CSPSolver:
     """Python wrapper for CSPSolver."""
     
-    def __init__(self, board: KakuroBoard):
+    def __init__(self, board: KakuroBoard, seed: int | None = None):
         self.board = board
         
         if board.use_cpp:
-            self._solver = _CSPSolver(board._board)
+            if seed is not None:
+                self._solver = _CSPSolver(board._board, seed)
+            else:
+                self._solver = _CSPSolver(board._board)
         else:
             try:
                 from .solver import CSPSolver as PyCSPSolver
@@ -137,9 +146,11 @@ class CSPSolver:
                 from solver import CSPSolver as PyCSPSolver
                 self._solver = PyCSPSolver(board._board)
     
-    def generate_puzzle(self, difficulty: str = "medium", fill_params=None, topo_params=None) -> bool:
+    def generate_puzzle(self, difficulty: str = "medium", fill_params=None, topo_params=None):
         """
         Generate a complete, unique Kakuro puzzle.
+        With C++ this returns the DifficultyResult that validated it, or None
+        on failure; the pure Python solver returns a bool.
         """
         if self.board.use_cpp:
             f_p = fill_params
@@ -165,6 +176,32 @@ class CSPSolver:
             # Python implementation might not support full params yet
             return self._solver.generate_puzzle(difficulty)
     
+    def set_uniqueness_threads(self, threads: int):
+        """Spread the uniqueness search over several threads (C++ only)."""
+        if self.board.use_cpp:
+            self._solver.set_uniqueness_threads(threads)
+
+    def set_fill_portfolio(self, members: int):
+        """Run several fills of each topology concurrently; first valid one wins (C++ only)."""
+        if self.board.use_cpp:
+            self._solver.set_fill_portfolio(members)
+
+    def set_budget(self, budget):
+        """Stop generation when the GenerationBudget is cancelled or expires (C++ only)."""
+        if self.board.use_cpp:
+            self._solver.set_budget(budget)
+
+    def set_topology_pool(self, pool):
+        """Draw topologies from a TopologyPool (from new_topology_pool) first (C++ only)."""
+        if self.board.use_cpp:
+            self._solver.set_topology_pool(pool)
+
+    def last_stats(self) -> dict | None:
+        """Counters and stage times of the last generate_puzzle call (C++ only)."""
+        if self.board.use_cpp:
+            return self._solver.last_stats().to_dict()
+        return None
+
     def solve_fill(self, difficulty: str = "medium", max_nodes: int = 30000) -> bool:
         """Fill the board with valid numbers."""
         return self._solver.solve_fill(difficulty, max_nodes)
@@ -211,16 +248,37 @@ class KakuroDifficultyEstimator:
 
 
 def generate_kakuro(width: int, height: int, difficulty: str = "medium", 
-                   use_cpp: bool = True) -> KakuroBoard:
+                   use_cpp: bool = True, uniqueness_threads: int = 1,
+                   fill_portfolio: int = 1, budget=None,
+                   topology_pool=None) -> KakuroBoard | None:
     """
     Convenience function to generate a complete Kakuro puzzle.
+    uniqueness_threads > 1 parallelizes the uniqueness search and
+    fill_portfolio > 1 races several fills per topology (C++ only).
+    A GenerationBudget (from new_budget) bounds the total time of all retries
+    and can be cancelled from another thread (C++ only); returns None once it
+    has expired.
+    A TopologyPool (from new_topology_pool) serves ready topologies (C++ only).
+    With C++ the returned board's `difficulty` holds its DifficultyResult.
     """
     #print(f"Generating {width}x{height} {difficulty} puzzle (C++={use_cpp})...")
     
-    # Try up to 20 times to get a valid puzzle
+    # Try up to 50 times to get a valid puzzle
+    board = None
     for i in range(50):
+        if budget is not None and budget.expired():
+            logger.info(f"Generation budget expired before a {difficulty} puzzle was found")
+            return None
         board = KakuroBoard(width, height, use_cpp=use_cpp)
         solver = CSPSolver(board)
+        if budget is not None:
+            solver.set_budget(budget)
+        if uniqueness_threads > 1:
+            solver.set_uniqueness_threads(uniqueness_threads)
+        if fill_portfolio > 1:
+            solver.set_fill_portfolio(fill_portfolio)
+        if topology_pool is not None:
+            solver.set_topology_pool(topology_pool)
         
         # Primary attempt
         success = solver.generate_puzzle(difficulty)
@@ -231,9 +289,12 @@ def generate_kakuro(width: int, height: int, difficulty: str = "medium",
             success = solver.generate_puzzle("medium")
             
         if success:
-            # Estimate actual difficulty
-            estimator = KakuroDifficultyEstimator(board)
-            score = estimator.estimate_difficulty_detailed()
+            if board.use_cpp:
+                # The estimator run that validated the fill, not a second one
+                score = success
+            else:
+                estimator = KakuroDifficultyEstimator(board)
+                score = estimator.estimate_difficulty_detailed()
             
             if score.uniqueness != 'Unique':
                 continue 
@@ -248,6 +309,8 @@ def generate_kakuro(width: int, height: int, difficulty: str = "medium",
                 #     print(f"Fallback success: Medium generation produced {score.rating} puzzle!")
 
             #print(f"✓ Generated puzzle successfully. Score: {score} ({type(score)})")
+            if board.use_cpp:
+                board.difficulty = score
             return board
     
     logger.info(f"Failed to generate puzzle with difficulty {difficulty}")
@@ -290,6 +353,205 @@ def generate_random_kakuro(use_cpp: bool = True):
 
 
 
+def new_budget(seconds: float = 0.0):
+    """
+    Creates a C++ GenerationBudget: a deadline `seconds` from now (0 = none)
+    that can also be cancelled from any thread. Requires the C++ module.
+    """
+    if not CPP_AVAILABLE:
+        raise RuntimeError("new_budget requires the C++ module")
+    return kakuro_cpp.GenerationBudget(seconds)
+
+
+def new_topology_pool(per_key: int = 4):
+    """
+    Creates a C++ TopologyPool and starts its producer thread. Each
+    (size, difficulty) a solver asks it for is kept topped up to `per_key`
+    ready topologies. Call stop() on shutdown. Requires the C++ module.
+    """
+    if not CPP_AVAILABLE:
+        raise RuntimeError("new_topology_pool requires the C++ module")
+    pool = kakuro_cpp.TopologyPool(per_key)
+    pool.start()
+    return pool
+
+
+def generate_batch(count: int, difficulty: str, width_range: tuple[int, int],
+                   height_range: tuple[int, int], threads: int = 0,
+                   budget=None) -> list:
+    """
+    Generates up to `count` puzzles on the native worker pool.
+    Returns a list of C++ GeneratedPuzzle objects with difficulty attached.
+    Once `budget` is cancelled or expires, the remaining slots are skipped.
+    Requires the C++ module.
+    """
+    if not CPP_AVAILABLE:
+        raise RuntimeError("generate_batch requires the C++ module")
+
+    fill_params = kakuro_cpp.FillParams()
+    fill_params.difficulty = difficulty
+    topo_params = kakuro_cpp.TopologyParams()
+    topo_params.difficulty = difficulty
+    return kakuro_cpp.generate_batch(count, tuple(width_range), tuple(height_range),
+                                     fill_params, topo_params, threads, budget)
+
+
+def stream_targets(weights: dict[str, float], size_ranges: dict[str, tuple[int, int]]) -> list:
+    """
+    C++ StreamTargets for a PuzzleStream, one per difficulty in `weights`.
+    Both sides of the board are drawn from size_ranges[difficulty] (min, max).
+    Requires the C++ module.
+    """
+    if not CPP_AVAILABLE:
+        raise RuntimeError("stream_targets requires the C++ module")
+    targets = []
+    for difficulty, weight in weights.items():
+        target = kakuro_cpp.StreamTarget()
+        target.width_range = target.height_range = tuple(size_ranges[difficulty])
+        fill_params = kakuro_cpp.FillParams()
+        fill_params.difficulty = difficulty
+        topo_params = kakuro_cpp.TopologyParams()
+        topo_params.difficulty = difficulty
+        target.fill_params = fill_params
+        target.topo_params = topo_params
+        target.weight = float(weight)
+        targets.append(target)
+    return targets
+
+
+def new_puzzle_stream(weights: dict[str, float], size_ranges: dict[str, tuple[int, int]],
+                      capacity: int = 16, threads: int = 0):
+    """
+    Creates and starts a C++ PuzzleStream: native producer threads generate
+    puzzles for the weighted difficulty mix into a queue of at most `capacity`,
+    pausing while it is full. Pop with stream.pop(timeout_ms) or iterate over
+    it for (difficulty, GeneratedPuzzle); both wait with the GIL released.
+    Change the mix with stream.set_targets(stream_targets(...)) and call
+    stop() on shutdown. Requires the C++ module.
+    """
+    if not CPP_AVAILABLE:
+        raise RuntimeError("new_puzzle_stream requires the C++ module")
+    stream = kakuro_cpp.PuzzleStream(stream_targets(weights, size_ranges), capacity, threads)
+    stream.start()
+    return stream
+
+
+def puzzle_variants(puzzle, max_variants: int = 3, reestimate: bool = True) -> list:
+    """
+    Up to `max_variants` distinct copies of a solved C++ GeneratedPuzzle:
+    complemented (v -> 10 - v), transposed and mirrored, with recomputed clues.
+    Uniqueness carries over; the difficulty is estimated again on each copy
+    unless `reestimate` is False. Requires the C++ module.
+    """
+    if not CPP_AVAILABLE:
+        raise RuntimeError("puzzle_variants requires the C++ module")
+    return kakuro_cpp.puzzle_variants(puzzle, max_variants, reestimate)
+
+
+def solve_many(grids, mode: str = "verify", max_solutions: int = 2,
+               threads: int = 0, max_nodes: int = 150000, budget=None) -> list:
+    """
+    Solves many clue grids in one native call with the GIL released.
+    Grids are C++ GridPlanes or uint8 arrays of shape (4, height, width)
+    laid out like to_planes() (type, clue_h, clue_v, solution). `mode` is
+    "solve" (first solution), "count" (up to `max_solutions`) or "verify"
+    (uniqueness, then the solution plane's non-zero entries are checked
+    against the unique solution). Returns one C++ SolveResult per grid.
+    Requires the C++ module.
+    """
+    if not CPP_AVAILABLE:
+        raise RuntimeError("solve_many requires the C++ module")
+    modes = {"solve": kakuro_cpp.SolveMode.SOLVE,
+             "count": kakuro_cpp.SolveMode.COUNT,
+             "verify": kakuro_cpp.SolveMode.VERIFY}
+    if mode not in modes:
+        raise ValueError(f"Unknown solve mode: {mode}")
+    planes = [g if isinstance(g, kakuro_cpp.GridPlanes) else kakuro_cpp.GridPlanes(g)
+              for g in grids]
+    return kakuro_cpp.solve_many(planes, modes[mode], max_solutions, threads,
+                                 max_nodes, budget)
+
+
+def configure_logging(level: str = "full", async_write: bool = False,
+                      buffer_records: int = 8192, drop_on_overflow: bool = False) -> None:
+    """
+    Sets the C++ generation log level ("off", "stage" or "full").
+    With async_write, log files are written by a background thread; records are
+    dropped instead of blocking generation when drop_on_overflow is set and the
+    buffer is full. No-op without the C++ module.
+    """
+    if not CPP_AVAILABLE:
+        return
+    overflow = kakuro_cpp.LogOverflow.DROP if drop_on_overflow else kakuro_cpp.LogOverflow.BLOCK
+    kakuro_cpp.configure_logging(getattr(kakuro_cpp.LogLevel, level.upper()),
+                                 async_write, buffer_records, overflow)
+
+
+def flush_logs() -> None:
+    """Waits until all queued C++ log records are on disk."""
+    if CPP_AVAILABLE:
+        kakuro_cpp.flush_logs()
+
+
+def profile_summary(reset: bool = False) -> list:
+    """
+    Returns the C++ per-scope timings (count, total/mean/min/max ms and a
+    log2-ns histogram), slowest total first. Empty without the C++ module.
+    """
+    if not CPP_AVAILABLE:
+        return []
+    summary = sorted(kakuro_cpp.profile_summary(), key=lambda s: s["total_ms"], reverse=True)
+    if reset:
+        kakuro_cpp.reset_profile()
+    return summary
+
+
+def puzzle_to_dict(puzzle) -> list:
+    """Export a GeneratedPuzzle grid in the same format as KakuroBoard.to_dict()."""
+    return json.loads(puzzle.grid_to_json())
+
+
+def difficulty_to_dict(diff) -> dict:
+    """
+    Rating, score (2 decimals), tier, uniqueness and solve path of a C++
+    DifficultyResult, in the shape stored as PuzzleTemplate.difficulty_data.
+    """
+    return json.loads(diff.to_json())
+
+
+def grid_planes(source):
+    """
+    Cell data of a C++ KakuroBoard wrapper or GeneratedPuzzle as a zero-copy
+    numpy uint8 array of shape (4, height, width): type (0 block, 1 white),
+    clue_h, clue_v and solution, with 0 where absent.
+    """
+    import numpy as np
+    if isinstance(source, KakuroBoard):
+        if not source.use_cpp:
+            raise RuntimeError("grid_planes requires a C++ board")
+        source = source._board
+    return np.asarray(source.to_planes())
+
+
+def open_puzzle_pool(path: str):
+    """
+    Memory-maps a binary puzzle pool file for random picks by difficulty and
+    size. Returns None if the C++ module is missing or the file is not a pool.
+    """
+    if not CPP_AVAILABLE or not os.path.exists(path):
+        return None
+    pool = kakuro_cpp.PuzzlePool()
+    return pool if pool.open(path) else None
+
+
+def open_puzzle_pool_writer(path: str):
+    """Opens (or creates) a pool file for appending; None on failure."""
+    if not CPP_AVAILABLE:
+        return None
+    writer = kakuro_cpp.PuzzlePoolWriter()
+    return writer if writer.open(path) else None
+
+
 def export_to_json(board: KakuroBoard) -> dict:
     """
     Export board to JSON-serializable format.
@@ -197,6 +197,48 @@ def log_generator_status(db: Session):
     except Exception as e:
         logger.warning(f"Could not log generator status: {e}")
 
+def log_generation_stats(db: Session, difficulty: str, stats: Dict[str, Any]):
+    """
+    Records where a generation batch spent its budget, from the summed C++
+    GenerationStats of its puzzles. Times and counts are per puzzle.
+    """
+    try:
+        puzzles = stats.get("puzzles", 0)
+        if not puzzles:
+            return
+        meta = {"difficulty": difficulty, "puzzles": puzzles}
+        for stage in ["topology", "fill", "prefilter", "uniqueness", "difficulty", "repair", "total"]:
+            record_metric(db, f"gen_{difficulty}_{stage}_ms", stats.get(f"{stage}_ms", 0) / puzzles, "ms", meta)
+        for key in ["topology_attempts", "fill_attempts", "repairs",
+                    "failed_fills", "rejected_ambiguity", "rejected_tier", "rejected_refuted",
+                    "rejected_multiple", "rejected_inconclusive", "rejected_estimator"]:
+            record_metric(db, f"gen_{difficulty}_{key}", stats.get(key, 0) / puzzles, "count", meta)
+        # Share of the fills reaching each validation stage that it rejected, in pipeline order
+        reaching = stats.get("fill_attempts", 0)
+        for key in ["failed_fills", "rejected_ambiguity", "rejected_tier", "rejected_refuted",
+                    "rejected_multiple", "rejected_inconclusive", "rejected_estimator"]:
+            rejected = stats.get(key, 0)
+            record_metric(db, f"gen_{difficulty}_{key}_rate", rejected / reaching if reaching else 0.0, "ratio", meta)
+            reaching -= rejected
+        for engine in ["fill", "prefilter", "uniqueness", "estimator"]:
+            record_metric(db, f"gen_{difficulty}_{engine}_nodes", stats.get(f"{engine}_nodes", 0) / puzzles, "nodes", meta)
+    except Exception as e:
+        logger.warning(f"Could not log generation stats: {e}")
+
+def log_profile_summary(db: Session, top: int = 10):
+    """Records the C++ scopes that used the most time since the last call."""
+    try:
+        from .kakuro_wrapper import profile_summary
+        for scope in profile_summary(reset=True)[:top]:
+            record_metric(db, f"cpp_scope_{scope['name']}_ms", scope["total_ms"], "ms", {
+                "count": scope["count"],
+                "mean_ms": scope["mean_ms"],
+                "max_ms": scope["max_ms"],
+                "histogram": scope["histogram"]
+            })
+    except Exception as e:
+        logger.warning(f"Could not log profile summary: {e}")
+
 def log_system_performance(db_session_factory):
     """Utility to be run in a background task to log system performance periodically."""
     metrics = get_system_metrics()
@@ -219,4 +261,7 @@ def log_system_performance(db_session_factory):
         log_puzzle_quality_metrics(db)
 
         # 4. New: Generator State Metrics
-        log_generator_status(db)
\ No newline at end of file
+        log_generator_status(db)
+
+        # 5. Hottest C++ scopes since the last run
+        log_profile_summary(db)
\ No newline at end of file
@@ -118,6 +118,22 @@ class TestPuzzleGeneration:
             # Generation can fail occasionally, that's okay
             pytest.skip(f"Failed to generate {difficulty} puzzle (expected occasionally)")
     
+    def test_generate_puzzle_difficulty_cpp(self):
+        """generate_puzzle returns the estimate a fresh estimator would give"""
+        if not CPP_AVAILABLE:
+            pytest.skip("C++ not available")
+        from python.kakuro_wrapper import KakuroDifficultyEstimator
+
+        board = KakuroBoard(8, 8, use_cpp=True)
+        solver = CSPSolver(board)
+        diff = solver.generate_puzzle("easy")
+        if not diff:
+            pytest.skip("Failed to generate easy puzzle (expected occasionally)")
+
+        assert diff.uniqueness == "Unique"
+        fresh = KakuroDifficultyEstimator(board).estimate_difficulty_detailed()
+        assert (diff.rating, diff.score, diff.total_steps) == (fresh.rating, fresh.score, fresh.total_steps)
+
     @pytest.mark.parametrize("difficulty", ["very_easy", "easy", "medium"])
     def test_generate_puzzle_python(self, difficulty):
         """Test puzzle generation with Python fallback"""
@@ -129,6 +145,218 @@ class TestPuzzleGeneration:
         if not success:
             pytest.skip(f"Failed to generate {difficulty} puzzle (expected occasionally)")
     
+    def test_generate_batch_cpp(self):
+        """Batch generation returns fully clued puzzles within the size range"""
+        if not CPP_AVAILABLE:
+            pytest.skip("C++ not available")
+
+        from python.kakuro_wrapper import generate_batch, puzzle_to_dict
+
+        puzzles = generate_batch(4, "very_easy", (6, 8), (6, 8), threads=2)
+        assert len(puzzles) <= 4
+
+        for puzzle in puzzles:
+            assert 6 <= puzzle.width <= 8
+            assert 6 <= puzzle.height <= 8
+            assert puzzle.difficulty.rating
+            grid = puzzle_to_dict(puzzle)
+            assert len(grid) == puzzle.height
+            assert all(len(row) == puzzle.width for row in grid)
+
+    def test_puzzle_stream_cpp(self):
+        """The stream yields puzzles for its mix, stays within capacity and ends on stop"""
+        if not CPP_AVAILABLE:
+            pytest.skip("C++ not available")
+        import time
+        from python.kakuro_wrapper import new_puzzle_stream
+
+        stream = new_puzzle_stream({"very_easy": 1}, {"very_easy": (6, 7)}, capacity=2, threads=1)
+        try:
+            item = stream.pop(60000)
+            assert item is not None
+            difficulty, puzzle = item
+            assert difficulty == "very_easy"
+            assert 6 <= puzzle.width <= 7 and 6 <= puzzle.height <= 7
+
+            time.sleep(0.5)
+            assert len(stream) <= stream.capacity
+            assert stream.count("very_easy") == len(stream)
+            assert stream.pop(0, difficulty="hard") is None
+        finally:
+            stream.stop()
+        assert not stream.running()
+        assert len(list(stream)) <= 2
+
+    def test_native_export_cpp(self):
+        """Native JSON and uint8 planes agree with the per-cell export"""
+        if not CPP_AVAILABLE:
+            pytest.skip("C++ not available")
+
+        import json
+        from python.kakuro_wrapper import generate_batch, grid_planes
+
+        puzzles = generate_batch(1, "very_easy", (6, 6), (6, 6), threads=1)
+        if not puzzles:
+            pytest.skip("Failed to generate puzzle (expected occasionally)")
+        puzzle = puzzles[0]
+
+        data = json.loads(puzzle.to_json())
+        assert data["difficulty"]["rating"] == puzzle.difficulty.rating
+        assert data["difficulty"]["score"] == round(puzzle.difficulty.score, 2)
+        assert len(data["difficulty"]["solve_path"]) == len(puzzle.difficulty.solve_path)
+
+        planes = grid_planes(puzzle)
+        assert planes.shape == (4, puzzle.height, puzzle.width)
+        for r, row in enumerate(data["grid"]):
+            for c, cell in enumerate(row):
+                assert planes[0, r, c] == (1 if cell["type"] == "WHITE" else 0)
+                assert planes[1, r, c] == int(cell.get("clue_h", 0))
+                assert planes[2, r, c] == int(cell.get("clue_v", 0))
+                assert planes[3, r, c] == int(cell.get("value", 0))
+
+    def test_binary_pool_cpp(self, tmp_path):
+        """Binary encoding round-trips and the pool file serves random picks"""
+        if not CPP_AVAILABLE:
+            pytest.skip("C++ not available")
+
+        import kakuro_cpp
+        from python.kakuro_wrapper import generate_batch, puzzle_to_dict, open_puzzle_pool, open_puzzle_pool_writer
+
+        puzzles = generate_batch(2, "very_easy", (6, 6), (6, 6), threads=1)
+        if not puzzles:
+            pytest.skip("Failed to generate puzzle (expected occasionally)")
+
+        data = kakuro_cpp.encode_puzzle(puzzles[0])
+        decoded = kakuro_cpp.decode_puzzle(data)
+        assert puzzle_to_dict(decoded) == puzzle_to_dict(puzzles[0])
+        assert kakuro_cpp.decode_puzzle(data[:-1]) is None
+
+        path = str(tmp_path / "pool.kkp")
+        writer = open_puzzle_pool_writer(path)
+        for puzzle in puzzles:
+            assert writer.append(puzzle, "very_easy")
+        writer.close()
+
+        pool = open_puzzle_pool(path)
+        assert len(pool) == len(puzzles)
+        assert pool.count("very_easy", 6, 6) == len(puzzles)
+        assert pool.random_puzzle("hard") is None
+        picked = pool.random_puzzle("very_easy", 6, 6)
+        assert picked.width == 6 and picked.height == 6
+
+    def test_generation_stats_cpp(self):
+        """generate_puzzle reports attempts, rejections and stage times"""
+        if not CPP_AVAILABLE:
+            pytest.skip("C++ not available")
+
+        board = KakuroBoard(8, 8, use_cpp=True)
+        solver = CSPSolver(board)
+        success = solver.generate_puzzle("very_easy")
+        stats = solver.last_stats()
+
+        assert stats["topology_attempts"] >= 1
+        assert stats["total_ms"] > 0
+        if success:
+            rejected = (stats["failed_fills"] + stats["rejected_ambiguity"] + stats["rejected_tier"]
+                        + stats["rejected_refuted"] + stats["rejected_multiple"]
+                        + stats["rejected_inconclusive"] + stats["rejected_estimator"])
+            assert rejected < stats["fill_attempts"]
+            assert stats["fill_nodes"] > 0
+
+    def test_topology_pool_cpp(self):
+        """A started pool fills the requested key and serves the next generation"""
+        if not CPP_AVAILABLE:
+            pytest.skip("C++ not available")
+
+        import time
+        import kakuro_cpp
+        from python.kakuro_wrapper import new_topology_pool
+
+        pool = new_topology_pool(2)
+        try:
+            board = KakuroBoard(8, 8, use_cpp=True)
+            solver = CSPSolver(board)
+            solver.set_topology_pool(pool)
+            solver.generate_puzzle("very_easy")  # Requests the key
+
+            params = kakuro_cpp.TopologyParams()
+            params.difficulty = "very_easy"
+            deadline = time.time() + 10
+            while pool.ready(8, 8, params) == 0 and time.time() < deadline:
+                time.sleep(0.05)
+            assert pool.ready(8, 8, params) > 0
+
+            solver.generate_puzzle("very_easy")
+            assert solver.last_stats()["pooled_topologies"] >= 1
+        finally:
+            pool.stop()
+
+    def test_puzzle_variants_cpp(self):
+        """Variants are distinct, stay unique and keep the rating when carried over"""
+        if not CPP_AVAILABLE:
+            pytest.skip("C++ not available")
+        import json
+        from python.kakuro_wrapper import generate_batch, puzzle_variants, puzzle_to_dict
+
+        puzzles = generate_batch(1, "easy", (7, 7), (9, 9), threads=1)
+        assert puzzles
+        puzzle = puzzles[0]
+
+        variants = puzzle_variants(puzzle, 3, reestimate=False)
+        assert variants
+        grids = [puzzle_to_dict(p) for p in [puzzle] + variants]
+        assert len({json.dumps(g) for g in grids}) == len(grids)
+        for v in variants:
+            assert v.difficulty.rating == puzzle.difficulty.rating
+            assert v.difficulty.uniqueness == puzzle.difficulty.uniqueness
+            assert {(v.width, v.height)} <= {(7, 9), (9, 7)}
+
+    def test_solve_many_cpp(self):
+        """Batch solving recovers generated solutions and checks player entries"""
+        if not CPP_AVAILABLE:
+            pytest.skip("C++ not available")
+        from python.kakuro_wrapper import generate_batch, grid_planes, solve_many
+
+        puzzles = generate_batch(2, "easy", (7, 7), (7, 7), threads=1)
+        assert puzzles
+        grids = [grid_planes(p).copy() for p in puzzles]
+
+        for grid, result in zip(grids, solve_many(grids, "count", max_solutions=3)):
+            assert result.valid and not result.exhausted
+            assert result.solution_count == 1
+            assert result.solution == grid[3].tobytes()
+
+        # Keep one right entry and one wrong one
+        grid = grids[0]
+        white = list(zip(*(grid[0] == 1).nonzero()))
+        (r0, c0), (r1, c1) = white[0], white[1]
+        right, wrong = int(grid[3, r0, c0]), int(grid[3, r1, c1]) % 9 + 1
+        grid[3] = 0
+        grid[3, r0, c0], grid[3, r1, c1] = right, wrong
+        result = solve_many([grid], "verify")[0]
+        assert result.checked and not result.solved
+        assert result.wrong_cells == [(r1, c1)]
+
+        # A run without a clue is not a puzzle
+        grid[1] = 0
+        assert not solve_many([grid], "solve")[0].valid
+
+    def test_cancelled_budget_cpp(self):
+        """A cancelled budget stops generation before any work is done"""
+        if not CPP_AVAILABLE:
+            pytest.skip("C++ not available")
+        from python.kakuro_wrapper import new_budget
+
+        budget = new_budget()
+        budget.cancel()
+        assert budget.expired()
+
+        board = KakuroBoard(8, 8, use_cpp=True)
+        solver = CSPSolver(board)
+        solver.set_budget(budget)
+        assert not solver.generate_puzzle("very_easy")
+        assert solver.last_stats()["fill_attempts"] == 0
+
     def test_quick_easy_puzzle(self):
         """Quick test with smaller board"""
         board = KakuroBoard(6, 6, use_cpp=CPP_AVAILABLE)